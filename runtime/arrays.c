@@ -56,19 +56,13 @@ ht_find (HashTable * ht, zval * ind, zval *** data)
     {
       // TODO: I believe this might need a warning.
 
-      // TODO avoid alloc
       // use a string index for other types
-      zval *string_index;
-      MAKE_STD_ZVAL (string_index);
-      string_index->value = ind->value;
-      string_index->type = ind->type;
-      zval_copy_ctor (string_index);
-      convert_to_string (string_index);
-
+      zval tmp;
+      zval *string_index = get_string_val (ind, &tmp);
       result = zend_symtable_find (ht, Z_STRVAL_P (string_index),
 				   Z_STRLEN_P (string_index) + 1,
 				   (void **) data);
-      zval_ptr_dtor (&string_index);
+      free_string_val (string_index, &tmp);
     }
   return result;
 }
@@ -114,18 +108,12 @@ ht_update (HashTable * ht, zval * ind, zval * val, zval *** dest)
     }
   else
     {
-      // TODO avoid alloc
-      zval *string_index;
-      MAKE_STD_ZVAL (string_index);
-      string_index->value = ind->value;
-      string_index->type = ind->type;
-      zval_copy_ctor (string_index);
-      convert_to_string (string_index);
+      zval tmp;
+      zval *string_index = get_string_val (ind, &tmp);
       result = zend_symtable_update (ht, Z_STRVAL_P (string_index),
 				     Z_STRLEN_P (string_index) + 1,
 				     &val, sizeof (zval *), (void **) dest);
-
-      zval_ptr_dtor (&string_index);
+      free_string_val (string_index, &tmp);
     }
   assert (result == SUCCESS);
 }
@@ -153,17 +141,11 @@ ht_delete (HashTable * ht, zval * ind)
     }
   else
     {
-      // TODO avoid alloc
-      zval *string_index;
-      MAKE_STD_ZVAL (string_index);
-      string_index->value = ind->value;
-      string_index->type = ind->type;
-      zval_copy_ctor (string_index);
-      convert_to_string (string_index);
+      zval tmp;
+      zval *string_index = get_string_val (ind, &tmp);
       zend_hash_del (ht, Z_STRVAL_P (string_index),
 		     Z_STRLEN_P (string_index) + 1);
-
-      zval_ptr_dtor (&string_index);
+      free_string_val (string_index, &tmp);
     }
 }
 
@@ -189,24 +171,59 @@ ht_exists (HashTable * ht, zval * ind)
     }
   else
     {
-      // TODO avoid alloc
       int result;
-      zval *string_index;
-      MAKE_STD_ZVAL (string_index);
-      string_index->value = ind->value;
-      string_index->type = ind->type;
-      zval_copy_ctor (string_index);
-      convert_to_string (string_index);
+      zval tmp;
+      zval *string_index = get_string_val (ind, &tmp);
       result = zend_hash_exists (ht, Z_STRVAL_P (string_index),
 				 Z_STRLEN_P (string_index) + 1);
-      zval_ptr_dtor (&string_index);
+      free_string_val (string_index, &tmp);
       return result;
     }
   assert (0);
 }
 
-static zval **
-get_ht_entry (zval ** p_var, zval * ind TSRMLS_DC)
+/* A string literal used as an array key. The compiler works out its hash, or
+ * its integer value if PHP treats it as an integer key, so that accessing the
+ * array doesnt need to. */
+typedef struct
+{
+  char *key;
+  uint key_len;
+  ulong hash;
+  int is_numeric;
+  long index;
+} phc_key;
+
+// Like ht_find, but using a precomputed key
+static int
+ht_find_key (HashTable * ht, const phc_key * key, zval *** data)
+{
+  if (key->is_numeric)
+    return zend_hash_index_find (ht, key->index, (void **) data);
+
+  return zend_hash_quick_find (ht, key->key, key->key_len, key->hash,
+			       (void **) data);
+}
+
+// Like ht_update, but using a precomputed key
+static void
+ht_update_key (HashTable * ht, const phc_key * key, zval * val,
+	       zval *** dest)
+{
+  int result;
+  if (key->is_numeric)
+    result = zend_hash_index_update (ht, key->index, &val, sizeof (zval *),
+				     (void **) dest);
+  else
+    result = zend_hash_quick_update (ht, key->key, key->key_len, key->hash,
+				     &val, sizeof (zval *), (void **) dest);
+  assert (result == SUCCESS);
+}
+
+/* Prepare *P_VAR to have an entry fetched from it, converting it into an
+ * array if necessary. */
+static HashTable *
+extract_ht_for_entry (zval ** p_var TSRMLS_DC)
 {
   if (Z_TYPE_P (*p_var) == IS_STRING)
     {
@@ -224,7 +241,13 @@ get_ht_entry (zval ** p_var, zval * ind TSRMLS_DC)
       array_init (*p_var);
     }
 
-  HashTable *ht = extract_ht (p_var TSRMLS_CC);
+  return extract_ht (p_var TSRMLS_CC);
+}
+
+static zval **
+get_ht_entry (zval ** p_var, zval * ind TSRMLS_DC)
+{
+  HashTable *ht = extract_ht_for_entry (p_var TSRMLS_CC);
 
   zval **data;
   if (ht_find (ht, ind, &data) == SUCCESS)
@@ -243,6 +266,26 @@ get_ht_entry (zval ** p_var, zval * ind TSRMLS_DC)
   return data;
 }
 
+// Like get_ht_entry, but using a precomputed key
+static zval **
+get_ht_entry_key (zval ** p_var, const phc_key * key TSRMLS_DC)
+{
+  HashTable *ht = extract_ht_for_entry (p_var TSRMLS_CC);
+
+  zval **data;
+  if (ht_find_key (ht, key, &data) == SUCCESS)
+    {
+      assert (data != NULL);
+      return data;
+    }
+
+  Z_ADDREF_P(EG(uninitialized_zval_ptr));
+  ht_update_key (ht, key, EG (uninitialized_zval_ptr), &data);
+
+  assert (data != NULL);
+
+  return data;
+}
 
 // Like extract_ht_ex, but for objects 
 static HashTable *
@@ -332,6 +375,26 @@ read_array (zval ** result, zval * array, zval * ind TSRMLS_DC)
   *result = EG (uninitialized_zval_ptr);
 }
 
+// Like read_array, but using a precomputed key
+void
+read_array_key (zval ** result, zval * array, const phc_key * key TSRMLS_DC)
+{
+  if (array == EG (uninitialized_zval_ptr))
+    {
+      *result = array;
+      return;
+    }
+
+  zval **p_result;
+  if (ht_find_key (Z_ARRVAL_P (array), key, &p_result) == SUCCESS)
+    {
+      *result = *p_result;
+      return;
+    }
+
+  *result = EG (uninitialized_zval_ptr);
+}
+
 /* If its not an array, convert it into an array. */
 static void
 check_array_type (zval ** p_var TSRMLS_DC)
@@ -424,3 +487,197 @@ push_and_index_ht (zval ** p_var TSRMLS_DC)
 
   return data;
 }
+
+/*
+ * Packed arrays. Local arrays which are only appended to and indexed by
+ * dense integers can be kept in a phc_vector, a contiguous list of zval*s,
+ * instead of a HashTable. Like zvals, vectors are shared until they are
+ * written to. Using the array in any other way converts it to a HashTable,
+ * which is kept in the variable's zval from then on.
+ */
+typedef struct
+{
+  int refcount;
+  long size;
+  long capacity;
+  zval **data;
+} phc_vector;
+
+static phc_vector *
+phc_vector_new (long capacity)
+{
+  phc_vector *vector = emalloc (sizeof (phc_vector));
+  vector->refcount = 1;
+  vector->size = 0;
+  vector->capacity = capacity > 8 ? capacity : 8;
+  vector->data = emalloc (vector->capacity * sizeof (zval *));
+  return vector;
+}
+
+static void
+phc_vector_release (phc_vector * vector)
+{
+  long i;
+
+  if (--vector->refcount > 0)
+    return;
+
+  for (i = 0; i < vector->size; i++)
+    zval_ptr_dtor (&vector->data[i]);
+
+  efree (vector->data);
+  efree (vector);
+}
+
+/* Make *P_VECTOR an empty vector, with room for CAPACITY elements. */
+static void
+phc_vector_init (phc_vector ** p_vector, long capacity)
+{
+  if (*p_vector != NULL)
+    phc_vector_release (*p_vector);
+
+  *p_vector = phc_vector_new (capacity);
+}
+
+/* Share RHS with *P_LHS. */
+static void
+phc_vector_assign (phc_vector ** p_lhs, phc_vector * rhs)
+{
+  rhs->refcount++;
+
+  if (*p_lhs != NULL)
+    phc_vector_release (*p_lhs);
+
+  *p_lhs = rhs;
+}
+
+/* Copy *P_VECTOR if it is shared, so that it can be written. */
+static void
+phc_vector_separate (phc_vector ** p_vector)
+{
+  phc_vector *old = *p_vector;
+  phc_vector *copy;
+  long i;
+
+  if (old->refcount == 1)
+    return;
+
+  copy = phc_vector_new (old->size);
+  for (i = 0; i < old->size; i++)
+    {
+      copy->data[i] = old->data[i];
+      Z_ADDREF_P (copy->data[i]);
+    }
+  copy->size = old->size;
+
+  old->refcount--;
+  *p_vector = copy;
+}
+
+/* Elements are never references, as taking a reference to one converts the
+ * vector. */
+static void
+phc_vector_push (phc_vector ** p_vector, zval * rhs)
+{
+  phc_vector *vector;
+
+  phc_vector_separate (p_vector);
+  vector = *p_vector;
+
+  if (vector->size == vector->capacity)
+    {
+      vector->capacity *= 2;
+      vector->data =
+	erealloc (vector->data, vector->capacity * sizeof (zval *));
+    }
+
+  if (Z_ISREF_P (rhs))
+    rhs = zvp_clone_ex (rhs);
+  else
+    Z_ADDREF_P (rhs);
+
+  vector->data[vector->size++] = rhs;
+}
+
+/* INDEX can be written without converting the vector if it is an element,
+ * or the next element to be appended. */
+static int
+phc_vector_can_write (phc_vector * vector, zval * index)
+{
+  return Z_TYPE_P (index) == IS_LONG
+    && Z_LVAL_P (index) >= 0 && Z_LVAL_P (index) <= vector->size;
+}
+
+static void
+phc_vector_write (phc_vector ** p_vector, long index, zval * rhs)
+{
+  zval **p_lhs;
+
+  if (index == (*p_vector)->size)
+    {
+      phc_vector_push (p_vector, rhs);
+      return;
+    }
+
+  phc_vector_separate (p_vector);
+  p_lhs = &(*p_vector)->data[index];
+  if (*p_lhs != rhs)
+    write_var (p_lhs, rhs);
+}
+
+/* INDEX can be read without converting the vector if it is an element. */
+static int
+phc_vector_can_read (phc_vector * vector, zval * index)
+{
+  return Z_TYPE_P (index) == IS_LONG
+    && Z_LVAL_P (index) >= 0 && Z_LVAL_P (index) < vector->size;
+}
+
+/* If the array is a vector, convert it to a HashTable in *P_ZVP, which
+ * isnt used while there is a vector. */
+static void
+phc_vector_to_array (phc_vector ** p_vector, zval ** p_zvp TSRMLS_DC)
+{
+  phc_vector *vector = *p_vector;
+  HashTable *ht;
+  long i;
+
+  if (vector == NULL)
+    return;
+
+  assert (*p_zvp == NULL);
+  ALLOC_INIT_ZVAL (*p_zvp);
+  array_init_size (*p_zvp, vector->size);
+  ht = Z_ARRVAL_PP (p_zvp);
+
+  for (i = 0; i < vector->size; i++)
+    {
+      /* If nothing else shares the vector, the elements' references move to
+       * the HashTable. */
+      if (vector->refcount > 1)
+	Z_ADDREF_P (vector->data[i]);
+
+      zend_hash_next_index_insert (ht, &vector->data[i], sizeof (zval *),
+				   NULL);
+    }
+
+  if (vector->refcount > 1)
+    vector->refcount--;
+  else
+    {
+      efree (vector->data);
+      efree (vector);
+    }
+
+  *p_vector = NULL;
+}
+
+/* A vector converted during a foreach loop leaves its iterator at INDEX.
+ * Point the HashTable iterator POS at the same element. */
+static void
+phc_vector_seek (zval * array, HashPosition * pos, long index)
+{
+  zend_hash_internal_pointer_reset_ex (Z_ARRVAL_P (array), pos);
+  while (index-- > 0)
+    zend_hash_move_forward_ex (Z_ARRVAL_P (array), pos);
+}
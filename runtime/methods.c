@@ -78,6 +78,46 @@ phc_setup_error (int init, char *filename, int line_number,
     }
 }
 
+/*
+ * Set the error location for a call. User error handlers are passed the
+ * location by zend_error, rather than through zend_error_cb, so when one is
+ * set we use phc_setup_error instead.
+ */
+typedef struct
+{
+  phc_location *location;
+  zend_bool in_execution;
+  int setup_error;
+} phc_location_state;
+
+static void
+phc_enter_location (phc_location_state * state,
+		    phc_location * location TSRMLS_DC)
+{
+  state->location = phc_current_location;
+  state->in_execution = EG (in_execution);
+  state->setup_error = (EG (user_error_handler) != NULL);
+
+  phc_current_location = location;
+
+  // Errors are prefixed with the function name only while executing.
+  EG (in_execution) = 1;
+
+  if (state->setup_error)
+    phc_setup_error (1, location->filename, location->line_number, NULL
+		     TSRMLS_CC);
+}
+
+static void
+phc_leave_location (phc_location_state * state TSRMLS_DC)
+{
+  if (state->setup_error)
+    phc_setup_error (0, NULL, 0, NULL TSRMLS_CC);
+
+  phc_current_location = state->location;
+  EG (in_execution) = state->in_execution;
+}
+
 static void
 initialize_function_call (zend_fcall_info * fci, zend_fcall_info_cache * fcic,
 			  char *function_name, char *filename,
@@ -107,7 +147,145 @@ destroy_function_call (zend_fcall_info * fci)
 }
 
 /*
- * Initialize zend_fcall_info for a method lookup
+ * Direct calls. Functions compiled into this module can be called without
+ * zend_call_function. The arguments are passed as zend_call_function would
+ * pass them, and the callee runs with the scope and function name
+ * zend_call_function would give it. Like zend_call_function, we push a frame
+ * holding the function and its arguments, so that backtraces, and the traces
+ * of exceptions thrown below the callee, include it.
+ */
+typedef struct
+{
+  zend_class_entry *scope;
+  zval *object;
+  zend_execute_data execute_data;
+} phc_direct_call_state;
+
+static void
+phc_begin_direct_call (phc_direct_call_state * state, zval *** args_ind,
+		       int *by_ref, int arg_count, zval ** params,
+		       zend_function * function TSRMLS_DC)
+{
+  int i;
+  for (i = 0; i < arg_count; i++)
+    {
+      zval **p_arg = args_ind[i];
+      if (by_ref[i] && (Z_ISREF_PP (p_arg) || Z_REFCOUNT_PP (p_arg) == 1))
+	{
+	  Z_ADDREF_PP (p_arg);
+	  Z_SET_ISREF_PP (p_arg);
+	  params[i] = *p_arg;
+	}
+      else if (*p_arg != &EG (uninitialized_zval))
+	{
+	  Z_ADDREF_PP (p_arg);
+	  params[i] = *p_arg;
+	}
+      else
+	{
+	  ALLOC_ZVAL (params[i]);
+	  *params[i] = **p_arg;
+	  INIT_PZVAL (params[i]);
+	}
+    }
+
+  // The arguments go on the engine's stack as zend_call_function leaves
+  // them: the arguments, then their count. The stack holds the references
+  // taken above, and drops them when the frame is popped.
+#if PHP_VERSION_ID < 50300
+  for (i = 0; i < arg_count; i++)
+    zend_ptr_stack_push (&EG (argument_stack), params[i]);
+  zend_ptr_stack_2_push (&EG (argument_stack),
+			 (void *) (zend_uintptr_t) arg_count, NULL);
+#else
+  ZEND_VM_STACK_GROW_IF_NEEDED (arg_count + 1);
+  for (i = 0; i < arg_count; i++)
+    zend_vm_stack_push_nocheck (params[i] TSRMLS_CC);
+#endif
+
+  if (EG (current_execute_data))
+    {
+      state->execute_data = *EG (current_execute_data);
+      state->execute_data.op_array = NULL;
+      state->execute_data.opline = NULL;
+      state->execute_data.object = NULL;
+    }
+  else
+    memset (&state->execute_data, 0, sizeof (zend_execute_data));
+
+  state->execute_data.function_state.function = function;
+#if PHP_VERSION_ID >= 50300
+  state->execute_data.function_state.arguments = zend_vm_stack_top (TSRMLS_C);
+  zend_vm_stack_push_nocheck ((void *) (zend_uintptr_t) arg_count TSRMLS_CC);
+#endif
+  state->execute_data.prev_execute_data = EG (current_execute_data);
+  EG (current_execute_data) = &state->execute_data;
+
+  state->scope = EG (scope);
+  state->object = EG (This);
+
+  EG (scope) = NULL;
+  EG (This) = NULL;
+}
+
+static void
+phc_end_direct_call (phc_direct_call_state * state TSRMLS_DC)
+{
+  EG (current_execute_data) = state->execute_data.prev_execute_data;
+
+#if PHP_VERSION_ID < 50300
+  zend_ptr_stack_clear_multiple (TSRMLS_C);
+#elif PHP_VERSION_ID < 50400
+  zend_vm_stack_clear_multiple (TSRMLS_C);
+#else
+  zend_vm_stack_clear_multiple (0 TSRMLS_CC);
+#endif
+
+  EG (scope) = state->scope;
+  EG (This) = state->object;
+}
+
+/*
+ * Function caches. A variable function call site keeps the last function it
+ * called, so it only looks the function up when the name changes.
+ */
+typedef struct
+{
+  zend_fcall_info fci;
+  zend_fcall_info_cache fcic;
+} phc_function_cache;
+
+static void
+initialize_cached_function_call (zend_fcall_info * fci,
+				 zend_fcall_info_cache * fcic, zval * fn,
+				 phc_function_cache * cache, char *filename,
+				 int line_number TSRMLS_DC)
+{
+  if (Z_TYPE_P (fn) != IS_STRING)
+    {
+      phc_setup_error (1, filename, line_number, NULL TSRMLS_CC);
+      php_error_docref (NULL TSRMLS_CC, E_ERROR,
+			"Function name must be a string");
+    }
+
+  zval *cached_name = cache->fci.function_name;
+  if (!cache->fcic.initialized
+      || zend_binary_strcasecmp (Z_STRVAL_P (cached_name),
+				 Z_STRLEN_P (cached_name), Z_STRVAL_P (fn),
+				 Z_STRLEN_P (fn)) != 0)
+    {
+      destroy_function_call (&cache->fci);
+      memset (cache, 0, sizeof (*cache));
+      initialize_function_call (&cache->fci, &cache->fcic, Z_STRVAL_P (fn),
+				filename, line_number TSRMLS_CC);
+    }
+
+  /* The call saves and restores the fci's parameters, so a recursive call
+   * through the same site must not share it. */
+  *fci = cache->fci;
+  *fcic = cache->fcic;
+}
+
  *
  * Implementation partly based on zend_call_method in Zend/zend_interfaces.c
  * Main difference is that we use Z_OBJ_HTT_PP(obj)->get_method to retrieve
@@ -158,6 +336,66 @@ initialize_method_call (zend_fcall_info * fci, zend_fcall_info_cache * fcic,
     }
 }
 
+/*
+ * Method caches. A call site whose receiver can only be an object of one of a
+ * few classes keeps the method it found for each class, so it only looks the
+ * method up once per class.
+ */
+typedef struct
+{
+  zend_class_entry *ce;
+  zend_function *function_handler;
+} phc_method_cache;
+
+static void
+initialize_cached_method_call (zend_fcall_info * fci,
+			       zend_fcall_info_cache * fcic, zval ** obj,
+			       char *function_name, phc_method_cache * cache,
+			       int cache_size, char *filename,
+			       int line_number TSRMLS_DC)
+{
+  zend_class_entry *obj_ce = Z_OBJCE_PP (obj);
+  int i;
+
+  for (i = 0; i < cache_size && cache[i].ce != NULL; i++)
+    {
+      if (cache[i].ce == obj_ce)
+	{
+	  fci->size = sizeof (*fci);
+	  Z_SET_OBJECT_PTR (fci, obj);
+	  fci->no_separation = 1;
+	  fci->symbol_table = NULL;
+
+	  fcic->initialized = 1;
+	  fcic->calling_scope = obj_ce;
+	  Z_SET_OBJECT_PTR (fcic, obj);
+	  fcic->function_handler = cache[i].function_handler;
+	  return;
+	}
+    }
+
+  initialize_method_call (fci, fcic, obj, function_name, filename,
+			  line_number TSRMLS_CC);
+
+  /* Objects with their own get_method may find different methods for
+   * different objects of the same class, and methods found through __call
+   * are created for each call. */
+  if (Z_OBJ_HT_PP (obj)->get_method != std_object_handlers.get_method
+      || fcic->function_handler->type == ZEND_OVERLOADED_FUNCTION)
+    return;
+#ifdef ZEND_ACC_CALL_VIA_HANDLER
+  if (fcic->function_handler->common.fn_flags & ZEND_ACC_CALL_VIA_HANDLER)
+    return;
+#endif
+
+  /* When the cache is full, replace the last entry. */
+  if (i == cache_size)
+    i--;
+
+  cache[i].ce = obj_ce;
+  cache[i].function_handler = fcic->function_handler;
+}
+
 /*
  * Like initialize_method_call, but return 0 if no constructor is defined
  * rather than giving an error.
@@ -0,0 +1,59 @@
+/*
+ * Type-specialized operators. The generated code only uses these when the
+ * optimizer has proved the types of the operands, so they dont need to check
+ * or convert them. The results are the same as the Zend operators'.
+ */
+
+#include "zend_multiply.h"
+
+/* Prepare *P_LHS to be overwritten with the result of an operator. The
+ * operands must already have been read, as *P_LHS may be one of them. */
+static inline void
+prepare_lhs_for_result (zval ** p_lhs)
+{
+  if (in_copy_on_write (*p_lhs))
+    {
+      zval_ptr_dtor (p_lhs);
+      ALLOC_INIT_ZVAL (*p_lhs);
+    }
+  else
+    zval_dtor (*p_lhs);
+}
+
+/* Integer arithmetic, which overflows into a double. */
+static inline void
+long_add_function (zval * result, long l1, long l2)
+{
+  long lval = (long) ((unsigned long) l1 + (unsigned long) l2);
+
+  if ((l1 ^ l2) >= 0 && (l1 ^ lval) < 0)
+    ZVAL_DOUBLE (result, (double) l1 + (double) l2);
+  else
+    ZVAL_LONG (result, lval);
+}
+
+static inline void
+long_sub_function (zval * result, long l1, long l2)
+{
+  long lval = (long) ((unsigned long) l1 - (unsigned long) l2);
+
+  if ((l1 ^ l2) < 0 && (l1 ^ lval) < 0)
+    ZVAL_DOUBLE (result, (double) l1 - (double) l2);
+  else
+    ZVAL_LONG (result, lval);
+}
+
+static inline void
+long_mul_function (zval * result, long l1, long l2)
+{
+  long lval;
+  double dval;
+  int use_dval;
+
+  ZEND_SIGNED_MULTIPLY_LONG (l1, l2, lval, dval, use_dval);
+
+  if (use_dval)
+    ZVAL_DOUBLE (result, dval);
+  else
+    ZVAL_LONG (result, lval);
+}
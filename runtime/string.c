@@ -1,3 +1,39 @@
+/*
+ * If the parameter is a string, returns the parameter. If its not a string,
+ * it is converted into TMP, a zval on the caller's stack, which is returned.
+ * Either way, free_string_val must be run by the caller on the return value.
+ */
+zval *
+get_string_val (zval * zvp, zval * tmp)
+{
+  if (Z_TYPE_P (zvp) == IS_STRING)
+    return zvp;
+
+  if (Z_TYPE_P (zvp) == IS_OBJECT)
+    {
+      // __toString can keep a reference to the zval it is called on, so
+      // that must be on the heap.
+      zval *clone = zvp_clone_ex (zvp);
+      convert_to_string (clone);
+      INIT_ZVAL (*tmp);
+      ZVAL_STRINGL (tmp, Z_STRVAL_P (clone), Z_STRLEN_P (clone), 1);
+      zval_ptr_dtor (&clone);
+      return tmp;
+    }
+
+  *tmp = *zvp;
+  zval_copy_ctor (tmp);
+  convert_to_string (tmp);
+  return tmp;
+}
+
+void
+free_string_val (zval * str, zval * tmp)
+{
+  if (str == tmp)
+    zval_dtor (tmp);
+}
+
 static long
 get_integer_index (zval * ind TSRMLS_DC)
 {
@@ -19,15 +55,25 @@ get_integer_index (zval * ind TSRMLS_DC)
     }
 }
 
+/* Returns a string of the character at IND in VAR, which the caller must free
+ * with zval_ptr_dtor. Outside threaded builds, this is a shared string with a
+ * new reference, rather than a new allocation. */
 static zval *
 read_string_index (zval * var, zval * ind TSRMLS_DC)
 {
-  // This must always allocate memory, since we cant return the
-  // passed string.
   assert (Z_TYPE_P (var) == IS_STRING);
   long index = get_integer_index (ind TSRMLS_CC);
 
   zval *result;
+
+#ifndef ZTS
+  if (index >= Z_STRLEN_P (var) || index < 0)
+    result = &phc_empty_string;
+  else
+    result = &phc_char_strings[(unsigned char) Z_STRVAL_P (var)[index]];
+
+  Z_ADDREF_P (result);
+#else
   ALLOC_INIT_ZVAL (result);
 
   if (index >= Z_STRLEN_P (var) || index < 0)
@@ -40,10 +86,50 @@ read_string_index (zval * var, zval * ind TSRMLS_DC)
       char *string = Z_STRVAL_P (var);
       ZVAL_STRINGL (result, &string[index], 1, 1);
     }
+#endif
 
   return result;
 }
 
+/* The first character of RHS, converted to a string. Scalars are converted
+ * into a buffer on the stack. */
+static char
+get_first_char (zval * rhs TSRMLS_DC)
+{
+  char buf[MAX_LENGTH_OF_DOUBLE + 1];
+  char result;
+  zval copy;
+
+  switch (Z_TYPE_P (rhs))
+    {
+    case IS_STRING:
+      return Z_STRVAL_P (rhs)[0];
+
+    case IS_NULL:
+      return '\0';
+
+    case IS_BOOL:
+      return Z_LVAL_P (rhs) ? '1' : '\0';
+
+    case IS_LONG:
+      snprintf (buf, sizeof (buf), "%ld", Z_LVAL_P (rhs));
+      return buf[0];
+
+    case IS_DOUBLE:
+      snprintf (buf, sizeof (buf), "%.*G", (int) EG (precision),
+		Z_DVAL_P (rhs));
+      return buf[0];
+
+    default:
+      copy = *rhs;
+      zval_copy_ctor (&copy);
+      convert_to_string (&copy);
+      result = Z_STRVAL (copy)[0];
+      zval_dtor (&copy);
+      return result;
+    }
+}
+
 /* Given a string (p_lhs), write into it for $x[i] = $y; */
 void
 write_string_index (zval ** p_lhs, zval * ind, zval * rhs TSRMLS_DC)
@@ -53,19 +139,7 @@ write_string_index (zval ** p_lhs, zval * ind, zval * rhs TSRMLS_DC)
   long index = get_integer_index (ind TSRMLS_CC);
 
   // Get the appropriate character
-  char new_char;
-  if (Z_TYPE_P (rhs) != IS_STRING)
-    {
-      // TODO: remove allocate
-      zval *copy = zvp_clone_ex (rhs);
-      convert_to_string (copy);
-      new_char = Z_STRVAL_P (copy)[0];
-      zval_ptr_dtor (&copy);
-    }
-  else
-    {
-      new_char = Z_STRVAL_P (rhs)[0];
-    }
+  char new_char = get_first_char (rhs TSRMLS_CC);
 
   // Bounds check
   if (index < 0)
@@ -101,3 +175,97 @@ write_string_index (zval ** p_lhs, zval * ind, zval * rhs TSRMLS_DC)
 
   // index < 0: E_WARNING illegal string offset
 }
+
+/*
+ * String builders. A local which is only appended to can be kept in a
+ * phc_string_builder, whose buffer grows geometrically, instead of in a
+ * zval, which concat_function reallocates on every append. Using the
+ * string in any other way moves the buffer back into the variable's zval.
+ * While the builder is in use (C is not NULL), the zval is NULL.
+ */
+typedef struct
+{
+  char *c;
+  int len;
+  int capacity;
+} phc_string_builder;
+
+/* Start building from the value of *P_VAR, which is a local that is not a
+ * reference. If nothing else shares the string, its buffer is taken over,
+ * rather than copied. */
+static void
+phc_builder_start (phc_string_builder * builder, zval ** p_var TSRMLS_DC)
+{
+  zval tmp;
+  zval *str;
+
+  assert (builder->c == NULL);
+
+  if (*p_var == NULL)
+    {
+      builder->capacity = 32;
+      builder->len = 0;
+      builder->c = emalloc (builder->capacity + 1);
+      return;
+    }
+
+  if (Z_TYPE_PP (p_var) == IS_STRING && Z_REFCOUNT_PP (p_var) == 1)
+    {
+      builder->c = Z_STRVAL_PP (p_var);
+      builder->len = Z_STRLEN_PP (p_var);
+      builder->capacity = Z_STRLEN_PP (p_var);
+      FREE_ZVAL (*p_var);
+      *p_var = NULL;
+      return;
+    }
+
+  str = get_string_val (*p_var, &tmp);
+  builder->len = Z_STRLEN_P (str);
+  builder->capacity = builder->len > 16 ? builder->len * 2 : 32;
+  builder->c = emalloc (builder->capacity + 1);
+  memcpy (builder->c, Z_STRVAL_P (str), builder->len);
+  free_string_val (str, &tmp);
+
+  zval_ptr_dtor (p_var);
+  *p_var = NULL;
+}
+
+/* Append RHS, converted to a string, doubling the buffer if it is full. */
+static void
+phc_builder_append (phc_string_builder * builder, zval * rhs TSRMLS_DC)
+{
+  zval tmp;
+  zval *str = get_string_val (rhs, &tmp);
+  int len = builder->len + Z_STRLEN_P (str);
+
+  if (len > builder->capacity)
+    {
+      builder->capacity = len > builder->capacity * 2 ? len : builder->capacity * 2;
+      builder->c = erealloc (builder->c, builder->capacity + 1);
+    }
+
+  memcpy (builder->c + builder->len, Z_STRVAL_P (str), Z_STRLEN_P (str));
+  builder->len = len;
+  free_string_val (str, &tmp);
+}
+
+/* Move the built string into *P_VAR. */
+static void
+phc_builder_finish (phc_string_builder * builder, zval ** p_var)
+{
+  assert (*p_var == NULL);
+
+  builder->c[builder->len] = '\0';
+  ALLOC_INIT_ZVAL (*p_var);
+  ZVAL_STRINGL (*p_var, builder->c, builder->len, 0);
+  builder->c = NULL;
+}
+
+static void
+phc_builder_release (phc_string_builder * builder)
+{
+  if (builder->c != NULL)
+    efree (builder->c);
+
+  builder->c = NULL;
+}
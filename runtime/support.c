@@ -17,6 +17,7 @@
 
 // Some common functions
 #include "php.h"
+#include "SAPI.h"
 
 /*
  * The runtime needs its own initialization and finalization.  phc is
@@ -33,16 +34,186 @@
 	#define Z_ADDREF_P(p) (p)->refcount++
 	#define Z_DELREF_P(p) (p)->refcount--
   #define Z_SET_REFCOUNT_P(p, val) (p)->refcount=val
+	#define array_init_size(arg, size) array_init (arg)
 #else
 	#define Z_SET_OBJECT_PTR(lhs, rhs) lhs->object_ptr = *rhs
 #endif
 
+/*
+ * Error locations. Each call site has a static phc_location, and while the
+ * call runs, phc_current_location points to it. Its filename and line are
+ * only read if an error is raised, when they replace the engine's own.
+ */
+typedef struct
+{
+  char *filename;
+  int line_number;
+} phc_location;
+
+static phc_location *phc_current_location = NULL;
+
+static void (*phc_zend_error_cb) (int type, const char *error_filename,
+				  const uint error_lineno, const char *format,
+				  va_list args);
+
+static void
+phc_error_cb (int type, const char *error_filename, const uint error_lineno,
+	      const char *format, va_list args)
+{
+  TSRMLS_FETCH ();
+
+  // Errors from the compiler, when compiling an included file, have their
+  // own locations.
+  if (phc_current_location != NULL && !CG (in_compilation)
+      && !(type & (E_CORE | E_PARSE | E_COMPILE_ERROR | E_COMPILE_WARNING)))
+    {
+      error_filename = phc_current_location->filename;
+      error_lineno = phc_current_location->line_number;
+    }
+
+  phc_zend_error_cb (type, error_filename, error_lineno, format, args);
+}
+
+/*
+ * Strings of zero or one character, so that reading a string offset doesnt
+ * need to allocate. Each has a reference which is never released, so they
+ * are never freed. Refcounts arent atomic, so threaded builds dont share
+ * them.
+ */
+#ifndef ZTS
+static zval phc_char_strings[256];
+static char phc_char_values[256][2];
+static zval phc_empty_string;
+
+static void
+init_char_strings ()
+{
+  int i;
+  for (i = 0; i < 256; i++)
+    {
+      phc_char_values[i][0] = (char) i;
+      phc_char_values[i][1] = '\0';
+      INIT_PZVAL (&phc_char_strings[i]);
+      ZVAL_STRINGL (&phc_char_strings[i], phc_char_values[i], 1, 0);
+    }
+
+  INIT_PZVAL (&phc_empty_string);
+  ZVAL_STRINGL (&phc_empty_string, "", 0, 0);
+}
+#endif
+
+/*
+ * Output buffer. Compiled programs replace the SAPI's writer with
+ * phc_ub_write, which collects the output and writes it in large chunks,
+ * rather than making a system call for each echo. The buffer is written out
+ * when it is full, when the script calls flush (), before the program
+ * shuts down, and when it crashes. Implicit flushing would write it out
+ * after every echo, so it is turned off. Writes which bypass the SAPI, such
+ * as fwrite (STDOUT, ...) or error_log to stderr, are not buffered, so they
+ * can appear before echoes which came earlier.
+ */
+#define PHC_OUTPUT_BUFFER_SIZE 65536
+
+static char phc_output_buffer[PHC_OUTPUT_BUFFER_SIZE];
+static unsigned int phc_output_length = 0;
+
+static int (*phc_sapi_ub_write) (const char *str, unsigned int str_length
+				 TSRMLS_DC);
+static void (*phc_sapi_flush) (void *server_context);
+
+static void
+phc_drain_output (TSRMLS_D)
+{
+  if (phc_output_length > 0)
+    phc_sapi_ub_write (phc_output_buffer, phc_output_length TSRMLS_CC);
+
+  phc_output_length = 0;
+}
+
+// Called from the signal handler of compiled executables. The buffer is
+// emptied before writing, in case the crash was in the writer.
+void
+phc_drain_output_after_crash (TSRMLS_D)
+{
+  unsigned int length = phc_output_length;
+  phc_output_length = 0;
+
+  if (length > 0)
+    phc_sapi_ub_write (phc_output_buffer, length TSRMLS_CC);
+}
+
+static int
+phc_ub_write (const char *str, unsigned int str_length TSRMLS_DC)
+{
+  // Too big to be worth copying. Earlier output must be written first.
+  if (str_length > PHC_OUTPUT_BUFFER_SIZE / 2)
+    {
+      phc_drain_output (TSRMLS_C);
+      return phc_sapi_ub_write (str, str_length TSRMLS_CC);
+    }
+
+  if (phc_output_length + str_length > PHC_OUTPUT_BUFFER_SIZE)
+    phc_drain_output (TSRMLS_C);
+
+  memcpy (phc_output_buffer + phc_output_length, str, str_length);
+  phc_output_length += str_length;
+  return str_length;
+}
+
+static void
+phc_flush (void *server_context)
+{
+  TSRMLS_FETCH ();
+  phc_drain_output (TSRMLS_C);
+
+  if (phc_sapi_flush != NULL)
+    phc_sapi_flush (server_context);
+}
+
+void
+phc_start_output_buffer (TSRMLS_D)
+{
+  phc_sapi_ub_write = sapi_module.ub_write;
+  phc_sapi_flush = sapi_module.flush;
+  sapi_module.ub_write = phc_ub_write;
+  sapi_module.flush = phc_flush;
+
+#if PHP_VERSION_ID < 50400
+  // The request has already copied the writer
+  OG(php_header_write) = phc_ub_write;
+  php_end_implicit_flush (TSRMLS_C);
+#else
+  php_output_set_implicit_flush (0 TSRMLS_CC);
+#endif
+}
+
+// Output during shutdown, from destructors and shutdown functions, is
+// written directly.
+void
+phc_end_output_buffer (TSRMLS_D)
+{
+  phc_drain_output (TSRMLS_C);
+  sapi_module.ub_write = phc_sapi_ub_write;
+  sapi_module.flush = phc_sapi_flush;
+
+#if PHP_VERSION_ID < 50400
+  OG(php_header_write) = phc_sapi_ub_write;
+#endif
+}
+
 void
 init_runtime ()
 {
+  phc_zend_error_cb = zend_error_cb;
+  zend_error_cb = phc_error_cb;
+
+#ifndef ZTS
+  init_char_strings ();
+#endif
 }
 
 void
 finalize_runtime ()
 {
+  zend_error_cb = phc_zend_error_cb;
 }
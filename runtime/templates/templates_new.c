@@ -94,6 +94,27 @@
  * $x = $y;
  */
 
+// $y is not used again, so its zval is moved to $x instead of being shared.
+// This keeps its refcount at 1, so that writes to $x don't separate it.
+assign_expr_var (token LHS, node RHS)
+   where LHS.st_entry_not_required
+   where RHS.last_use
+   where RHS.moved == "FALSE"
+@@@
+  if (local_$RHS != NULL && !Z_ISREF_P (local_$RHS)
+      && (local_$LHS == NULL || !Z_ISREF_P (local_$LHS)))
+    {
+      if (local_$LHS != NULL)
+	zval_ptr_dtor (&local_$LHS);
+      local_$LHS = local_$RHS;
+      local_$RHS = NULL;
+    }
+  else
+    {
+      \assign_expr_var (LHS, RHS#moved);
+    }
+@@@
+
 assign_expr_var (token LHS, node RHS)
    where LHS.st_entry_not_required
    where LHS.is_uninitialized
@@ -133,6 +154,17 @@ assign_expr_cast (token LHS, token RHS, string TYPE)
   \cast_var ("p_lhs", TYPE);
 @@@
 
+/*
+ * $x = (array) $x, where $x is NULL, creates a new array. If it doesn't
+ * escape, we know how many entries it will get, so we size it up front.
+ */
+assign_expr_new_array (token LHS, string SIZE)
+@@@
+  \get_st_entry ("LOCAL", "p_lhs", LHS);
+  prepare_lhs_for_result (p_lhs);
+  array_init_size (*p_lhs, $SIZE);
+@@@
+
 cast_var (string LHS, string TYPE)
 @@@
   assert ($TYPE >= 0 && $TYPE <= 6);
@@ -155,8 +187,179 @@ convert_to (string TYPE) where TYPE == "IS_OBJECT" @@@convert_to_object@@@
  * Bin-ops
  */
 
+/*
+ * Type-specialized bin-ops, selected using the types the optimizer proved for
+ * the operands (LEFT.type and RIGHT.type). The operands are read before the
+ * LHS is fetched, since the LHS may be one of them.
+ */
+
+// int + int, which the optimizer proved cannot overflow
+assign_expr_bin_op (token LHS, node LEFT, node RIGHT, string OP_FN, node BIN_OP)
+   where LEFT.type == "int"
+   where RIGHT.type == "int"
+   where \operator_kind (OP_FN) == "ARITH"
+   where BIN_OP.no_overflow
+@@@
+  \read_rvalue ("left", LEFT);
+  \read_rvalue ("right", RIGHT);
+  long result = Z_LVAL_P (left) \c_operator (OP_FN) Z_LVAL_P (right);
+  \get_st_entry ("LOCAL", "p_lhs", LHS);
+  prepare_lhs_for_result (p_lhs);
+  ZVAL_LONG (*p_lhs, result);
+@@@
+
+// int + int, which may overflow into a real
+assign_expr_bin_op (token LHS, node LEFT, node RIGHT, string OP_FN, node BIN_OP)
+   where LEFT.type == "int"
+   where RIGHT.type == "int"
+   where \operator_kind (OP_FN) == "ARITH"
+@@@
+  \read_rvalue ("left", LEFT);
+  \read_rvalue ("right", RIGHT);
+  long l1 = Z_LVAL_P (left);
+  long l2 = Z_LVAL_P (right);
+  \get_st_entry ("LOCAL", "p_lhs", LHS);
+  prepare_lhs_for_result (p_lhs);
+  long_$OP_FN (*p_lhs, l1, l2);
+@@@
+
+// int < int
+assign_expr_bin_op (token LHS, node LEFT, node RIGHT, string OP_FN, node BIN_OP)
+   where LEFT.type == "int"
+   where RIGHT.type == "int"
+   where \operator_kind (OP_FN) == "COMPARE"
+@@@
+  \read_rvalue ("left", LEFT);
+  \read_rvalue ("right", RIGHT);
+  zend_bool result = Z_LVAL_P (left) \c_operator (OP_FN) Z_LVAL_P (right);
+  \get_st_entry ("LOCAL", "p_lhs", LHS);
+  prepare_lhs_for_result (p_lhs);
+  ZVAL_BOOL (*p_lhs, result);
+@@@
+
+// int === int
+assign_expr_bin_op (token LHS, node LEFT, node RIGHT, string OP_FN, node BIN_OP)
+   where LEFT.type == "int"
+   where RIGHT.type == "int"
+   where \operator_kind (OP_FN) == "IDENTICAL"
+@@@
+  \read_rvalue ("left", LEFT);
+  \read_rvalue ("right", RIGHT);
+  zend_bool result = Z_LVAL_P (left) \c_operator (OP_FN) Z_LVAL_P (right);
+  \get_st_entry ("LOCAL", "p_lhs", LHS);
+  prepare_lhs_for_result (p_lhs);
+  ZVAL_BOOL (*p_lhs, result);
+@@@
+
+// real === real
+assign_expr_bin_op (token LHS, node LEFT, node RIGHT, string OP_FN, node BIN_OP)
+   where LEFT.type == "real"
+   where RIGHT.type == "real"
+   where \operator_kind (OP_FN) == "IDENTICAL"
+@@@
+  \read_rvalue ("left", LEFT);
+  \read_rvalue ("right", RIGHT);
+  zend_bool result = Z_DVAL_P (left) \c_operator (OP_FN) Z_DVAL_P (right);
+  \get_st_entry ("LOCAL", "p_lhs", LHS);
+  prepare_lhs_for_result (p_lhs);
+  ZVAL_BOOL (*p_lhs, result);
+@@@
+
+// Arithmetic and comparisons where one operand is a real, and the other is
+// an int or a real.
+assign_expr_bin_op (token LHS, node LEFT, node RIGHT, string OP_FN, node BIN_OP)
+   where LEFT.type == "real"
+   where \is_number (RIGHT) == "TRUE"
+   where \has_double_form (OP_FN) == "TRUE"
+@@@
+  \double_bin_op (LHS, LEFT, RIGHT, OP_FN);
+@@@
+
+assign_expr_bin_op (token LHS, node LEFT, node RIGHT, string OP_FN, node BIN_OP)
+   where LEFT.type == "int"
+   where RIGHT.type == "real"
+   where \has_double_form (OP_FN) == "TRUE"
+@@@
+  \double_bin_op (LHS, LEFT, RIGHT, OP_FN);
+@@@
+
+double_bin_op (token LHS, node LEFT, node RIGHT, string OP_FN)
+   where \operator_kind (OP_FN) == "ARITH"
+@@@
+  \read_rvalue ("left", LEFT);
+  \read_rvalue ("right", RIGHT);
+  double result = (\to_double ("left", LEFT) \c_operator (OP_FN) \to_double ("right", RIGHT));
+  \get_st_entry ("LOCAL", "p_lhs", LHS);
+  prepare_lhs_for_result (p_lhs);
+  ZVAL_DOUBLE (*p_lhs, result);
+@@@
+
+// This is how compare_function compares doubles (NaN compares equal to
+// everything).
+double_bin_op (token LHS, node LEFT, node RIGHT, string OP_FN)
+   where \operator_kind (OP_FN) == "COMPARE"
+@@@
+  \read_rvalue ("left", LEFT);
+  \read_rvalue ("right", RIGHT);
+  double diff = (\to_double ("left", LEFT) - \to_double ("right", RIGHT));
+  zend_bool result = ZEND_NORMALIZE_BOOL (diff) \c_operator (OP_FN) 0;
+  \get_st_entry ("LOCAL", "p_lhs", LHS);
+  prepare_lhs_for_result (p_lhs);
+  ZVAL_BOOL (*p_lhs, result);
+@@@
+
+// string . string
+assign_expr_bin_op (token LHS, node LEFT, node RIGHT, string OP_FN, node BIN_OP)
+   where LEFT.type == "string"
+   where RIGHT.type == "string"
+   where OP_FN == "concat_function"
+@@@
+  \read_rvalue ("left", LEFT);
+  \read_rvalue ("right", RIGHT);
+  int len = Z_STRLEN_P (left) + Z_STRLEN_P (right);
+  char* str = emalloc (len + 1);
+  memcpy (str, Z_STRVAL_P (left), Z_STRLEN_P (left));
+  memcpy (str + Z_STRLEN_P (left), Z_STRVAL_P (right), Z_STRLEN_P (right));
+  str[len] = '\0';
+  \get_st_entry ("LOCAL", "p_lhs", LHS);
+  prepare_lhs_for_result (p_lhs);
+  ZVAL_STRINGL (*p_lhs, str, len, 0);
+@@@
+
+operator_kind (string OP_FN) where OP_FN == "add_function" @@@ARITH@@@
+operator_kind (string OP_FN) where OP_FN == "sub_function" @@@ARITH@@@
+operator_kind (string OP_FN) where OP_FN == "mul_function" @@@ARITH@@@
+operator_kind (string OP_FN) where OP_FN == "is_smaller_function" @@@COMPARE@@@
+operator_kind (string OP_FN) where OP_FN == "is_smaller_or_equal_function" @@@COMPARE@@@
+operator_kind (string OP_FN) where OP_FN == "is_equal_function" @@@COMPARE@@@
+operator_kind (string OP_FN) where OP_FN == "is_not_equal_function" @@@COMPARE@@@
+operator_kind (string OP_FN) where OP_FN == "is_identical_function" @@@IDENTICAL@@@
+operator_kind (string OP_FN) where OP_FN == "is_not_identical_function" @@@IDENTICAL@@@
+operator_kind (string OP_FN) @@@OTHER@@@
+
+c_operator (string OP_FN) where OP_FN == "add_function" @@@+@@@
+c_operator (string OP_FN) where OP_FN == "sub_function" @@@-@@@
+c_operator (string OP_FN) where OP_FN == "mul_function" @@@*@@@
+c_operator (string OP_FN) where OP_FN == "is_smaller_function" @@@<@@@
+c_operator (string OP_FN) where OP_FN == "is_smaller_or_equal_function" @@@<=@@@
+c_operator (string OP_FN) where OP_FN == "is_equal_function" @@@==@@@
+c_operator (string OP_FN) where OP_FN == "is_not_equal_function" @@@!=@@@
+c_operator (string OP_FN) where OP_FN == "is_identical_function" @@@==@@@
+c_operator (string OP_FN) where OP_FN == "is_not_identical_function" @@@!=@@@
+
+has_double_form (string OP_FN) where \operator_kind (OP_FN) == "ARITH" @@@TRUE@@@
+has_double_form (string OP_FN) where \operator_kind (OP_FN) == "COMPARE" @@@TRUE@@@
+has_double_form (string OP_FN) @@@FALSE@@@
+
+is_number (node VAR) where VAR.type == "int" @@@TRUE@@@
+is_number (node VAR) where VAR.type == "real" @@@TRUE@@@
+is_number (node VAR) @@@FALSE@@@
+
+to_double (string ZVP, node VAR) where VAR.type == "int" @@@((double) Z_LVAL_P ($ZVP))@@@
+to_double (string ZVP, node VAR) @@@Z_DVAL_P ($ZVP)@@@
+
 // We could do this for non-LOCAL, but we'd only be saving an refcount++ and a refcount--.
-assign_expr_bin_op (token LHS, node LEFT, node RIGHT, string OP_FN)
+assign_expr_bin_op (token LHS, node LEFT, node RIGHT, string OP_FN, node BIN_OP)
    where LHS.st_entry_not_required
    where LHS.is_uninitialized
 @@@
@@ -172,7 +375,7 @@ assign_expr_bin_op (token LHS, node LEFT, node RIGHT, string OP_FN)
 // OP_FN: for example "add_function"
 // The caller must sort out the order of LEFT and RIGHT for > and >=
 // We use NODE for LEFT and RIGHT, since they might be literals
-assign_expr_bin_op (token LHS, node LEFT, node RIGHT, string OP_FN)
+assign_expr_bin_op (token LHS, node LEFT, node RIGHT, string OP_FN, node BIN_OP)
 @@@
   \get_st_entry ("LOCAL", "p_lhs", LHS);
   \read_rvalue ("left", LEFT);
@@ -239,6 +442,21 @@ return (token RETVAL, node RET)
    goto end_of_function;
 @@@
 
+// Return-by-value, of a local which is not used again. If nothing else
+// shares its value, the value can be moved instead of copied.
+return (node RETVAL, node RET)
+   where RETVAL.last_use
+@@@
+   \read_rvalue ("rhs", RETVAL)
+   return_value->value = rhs->value;
+   return_value->type = rhs->type;
+   if (Z_REFCOUNT_P (rhs) == 1)
+      ZVAL_NULL (rhs);
+   else
+      zval_copy_ctor (return_value);
+   goto end_of_function;
+@@@
+
 // Return-by-value
 return (node RETVAL, node RET)
 @@@
@@ -268,6 +486,107 @@ branch (token COND, string TRUE_TARGET, string FALSE_TARGET)
       goto $FALSE_TARGET;
 @@@
 
+/*
+ * Unboxed locals. The value of VAR is kept in native_$VAR, and local_$VAR is
+ * only updated before a statement which needs a zval.
+ */
+/*
+ * Methods with a lazy symbol table keep their locals in C variables, and copy
+ * them to and from the symbol table around the statements which use it.
+ */
+sync_into_symbol_table (string VAR)
+@@@
+   phc_sync_into_symbol_table (locals, "$VAR", \cb:length(VAR) + 1, \cb:hash(VAR), local_$VAR TSRMLS_CC);
+@@@
+
+sync_from_symbol_table (string VAR)
+@@@
+   phc_sync_from_symbol_table (locals, "$VAR", \cb:length(VAR) + 1, \cb:hash(VAR), &local_$VAR);
+@@@
+
+box_local (token VAR, string CTOR)
+@@@
+   if (local_$VAR == NULL || Z_REFCOUNT_P (local_$VAR) > 1)
+   {
+      if (local_$VAR != NULL)
+         zval_ptr_dtor (&local_$VAR);
+      ALLOC_INIT_ZVAL (local_$VAR);
+   }
+   $CTOR (local_$VAR, native_$VAR);
+@@@
+
+unbox_local (token VAR, string ACCESSOR)
+@@@
+   native_$VAR = $ACCESSOR (local_$VAR);
+@@@
+
+/*
+ * Release a local which is not used again. This is only used for locals
+ * which can hold no objects or resources, even inside arrays, so that
+ * destructors run when PHP would run them. References are left alone, as
+ * the variable is still bound to them.
+ */
+release_local (token VAR)
+   where VAR.packed
+@@@
+   \vector_unset (VAR);
+   \release_zval (VAR);
+@@@
+
+release_local (token VAR)
+   where VAR.string_builder
+@@@
+   phc_builder_release (&builder_$VAR);
+   \release_zval (VAR);
+@@@
+
+release_local (token VAR)
+@@@
+   \release_zval (VAR);
+@@@
+
+release_zval (token VAR)
+@@@
+   if (local_$VAR != NULL && !Z_ISREF_P (local_$VAR)
+       && Z_TYPE_P (local_$VAR) != IS_OBJECT
+       && Z_TYPE_P (local_$VAR) != IS_RESOURCE)
+   {
+      zval_ptr_dtor (&local_$VAR);
+      local_$VAR = NULL;
+   }
+@@@
+
+// RHS is a C expression
+native_assign (token LHS, string RHS)
+@@@
+   native_$LHS = $RHS;
+@@@
+
+// OP is a C operator
+native_assign_bin_op (token LHS, string LEFT, string OP, string RIGHT)
+@@@
+   native_$LHS = $LEFT $OP $RIGHT;
+@@@
+
+native_pre_op (token VAR, string OP)
+@@@
+   $OP native_$VAR;
+@@@
+
+native_return (token RETVAL, string CTOR)
+@@@
+   $CTOR (return_value, native_$RETVAL);
+   goto end_of_function;
+@@@
+
+native_branch (token COND, string TRUE_TARGET, string FALSE_TARGET)
+@@@
+   if (native_$COND)
+      goto $TRUE_TARGET;
+   else
+      goto $FALSE_TARGET;
+@@@
+
    
 
 /*
@@ -321,7 +640,7 @@ assign_expr_array_access (token LHS, node ARRAY, node INDEX)
       if (check_array_index_type (r_index TSRMLS_CC))
 	{
 	  // Read array variable
-	  read_array (&rhs, r_array, r_index TSRMLS_CC);
+	  \read_array ("rhs", "r_array", "r_index", INDEX);
 	}
       else
 	rhs = *p_lhs; // HACK to fail  *p_lhs != rhs
@@ -339,11 +658,37 @@ assign_expr_ref_array_access (token LHS, token ARRAY, node INDEX)
    \get_st_entry ("LOCAL", "p_r_array", ARRAY);
    \read_rvalue ("r_index", INDEX);
    check_array_type (p_r_array TSRMLS_CC);
-   zval** p_rhs = get_ht_entry (p_r_array, r_index TSRMLS_CC);
+   \get_ht_entry ("p_rhs", "p_r_array", "r_index", INDEX);
    sep_copy_on_write (p_rhs);
    copy_into_ref (p_lhs, p_rhs);
 @@@
 
+/*
+ * Indexing with a string literal uses a precomputed key, saving the hashing
+ * and the check for numeric strings.
+ */
+read_array (string RESULT, string ARRAY, string IND, node INDEX)
+   where INDEX.key_name
+@@@
+   read_array_key (&$RESULT, $ARRAY, &${INDEX.key_name} TSRMLS_CC);
+@@@
+
+read_array (string RESULT, string ARRAY, string IND, node INDEX)
+@@@
+   read_array (&$RESULT, $ARRAY, $IND TSRMLS_CC);
+@@@
+
+get_ht_entry (string ZVP, string ARRAY, string IND, node INDEX)
+   where INDEX.key_name
+@@@
+   zval** $ZVP = get_ht_entry_key ($ARRAY, &${INDEX.key_name} TSRMLS_CC);
+@@@
+
+get_ht_entry (string ZVP, string ARRAY, string IND, node INDEX)
+@@@
+   zval** $ZVP = get_ht_entry ($ARRAY, $IND TSRMLS_CC);
+@@@
+
 /*
  * Constants
  */
@@ -613,7 +958,7 @@ assign_array (token ARRAY, node INDEX, node RHS)
    }
    else if (Z_TYPE_PP (p_array) == IS_ARRAY)
    {
-      zval** p_lhs = get_ht_entry (p_array, index TSRMLS_CC);
+      \get_ht_entry ("p_lhs", "p_array", "index", INDEX);
       \read_rvalue ("rhs", RHS);
       if (*p_lhs != rhs)
       {
@@ -637,7 +982,7 @@ assign_array_ref (token ARRAY, node INDEX, token RHS)
    }
    else if (Z_TYPE_PP (p_array) == IS_ARRAY)
    {
-      zval** p_lhs = get_ht_entry (p_array, index TSRMLS_CC);
+      \get_ht_entry ("p_lhs", "p_array", "index", INDEX);
       \get_st_entry ("LOCAL", "p_rhs", RHS);
       sep_copy_on_write (p_rhs);
       copy_into_ref (p_lhs, p_rhs);
@@ -778,6 +1123,226 @@ foreach_end (token ARRAY, string ITERATOR)
    zend_hash_internal_pointer_end_ex (fe_array->value.ht, &$ITERATOR);
 @@@
 
+/*
+ * Packed arrays. While vector_$X is not NULL, the array is kept there and
+ * local_$X is NULL. Otherwise the array is in local_$X, and these fall back
+ * to the generic templates. Foreach loops over a vector use pos_$ITERATOR
+ * instead of $ITERATOR, and set it to -1 when they use $ITERATOR.
+ */
+unpack_array (token VAR)
+@@@
+   phc_vector_to_array (&vector_$VAR, &local_$VAR TSRMLS_CC);
+@@@
+
+assign_expr_new_vector (token LHS, string SIZE)
+@@@
+   if (local_$LHS != NULL)
+   {
+      zval_ptr_dtor (&local_$LHS);
+      local_$LHS = NULL;
+   }
+   phc_vector_init (&vector_$LHS, $SIZE);
+@@@
+
+vector_assign_var (token LHS, token RHS)
+@@@
+   if (vector_$RHS != NULL)
+   {
+      if (local_$LHS != NULL)
+      {
+	 zval_ptr_dtor (&local_$LHS);
+	 local_$LHS = NULL;
+      }
+      phc_vector_assign (&vector_$LHS, vector_$RHS);
+   }
+   else
+   {
+      phc_vector_to_array (&vector_$LHS, &local_$LHS TSRMLS_CC);
+      \assign_expr_var (LHS, RHS);
+   }
+@@@
+
+vector_assign_next (token LHS, node RHS)
+@@@
+   if (vector_$LHS != NULL)
+   {
+      \read_rvalue ("rhs", RHS);
+      phc_vector_push (&vector_$LHS, rhs);
+   }
+   else
+   {
+      \assign_next (LHS, RHS);
+   }
+@@@
+
+vector_assign_array (token ARRAY, node INDEX, node RHS)
+@@@
+   \read_rvalue ("vector_index", INDEX);
+   if (vector_$ARRAY != NULL
+       && phc_vector_can_write (vector_$ARRAY, vector_index))
+   {
+      \read_rvalue ("rhs", RHS);
+      phc_vector_write (&vector_$ARRAY, Z_LVAL_P (vector_index), rhs);
+   }
+   else
+   {
+      phc_vector_to_array (&vector_$ARRAY, &local_$ARRAY TSRMLS_CC);
+      \assign_array (ARRAY, INDEX, RHS);
+   }
+@@@
+
+vector_assign_expr_array_access (token LHS, token ARRAY, node INDEX)
+@@@
+   \read_rvalue ("vector_index", INDEX);
+   if (vector_$ARRAY != NULL
+       && phc_vector_can_read (vector_$ARRAY, vector_index))
+   {
+      \get_st_entry ("LOCAL", "p_lhs", LHS);
+      zval* rhs = vector_$ARRAY->data[Z_LVAL_P (vector_index)];
+      if (*p_lhs != rhs)
+	 write_var (p_lhs, rhs);
+   }
+   else
+   {
+      phc_vector_to_array (&vector_$ARRAY, &local_$ARRAY TSRMLS_CC);
+      \assign_expr_array_access (LHS, ARRAY, INDEX);
+   }
+@@@
+
+vector_count (token LHS, token ARRAY)
+@@@
+   \new_lhs (LHS, "value");
+   ZVAL_LONG (value, vector_$ARRAY->size);
+@@@
+
+vector_is_array (token LHS, token ARRAY)
+@@@
+   \new_lhs (LHS, "value");
+   ZVAL_BOOL (value, 1);
+@@@
+
+vector_unset (token VAR)
+@@@
+   if (vector_$VAR != NULL)
+   {
+      phc_vector_release (vector_$VAR);
+      vector_$VAR = NULL;
+   }
+@@@
+
+// If the vector was converted during the loop, carry on from the same
+// element of the HashTable.
+vector_foreach_sync (token ARRAY, string ITERATOR)
+@@@
+   if (pos_$ITERATOR >= 0 && vector_$ARRAY == NULL)
+   {
+      phc_vector_seek (local_$ARRAY, &$ITERATOR, pos_$ITERATOR);
+      pos_$ITERATOR = -1;
+   }
+@@@
+
+vector_foreach_reset (token ARRAY, string ITERATOR)
+@@@
+   if (vector_$ARRAY != NULL)
+      pos_$ITERATOR = 0;
+   else
+   {
+      pos_$ITERATOR = -1;
+      \foreach_reset (ARRAY, ITERATOR);
+   }
+@@@
+
+vector_foreach_has_key (token LHS, token ARRAY, string ITERATOR)
+@@@
+   \vector_foreach_sync (ARRAY, ITERATOR);
+   if (pos_$ITERATOR >= 0)
+   {
+      \new_lhs (LHS, "value");
+      ZVAL_BOOL (value, pos_$ITERATOR < vector_$ARRAY->size);
+   }
+   else
+   {
+      \assign_expr_foreach_has_key (LHS, ARRAY, ITERATOR);
+   }
+@@@
+
+vector_foreach_get_key (token LHS, token ARRAY, string ITERATOR)
+@@@
+   \vector_foreach_sync (ARRAY, ITERATOR);
+   if (pos_$ITERATOR >= 0)
+   {
+      \new_lhs (LHS, "value");
+      ZVAL_LONG (value, pos_$ITERATOR);
+   }
+   else
+   {
+      \assign_expr_foreach_get_key (LHS, ARRAY, ITERATOR);
+   }
+@@@
+
+vector_foreach_get_val (token LHS, token ARRAY, string ITERATOR)
+@@@
+   \vector_foreach_sync (ARRAY, ITERATOR);
+   if (pos_$ITERATOR >= 0)
+   {
+      \get_st_entry ("LOCAL", "p_lhs", LHS);
+      zval* rhs = vector_$ARRAY->data[pos_$ITERATOR];
+      if (*p_lhs != rhs)
+	 write_var (p_lhs, rhs);
+   }
+   else
+   {
+      \assign_expr_foreach_get_val (LHS, ARRAY, ITERATOR);
+   }
+@@@
+
+vector_foreach_next (token ARRAY, string ITERATOR)
+@@@
+   \vector_foreach_sync (ARRAY, ITERATOR);
+   if (pos_$ITERATOR >= 0)
+      pos_$ITERATOR++;
+   else
+   {
+      \foreach_next (ARRAY, ITERATOR);
+   }
+@@@
+
+vector_foreach_end (token ARRAY, string ITERATOR)
+@@@
+   \vector_foreach_sync (ARRAY, ITERATOR);
+   if (pos_$ITERATOR < 0)
+   {
+      \foreach_end (ARRAY, ITERATOR);
+   }
+@@@
+
+/*
+ * String builders. While builder_$X.c is not NULL, the string is kept there
+ * and local_$X is NULL. Otherwise the string is in local_$X. References are
+ * never kept in a builder, as other variables must see each append.
+ */
+finish_builder (token VAR)
+@@@
+   if (builder_$VAR.c != NULL)
+      phc_builder_finish (&builder_$VAR, &local_$VAR);
+@@@
+
+// $x = $x . $y;
+builder_append (token LHS, node LEFT, node RIGHT, node BIN_OP)
+@@@
+   if (builder_$LHS.c != NULL || local_$LHS == NULL || !Z_ISREF_P (local_$LHS))
+   {
+      \read_rvalue ("right", RIGHT);
+      if (builder_$LHS.c == NULL)
+         phc_builder_start (&builder_$LHS, &local_$LHS TSRMLS_CC);
+      phc_builder_append (&builder_$LHS, right TSRMLS_CC);
+   }
+   else
+   {
+      \assign_expr_bin_op (LHS, LEFT, RIGHT, "concat_function", BIN_OP);
+   }
+@@@
+
 /*
  * Assign_field 
  *
@@ -843,18 +1408,20 @@ assign_var_field_ref (token OBJ, token VAR_FIELD, node RHS)
 assign_var_static_field (token CLASS, token VAR_FIELD, node RHS)
 @@@
 	\read_rvalue ("field_name", VAR_FIELD);
-	zval* field_name_str = get_string_val (field_name);
+	zval field_name_tmp;
+	zval* field_name_str = get_string_val (field_name, &field_name_tmp);
 	\read_rvalue ("rhs", RHS);
 	zend_class_entry* ce;
 	ce = zend_fetch_class ("$CLASS", strlen("$CLASS"), ZEND_FETCH_CLASS_DEFAULT TSRMLS_CC);
 	zend_update_static_property(ce, Z_STRVAL_P(field_name_str), Z_STRLEN_P(field_name_str), rhs TSRMLS_CC); 
-	zval_ptr_dtor(&field_name_str);
+	free_string_val (field_name_str, &field_name_tmp);
 @@@
 
 assign_var_static_field_ref (token CLASS, token VAR_FIELD, node RHS)
 @@@
 	\read_rvalue ("field_name", VAR_FIELD);
-	zval* field_name_str = get_string_val (field_name);
+	zval field_name_tmp;
+	zval* field_name_str = get_string_val (field_name, &field_name_tmp);
 	\get_st_entry ("LOCAL", "p_rhs", RHS);
 	zend_class_entry* ce;
 	ce = zend_fetch_class ("$CLASS", strlen("$CLASS"), ZEND_FETCH_CLASS_DEFAULT TSRMLS_CC);
@@ -862,7 +1429,7 @@ assign_var_static_field_ref (token CLASS, token VAR_FIELD, node RHS)
 	p_lhs = zend_std_get_static_property(ce, Z_STRVAL_P(field_name_str), Z_STRLEN_P(field_name_str), 0 TSRMLS_CC);
 	sep_copy_on_write (p_rhs);
 	copy_into_ref (p_lhs, p_rhs);
-	zval_ptr_dtor(&field_name_str);
+	free_string_val (field_name_str, &field_name_tmp);
 @@@
 
 /*
@@ -933,26 +1500,28 @@ var_field_access_ref (token LHS, token OBJ, token VAR_FIELD)
 var_static_field_access (token LHS, token CLASS, token VAR_FIELD)
 @@@
 	\read_rvalue ("field_name", VAR_FIELD);
-	zval* field_name_str = get_string_val (field_name);
+	zval field_name_tmp;
+	zval* field_name_str = get_string_val (field_name, &field_name_tmp);
 	zend_class_entry* ce;
 	ce = zend_fetch_class ("$CLASS", strlen("$CLASS"), ZEND_FETCH_CLASS_DEFAULT TSRMLS_CC);
 	zval* field = zend_read_static_property(ce, Z_STRVAL_P(field_name_str), Z_STRLEN_P(field_name_str), 0 TSRMLS_CC);
 	\get_st_entry ("LOCAL", "p_lhs", LHS);
 	write_var (p_lhs, field); 
-	zval_ptr_dtor(&field_name_str);
+	free_string_val (field_name_str, &field_name_tmp);
 @@@
 
 var_static_field_access_ref (token LHS, token CLASS, token VAR_FIELD)
 @@@
 	\read_rvalue ("field_name", VAR_FIELD);
-	zval* field_name_str = get_string_val (field_name);
+	zval field_name_tmp;
+	zval* field_name_str = get_string_val (field_name, &field_name_tmp);
 	zend_class_entry* ce;
 	ce = zend_fetch_class ("$CLASS", strlen("$CLASS"), ZEND_FETCH_CLASS_DEFAULT TSRMLS_CC);
 	zval** field = zend_std_get_static_property(ce, Z_STRVAL_P(field_name_str), Z_STRLEN_P(field_name_str), 0 TSRMLS_CC);
 	sep_copy_on_write (field);
 	\get_st_entry ("LOCAL", "p_lhs", LHS);
 	copy_into_ref (p_lhs, field); 
-	zval_ptr_dtor(&field_name_str);
+	free_string_val (field_name_str, &field_name_tmp);
 @@@
 
 // Takes a ZVP, so if passing a ZVPP, make sure to deref.
@@ -987,25 +1556,27 @@ assign_expr_new_ref (token LHS, token CLASS)
 assign_expr_var_new (token LHS, token VAR_CLASS)
 @@@
 	\read_rvalue("class_name", VAR_CLASS);
-	zval* class_name_str = get_string_val (class_name);
+	zval class_name_tmp;
+	zval* class_name_str = get_string_val (class_name, &class_name_tmp);
 	\new_lhs (LHS, "lhs");
 	zend_class_entry* ce;
 	ce = zend_fetch_class (Z_STRVAL_P(class_name_str), Z_STRLEN_P(class_name_str), ZEND_FETCH_CLASS_DEFAULT TSRMLS_CC);
 	object_init_ex(lhs, ce); 
-	zval_ptr_dtor(&class_name_str);
+	free_string_val (class_name_str, &class_name_tmp);
 @@@
 
 assign_expr_var_new_ref (token LHS, token VAR_CLASS)
 @@@
 	\read_rvalue("class_name", VAR_CLASS);
-	zval* class_name_str = get_string_val (class_name);
+	zval class_name_tmp;
+	zval* class_name_str = get_string_val (class_name, &class_name_tmp);
   \get_st_entry ("LOCAL", "p_lhs", LHS);
 	zval_ptr_dtor (p_lhs);
 	ALLOC_INIT_ZVAL (*p_lhs);
 	zend_class_entry* ce;
 	ce = zend_fetch_class (Z_STRVAL_P(class_name_str), Z_STRLEN_P(class_name_str), ZEND_FETCH_CLASS_DEFAULT TSRMLS_CC);
 	object_init_ex(*p_lhs, ce); 
-	zval_ptr_dtor(&class_name_str);
+	free_string_val (class_name_str, &class_name_tmp);
 @@@
 
 /*
@@ -1127,7 +1698,9 @@ call_function (node ATTRS, string MN, list ARGS, string FILENAME, string LINE, s
    int af_index = 0;
    \arg_fetch (ARGS);
 
-   phc_setup_error (1, "$FILENAME", $LINE, NULL TSRMLS_CC);
+   static phc_location location = { "$FILENAME", $LINE };
+   phc_location_state location_state;
+   phc_enter_location (&location_state, &location TSRMLS_CC);
 
    // save existing parameters, in case of recursion
    int param_count_save = $FCI_NAME.param_count;
@@ -1150,8 +1723,7 @@ call_function (node ATTRS, string MN, list ARGS, string FILENAME, string LINE, s
    $FCI_NAME.param_count = param_count_save;
    $FCI_NAME.retval_ptr_ptr = retval_save;
 
-   // unset the errors
-   phc_setup_error (0, NULL, 0, NULL TSRMLS_CC);
+   phc_leave_location (&location_state TSRMLS_CC);
 
    int i;
    for (i = 0; i < $ARG_COUNT; i++)
@@ -1230,21 +1802,81 @@ function_invocation (node ATTRS, string MN, list ARGS, string FILENAME, string L
 @@@
 
 
+/*
+ * Call a function compiled into this module through its direct entry point,
+ * phc_direct_MN. The function doesn't return by reference.
+ */
+direct_function_invocation (node ATTRS, string MN, list ARGS, string FILENAME, string LINE, string FCI_NAME, string FCIC_NAME, string ARG_COUNT, string LHS_REF, token LHS)
+@@@
+   initialize_function_call (&$FCI_NAME, &$FCIC_NAME, "$MN", "$FILENAME", $LINE TSRMLS_CC);
+   zend_function* signature = $FCIC_NAME.function_handler;
+   zend_arg_info* arg_info = signature->common.arg_info; // optional
+
+   // Setup array of arguments
+   int by_ref[$ARG_COUNT];
+   int destruct [$ARG_COUNT];
+   zval* args [$ARG_COUNT];
+   zval** args_ind [$ARG_COUNT];
+   zval* params [$ARG_COUNT];
+
+   int abr_index = 0;
+   \arg_by_ref (ARGS);
+
+   int af_index = 0;
+   \arg_fetch (ARGS);
+
+   static phc_location location = { "$FILENAME", $LINE };
+   phc_location_state location_state;
+   phc_enter_location (&location_state, &location TSRMLS_CC);
+
+   zval* rhs;
+   ALLOC_INIT_ZVAL (rhs);
+
+   phc_direct_call_state state;
+   phc_begin_direct_call (&state, args_ind, by_ref, $ARG_COUNT, params, signature TSRMLS_CC);
+   phc_direct_$MN (params, $ARG_COUNT, rhs, NULL, NULL, 1 TSRMLS_CC);
+   phc_end_direct_call (&state TSRMLS_CC);
+
+   phc_leave_location (&location_state TSRMLS_CC);
+
+   int i;
+   for (i = 0; i < $ARG_COUNT; i++)
+   {
+      if (destruct[i])
+	 zval_ptr_dtor (args_ind[i]);
+   }
+
+   \function_lhs (LHS_REF, LHS);
+
+   zval_ptr_dtor (&rhs);
+@@@
+
 assign_param_is_ref_function (string MN, string FILENAME, string LINE, string FCI_NAME, string FCIC_NAME, string INDEX, token LHS)
 @@@
    initialize_function_call (&$FCI_NAME, &$FCIC_NAME, "$MN", "$FILENAME", $LINE TSRMLS_CC);
 	\assign_param_is_ref (MN, FILENAME, LINE, FCI_NAME, FCIC_NAME, INDEX, LHS);
 @@@
 
-assign_param_is_ref_method (string MN, string FILENAME, string LINE, string INDEX, token TARGET, token LHS)
+assign_param_is_ref_method (string MN, string FILENAME, string LINE, string INDEX, token TARGET, token LHS, string CACHE_SIZE)
 @@@
    \get_st_entry ("LOCAL", "p_obj", TARGET);
+   static phc_method_cache method_cache[$CACHE_SIZE];
    zend_fcall_info fci_object;
    zend_fcall_info_cache fcic_object = {0, NULL, NULL, NULL};
-   initialize_method_call (&fci_object, &fcic_object, p_obj, "$MN", "$FILENAME", $LINE TSRMLS_CC);
+   initialize_cached_method_call (&fci_object, &fcic_object, p_obj, "$MN", method_cache, $CACHE_SIZE, "$FILENAME", $LINE TSRMLS_CC);
 	\assign_param_is_ref (MN, FILENAME, LINE, "fci_object", "fcic_object", INDEX, LHS);
 @@@
 
+assign_param_is_ref_variable_function (string FILENAME, string LINE, string INDEX, token FN, token LHS)
+@@@
+   \read_rvalue ("fn", FN);
+   static phc_function_cache function_cache;
+   zend_fcall_info fci_var;
+   zend_fcall_info_cache fcic_var;
+   initialize_cached_function_call (&fci_var, &fcic_var, fn, &function_cache, "$FILENAME", $LINE TSRMLS_CC);
+	\assign_param_is_ref ("variable function", FILENAME, LINE, "fci_var", "fcic_var", INDEX, LHS);
+@@@
+
 assign_param_is_ref (string MN, string FILENAME, string LINE, string FCI_NAME, string FCIC_NAME, string INDEX, token LHS)
 @@@
 	zend_function* signature = $FCIC_NAME.function_handler;
@@ -1272,15 +1904,33 @@ assign_param_is_ref (string MN, string FILENAME, string LINE, string FCI_NAME, s
 @@@
 
 
-method_invocation (node ATTRS, string MN, list ARGS, string FILENAME, string LINE, string ARG_COUNT, node TARGET, string USE_REF, token LHS)
+/*
+ * Each call site caches the methods it finds for the last CACHE_SIZE classes
+ * of receiver.
+ */
+method_invocation (node ATTRS, string MN, list ARGS, string FILENAME, string LINE, string ARG_COUNT, node TARGET, string USE_REF, token LHS, string CACHE_SIZE)
 @@@
    \get_st_entry ("LOCAL", "p_obj", TARGET);
+   static phc_method_cache method_cache[$CACHE_SIZE];
    zend_fcall_info fci_object;
    zend_fcall_info_cache fcic_object = {0, NULL, NULL, NULL};
-   initialize_method_call (&fci_object, &fcic_object, p_obj, "$MN", "$FILENAME", $LINE TSRMLS_CC);
+   initialize_cached_method_call (&fci_object, &fcic_object, p_obj, "$MN", method_cache, $CACHE_SIZE, "$FILENAME", $LINE TSRMLS_CC);
    \call_function (ATTRS, MN, ARGS, FILENAME, LINE, "fci_object", "fcic_object", ARG_COUNT, USE_REF, LHS);
 @@@
 
+/*
+ * Variable functions cache the last function called at the site.
+ */
+variable_function_invocation (node ATTRS, list ARGS, string FILENAME, string LINE, string ARG_COUNT, token FN, string USE_REF, token LHS)
+@@@
+   \read_rvalue ("fn", FN);
+   static phc_function_cache function_cache;
+   zend_fcall_info fci_var;
+   zend_fcall_info_cache fcic_var;
+   initialize_cached_function_call (&fci_var, &fcic_var, fn, &function_cache, "$FILENAME", $LINE TSRMLS_CC);
+   \call_function (ATTRS, "variable function", ARGS, FILENAME, LINE, "fci_var", "fcic_var", ARG_COUNT, USE_REF, LHS);
+@@@
+
 constructor_invocation (node ATTRS, list ARGS, string FILENAME, string LINE, string ARG_COUNT, token LHS)
 @@@
   \get_st_entry ("LOCAL", "p_obj", LHS);
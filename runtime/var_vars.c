@@ -8,38 +8,17 @@
  * 
  */
 
-/*
- * If the parameter is a string, returns the parameter, with the refcount
- * incremented. If its not a string, returns a new zval, with a refcount of
- * 1. Either way, zval_dtor_ptr must be run by the caller on the return
- * value.
- */
-zval*
-get_string_val (zval* zvp)
-{
-  if (Z_TYPE_P (zvp) == IS_STRING)
-    {
-      Z_ADDREF_P(zvp);
-      return zvp;
-    }
-  else
-    {
-      zval* clone = zvp_clone_ex (zvp);
-      convert_to_string (clone);
-      return clone;
-    }
-}
-
 zval **
 get_var_var (HashTable * st, zval * index TSRMLS_DC)
 {
-  zval* str_index = get_string_val (index);
+  zval tmp;
+  zval* str_index = get_string_val (index, &tmp);
   char* name = Z_STRVAL_P (str_index);
   int length = Z_STRLEN_P (str_index) + 1;
   unsigned long hash = zend_get_hash_value (name, length);
 
   zval** result = get_st_entry (st, name, length, hash TSRMLS_CC);
-  zval_ptr_dtor (&str_index);
+  free_string_val (str_index, &tmp);
   return result;
 }
 
@@ -50,12 +29,81 @@ get_var_var (HashTable * st, zval * index TSRMLS_DC)
 zval *
 read_var_var (HashTable * st, zval * index TSRMLS_DC)
 {
-  zval* str_index = get_string_val (index);
+  zval tmp;
+  zval* str_index = get_string_val (index, &tmp);
   char* name = Z_STRVAL_P (str_index);
   int length = Z_STRLEN_P (str_index) + 1;
   unsigned long hash = zend_get_hash_value (name, length);
 
   zval* result = read_var (st, name, length, hash TSRMLS_CC);
-  zval_ptr_dtor (&str_index);
+  free_string_val (str_index, &tmp);
   return result;
 }
+
+/*
+ * Lazily created symbol tables. Methods which only use their symbol table in
+ * a few statements keep their locals in C variables. Around those
+ * statements, the locals are copied into the symbol table, which is created
+ * the first time it is needed, and then copied back out.
+ */
+
+/* Returns the previous active symbol table, to be restored afterwards. */
+static HashTable *
+phc_begin_symbol_table (HashTable ** locals TSRMLS_DC)
+{
+  HashTable *caller_symbol_table = EG (active_symbol_table);
+
+  if (*locals == NULL)
+    {
+      ALLOC_HASHTABLE (*locals);
+      zend_hash_init (*locals, 8, NULL, ZVAL_PTR_DTOR, 0);
+    }
+
+  EG (active_symbol_table) = *locals;
+  return caller_symbol_table;
+}
+
+static void
+phc_sync_into_symbol_table (HashTable * locals, char *name, int length,
+			    ulong hash, zval * value TSRMLS_DC)
+{
+  zval **p_entry;
+
+  if (value == NULL || value == EG (uninitialized_zval_ptr))
+    {
+      zend_hash_del (locals, name, length);
+      return;
+    }
+
+  if (zend_hash_quick_find (locals, name, length, hash, (void **) &p_entry)
+      == SUCCESS && *p_entry == value)
+    return;
+
+  Z_ADDREF_P (value);
+  zend_hash_quick_update (locals, name, length, hash, &value, sizeof (zval *),
+			  NULL);
+}
+
+static void
+phc_sync_from_symbol_table (HashTable * locals, char *name, int length,
+			    ulong hash, zval ** p_local)
+{
+  zval **p_entry;
+
+  if (zend_hash_quick_find (locals, name, length, hash, (void **) &p_entry)
+      == SUCCESS)
+    {
+      if (*p_entry == *p_local)
+	return;
+
+      Z_ADDREF_P (*p_entry);
+      if (*p_local != NULL)
+	zval_ptr_dtor (p_local);
+      *p_local = *p_entry;
+    }
+  else if (*p_local != NULL)
+    {
+      zval_ptr_dtor (p_local);
+      *p_local = NULL;
+    }
+}
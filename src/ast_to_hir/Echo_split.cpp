@@ -2,10 +2,11 @@
  * phc -- the open source PHP compiler
  * See doc/license/README.license for licensing information
  *
- * Convert echo()es to print()s
+ * Convert echo()es to print()s, and merge adjacent prints of literals
  */
 
 #include "Echo_split.h"
+#include "process_ir/General.h"
 
 using namespace AST;
 
@@ -48,3 +49,85 @@ void Echo_split::pre_eval_expr(Eval_expr* in, Statement_list* out)
 
 	}
 }
+
+// If IN prints a single string or integer literal, return it as a string.
+static String* get_printed_literal (Statement* in)
+{
+	Eval_expr* eval = dynamic_cast<Eval_expr*> (in);
+	if (eval == NULL)
+		return NULL;
+
+	Method_invocation* print = new Method_invocation (
+			NULL,
+			new METHOD_NAME ("print"),
+			NULL);
+
+	if (not eval->expr->match (print))
+		return NULL;
+
+	Actual_parameter_list* params =
+		(dyc <Method_invocation> (eval->expr))->actual_parameters;
+
+	if (params->size () != 1)
+		return NULL;
+
+	Actual_parameter* param = params->front ();
+	if (param->is_ref)
+		return NULL;
+
+	if (isa<STRING> (param->expr) || isa<INT> (param->expr))
+		return dyc<Literal> (param->expr)->get_value_as_string ();
+
+	return NULL;
+}
+
+static Statement* print_string (Statement* in, String* value)
+{
+	Eval_expr* eval = dyc<Eval_expr> (in);
+	Method_invocation* print = dyc<Method_invocation> (eval->expr);
+	print->actual_parameters->front ()->expr = new STRING (value);
+	return in;
+}
+
+// Merge consecutive prints of literals, so that the program writes out the
+// text at once:
+//
+// Convert
+//	  print "<p>";
+//	  print 5;
+//	  print "</p>";
+//	into
+//	  print "<p>5</p>";
+//
+// Prints of the empty string are removed.
+Statement_list* Echo_split::transform_statement_list(Statement_list* in)
+{
+	Statement_list* split = Transform::transform_statement_list (in);
+	if (split == NULL)
+		return NULL;
+
+	Statement_list* out = new Statement_list;
+	String* pending = NULL;
+
+	foreach (Statement* s, *split)
+	{
+		String* value = get_printed_literal (s);
+		if (value == NULL)
+		{
+			out->push_back (s);
+			pending = NULL;
+		}
+		else if (value->size () == 0)
+			continue;
+		else if (pending == NULL)
+		{
+			// Later literals are appended to the same String
+			pending = new String (*value);
+			out->push_back (print_string (s, pending));
+		}
+		else
+			pending->append (*value);
+	}
+
+	return out;
+}
@@ -2,7 +2,7 @@
  * phc -- the open source PHP compiler
  * See doc/license/README.license for licensing information
  *
- * Convert echo()es to print()s
+ * Convert echo()es to print()s, and merge adjacent prints of literals
  */
 
 #ifndef PHC_ECHO_SPLIT_H
@@ -13,6 +13,7 @@
 class Echo_split : public AST::Transform, virtual public GC_obj
 {
 	void pre_eval_expr(AST::Eval_expr* in, AST::Statement_list* out);
+	AST::Statement_list* transform_statement_list(AST::Statement_list* in);
 };
 
 #endif // PHC_ECHO_SPLIT_H
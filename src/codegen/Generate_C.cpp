@@ -31,7 +31,9 @@
 //
 //	So that means casts are pure.
 
+#include <climits>
 #include <fstream>
+#include <iomanip>
 #include <boost/format.hpp>
 
 #include "lib/List.h"
@@ -44,6 +46,7 @@
 #include "codegen/Generate_C_annotations.h"
 #include "process_mir/MIR_to_AST.h"
 #include "pass_manager/Pass_manager.h"
+#include "optimize/Prune_symbol_table.h"
 
 #include "Generate_C.h"
 #include "parsing/MICG_parser.h"
@@ -81,6 +84,15 @@ static stringstream initializations;
 static stringstream embed_initializations;
 static stringstream finalizations;
 
+// Functions with a direct entry point, by lower-case name.
+static Map<string, string> direct_functions;
+
+static string
+get_direct_name (string name)
+{
+	return "phc_direct_" + name;
+}
+
 /*
  * Helper functions
  */
@@ -373,6 +385,178 @@ public:
 	}
 } op_functions;
 
+/*
+ * Unboxed locals (--unboxed-locals). Variables marked with
+ * phc.codegen.native_type by Generate_C_annotations are kept in a C variable
+ * native_$X. Their zval, local_$X, is only updated when a statement needs it.
+ */
+
+bool is_native (Rvalue* rvalue)
+{
+	return rvalue->attrs->has ("phc.codegen.native_type");
+}
+
+string get_native_name (String* var_name)
+{
+	return prefix (*var_name, "native");
+}
+
+// The C type of RVALUE, if it can be used without a zval, or NULL.
+String* get_native_type (Rvalue* rvalue)
+{
+	if (is_native (rvalue))
+		return rvalue->attrs->get_string ("phc.codegen.native_type");
+
+	if (isa<INT> (rvalue))
+		return s("long");
+
+	// Infinities and NaN dont have C literals.
+	if (REAL* real = dynamic_cast<REAL*> (rvalue))
+		if (real->value - real->value == 0)
+			return s("double");
+
+	if (isa<BOOL> (rvalue))
+		return s("zend_bool");
+
+	return NULL;
+}
+
+bool same_native_type (Rvalue* left, Rvalue* right)
+{
+	String* left_type = get_native_type (left);
+	String* right_type = get_native_type (right);
+
+	return left_type && right_type && *left_type == *right_type;
+}
+
+// A C expression for RVALUE, which must have a native type.
+string native_rvalue (Rvalue* rvalue)
+{
+	stringstream ss;
+	if (VARIABLE_NAME* var_name = dynamic_cast<VARIABLE_NAME*> (rvalue))
+	{
+		ss << get_native_name (var_name->value);
+	}
+	else if (INT* value = dynamic_cast<INT*> (rvalue))
+	{
+		// -LONG_MIN is not a valid long
+		if (value->value == LONG_MIN)
+			ss << "(-" << LONG_MAX << " - 1)";
+		else
+			ss << value->value;
+	}
+	else if (REAL* value = dynamic_cast<REAL*> (rvalue))
+	{
+		ss << setprecision (17) << value->value;
+
+		// Keep the C literal a double (and keep -0.0).
+		if (ss.str ().find_first_of (".e") == string::npos)
+			ss << ".0";
+	}
+	else if (BOOL* value = dynamic_cast<BOOL*> (rvalue))
+	{
+		ss << (value->value ? 1 : 0);
+	}
+	else
+		phc_unreachable ();
+
+	return ss.str ();
+}
+
+/*
+ * Packed arrays (--unboxed-locals). Arrays marked with phc.codegen.packed by
+ * Generate_C_annotations are kept in a phc_vector, vector_$X, while only the
+ * Pattern_vector_* patterns use them. Any other statement which uses one
+ * converts it to a HashTable in local_$X first.
+ */
+
+bool is_packed (Rvalue* rvalue)
+{
+	return rvalue->attrs->is_true ("phc.codegen.packed");
+}
+
+string get_vector_name (String* var_name)
+{
+	return prefix (*var_name, "vector");
+}
+
+/*
+ * String builders (--unboxed-locals). Locals marked with
+ * phc.codegen.string_builder by Generate_C_annotations are appended to in
+ * a phc_string_builder, builder_$X. Any other statement which uses one
+ * moves the string back into local_$X first.
+ */
+
+bool is_builder (Rvalue* rvalue)
+{
+	return rvalue->attrs->is_true ("phc.codegen.string_builder");
+}
+
+string get_builder_name (String* var_name)
+{
+	return prefix (*var_name, "builder");
+}
+
+string native_accessor (String* type)
+{
+	if (*type == "long")
+		return "Z_LVAL_P";
+	if (*type == "double")
+		return "Z_DVAL_P";
+
+	assert (*type == "zend_bool");
+	return "Z_BVAL_P";
+}
+
+string native_constructor (String* type)
+{
+	if (*type == "long")
+		return "ZVAL_LONG";
+	if (*type == "double")
+		return "ZVAL_DOUBLE";
+
+	assert (*type == "zend_bool");
+	return "ZVAL_BOOL";
+}
+
+// The C operator which computes OP on two values of TYPE, giving a
+// RESULT_TYPE, or "" if the Zend operator is needed. Comparisons of doubles
+// use the Zend operators, which treat NaN differently to C.
+string native_operator (string op, string type, string result_type, bool no_overflow)
+{
+	if (type == "long" && result_type == "long")
+	{
+		if (op == "+" || op == "-" || op == "*")
+			return no_overflow ? op : "";
+
+		if (op == "&" || op == "|" || op == "^")
+			return op;
+	}
+
+	if (type == "double" && result_type == "double")
+	{
+		if (op == "+" || op == "-" || op == "*")
+			return op;
+	}
+
+	if (type == "long" && result_type == "zend_bool")
+	{
+		if (op == "<" || op == "<=")
+			return op;
+	}
+
+	if ((type == "long" || type == "zend_bool") && result_type == "zend_bool")
+	{
+		if (op == "==" || op == "===")
+			return "==";
+
+		if (op == "!=" || op == "!==")
+			return "!=";
+	}
+
+	return "";
+}
+
 /*
  * Pattern definitions for statements
  */
@@ -414,11 +598,50 @@ string increment_stat (string name)
 class Pattern : virtual public GC_obj
 {
 public:
-	Pattern () : use_scope (true) {}
+	Pattern ()
+	: use_scope (true)
+	, native (false)
+	, vectors (new VARIABLE_NAME_list)
+	, builders (new VARIABLE_NAME_list)
+	{
+	}
+
 	virtual bool match(Statement* that) = 0;
 	virtual void generate_code(Generate_C* gen) = 0;
 	virtual ~Pattern() {}
 	bool use_scope;
+
+	// Native patterns dont need unboxed locals to be boxed.
+	bool native;
+
+	// The packed arrays which the pattern uses in their vector form. Any
+	// others in the statement are converted to HashTables first.
+	VARIABLE_NAME_list* vectors;
+
+	// Set by match(), if VAR is a packed array.
+	bool use_vector (Rvalue* var)
+	{
+		if (!is_packed (var))
+			return false;
+
+		vectors->push_back (dyc<VARIABLE_NAME> (var));
+		return true;
+	}
+
+	// The string builders which the pattern appends to. Any others in the
+	// statement are moved back into their zvals first.
+	VARIABLE_NAME_list* builders;
+
+	// Set by match(), if VAR is a string builder.
+	bool use_builder (Rvalue* var)
+	{
+		if (!is_builder (var))
+			return false;
+
+		builders->push_back (dyc<VARIABLE_NAME> (var));
+		return true;
+	}
+
 	stringstream buf;
 
 	string generate (String* comment, Generate_C* gen)
@@ -762,6 +985,8 @@ public:
 		// Use a different gen for the nested function
 		Generate_C* new_gen = new Generate_C(buf);
 		new_gen->micg = gen->micg;
+		if (signature->method_name->attrs->is_true ("phc.codegen.lazy_symbol_table"))
+			new_gen->lazy_st_vars = dyc<String_list> (pattern->value->attrs->get ("phc.codegen.lazy_st_vars"));
 		new_gen->visit_statement_list (pattern->value->statements);
 		buf << new_gen->body.str ();
 
@@ -810,6 +1035,14 @@ protected:
 			<< "PHP_METHOD(" << *class_name << ", "
 			<< *signature->method_name->value << ")\n";
 		}
+		else if (signature->attrs->is_true ("phc.codegen.direct_entry"))
+		{
+			// The PHP_FUNCTION is a wrapper, written in method_exit.
+			buf
+			<< "static void "
+			<< get_direct_name (*signature->method_name->value)
+			<< " (zval** direct_args, INTERNAL_FUNCTION_PARAMETERS)\n";
+		}
 		else
 		{
 			buf
@@ -822,7 +1055,8 @@ protected:
 		// __MAIN__ uses the global symbol table. Dont allocate for
 		// functions which dont need a symbol table.
 		if (*signature->method_name->value != "__MAIN__" 
-			&& not signature->method_name->attrs->is_true ("phc.codegen.st_entry_not_required"))
+			&& not signature->method_name->attrs->is_true ("phc.codegen.st_entry_not_required")
+			&& not signature->method_name->attrs->is_true ("phc.codegen.lazy_symbol_table"))
 		{
 			buf
 			<< "// Setup locals array\n"
@@ -833,6 +1067,13 @@ protected:
 			<< "EG(active_symbol_table) = locals;\n"
 			;
 		}
+		else if (signature->method_name->attrs->is_true ("phc.codegen.lazy_symbol_table"))
+		{
+			buf
+			<< "// The locals array is created when its first needed\n"
+			<< "HashTable* locals = NULL;\n"
+			;
+		}
 
 		// Declare variables which can go outside the symbol table
 		String_list* var_names = dyc<String_list> (pattern->value->attrs->get ("phc.codegen.non_st_vars"));
@@ -849,6 +1090,31 @@ protected:
 		foreach (String* iter, *iterators)
 			buf << "HashPosition " << *iter << ";\n";
 
+		// Declare unboxed locals
+		VARIABLE_NAME_list* unboxed = pattern->value->attrs->get_list<VARIABLE_NAME> ("phc.codegen.unboxed_vars");
+		foreach (VARIABLE_NAME* var, *unboxed)
+		{
+			buf
+			<< *var->attrs->get_string ("phc.codegen.native_type") << " "
+			<< get_native_name (var->value) << " = 0;\n";
+		}
+
+		// Declare packed arrays, and positions for foreach loops over them
+		VARIABLE_NAME_list* packed = pattern->value->attrs->get_list<VARIABLE_NAME> ("phc.codegen.packed_vars");
+		foreach (VARIABLE_NAME* var, *packed)
+			buf << "phc_vector* " << get_vector_name (var->value) << " = NULL;\n";
+
+		if (packed->size () > 0)
+		{
+			foreach (String* iter, *iterators)
+				buf << "long pos_" << *iter << " = -1;\n";
+		}
+
+		// Declare string builders
+		VARIABLE_NAME_list* builders = pattern->value->attrs->get_list<VARIABLE_NAME> ("phc.codegen.builder_vars");
+		foreach (VARIABLE_NAME* var, *builders)
+			buf << "phc_string_builder " << get_builder_name (var->value) << " = {NULL, 0, 0};\n";
+
 		// debug_argument_stack();
 
 		// TODO: the same variable may be used twice in the signature. This leads to a memory leak.
@@ -860,11 +1126,15 @@ protected:
 			<< "{\n"
 			<< "int num_args = MIN(ZEND_NUM_ARGS (), " << parameters->size() << ");\n"
 			<< "zval* params[" << parameters->size() << "];\n"
-			// First parameter to zend_get_parameters_array does not appear
-			// to be used (by looking at the source)
-			<< "zend_get_parameters_array(0, num_args, params);\n"
 			;
 
+			if (signature->attrs->is_true ("phc.codegen.direct_entry"))
+				buf << "memcpy (params, direct_args, num_args * sizeof (zval*));\n";
+			else
+				// First parameter to zend_get_parameters_array does not appear
+				// to be used (by looking at the source)
+				buf << "zend_get_parameters_array(0, num_args, params);\n";
+
 			int index = 0;
 			foreach (Formal_parameter* param, *parameters)
 			{
@@ -947,7 +1217,8 @@ protected:
 
 
 		if (*signature->method_name->value != "__MAIN__"
-			&& not signature->method_name->attrs->is_true ("phc.codegen.st_entry_not_required"))
+			&& not signature->method_name->attrs->is_true ("phc.codegen.st_entry_not_required")
+			&& not signature->method_name->attrs->is_true ("phc.codegen.lazy_symbol_table"))
 		{
 			buf
 			<< "// Destroy locals array\n"
@@ -956,6 +1227,17 @@ protected:
 			<< "EG(active_symbol_table) = old_active_symbol_table;\n"
 			;
 		}
+		else if (signature->method_name->attrs->is_true ("phc.codegen.lazy_symbol_table"))
+		{
+			buf
+			<< "// Destroy locals array\n"
+			<< "if (locals != NULL)\n"
+			<< "{\n"
+			<< "	zend_hash_destroy(locals);\n"
+			<< "	FREE_HASHTABLE(locals);\n"
+			<< "}\n"
+			;
+		}
 
 		// Cleanup local variables
 		String_list* var_names = dyc<String_list> (pattern->value->attrs->get ("phc.codegen.non_st_vars"));
@@ -974,6 +1256,24 @@ protected:
 			;
 		}
 
+		// Release packed arrays which are still vectors
+		VARIABLE_NAME_list* packed = pattern->value->attrs->get_list<VARIABLE_NAME> ("phc.codegen.packed_vars");
+		foreach (VARIABLE_NAME* var, *packed)
+		{
+			string name = get_vector_name (var->value);
+			buf
+			<< "if (" << name << " != NULL)\n"
+			<< "{\n"
+			<<		"phc_vector_release (" << name << ");\n"
+			<< "}\n"
+			;
+		}
+
+		// Release string builders which are still in use
+		VARIABLE_NAME_list* builders = pattern->value->attrs->get_list<VARIABLE_NAME> ("phc.codegen.builder_vars");
+		foreach (VARIABLE_NAME* var, *builders)
+			buf << "phc_builder_release (&" << get_builder_name (var->value) << ");\n";
+
 		// See comment in Method_invocation. We save the refcount of
 		// return_by_reference. Note that we get the wrong answer if we do this
 		// before the destructors have run, since we can't tell how many
@@ -992,6 +1292,61 @@ protected:
 		}
 
 		buf << "}\n" ;
+
+		if (signature->attrs->is_true ("phc.codegen.direct_entry"))
+			direct_entry_wrapper ();
+
+		if (signature->attrs->has ("phc.optimize.original_name"))
+			rename_specialization ();
+	}
+
+	// A specialized clone is known to the engine under its own name, but
+	// shows the name of the function it was cloned from.
+	void rename_specialization ()
+	{
+		String* name = signature->method_name->value->to_lower ();
+		String* original = signature->attrs->get_string ("phc.optimize.original_name");
+
+		minit
+		<< "{\n"
+		<< "zend_function* clone;\n"
+		<< "int result = zend_hash_find ("
+		<<		"CG (function_table), "
+		<<		"\"" << *name << "\", "
+		<<		(name->size () + 1) << ", "
+		<<		"(void**) &clone);\n"
+		<< "assert (result == SUCCESS);\n"
+		<< "clone->common.function_name = \"" << *original << "\";\n"
+		<< "}\n"
+		;
+	}
+
+	// Callers outside this module reach direct entry points through the
+	// PHP_FUNCTION.
+	void direct_entry_wrapper ()
+	{
+		string name = *signature->method_name->value;
+		int num_params = 0;
+		if (signature->formal_parameters)
+			num_params = signature->formal_parameters->size ();
+
+		buf
+		<< "PHP_FUNCTION" << "(" << name << ")\n"
+		<< "{\n"
+		;
+
+		if (num_params > 0)
+		{
+			buf
+			<< "zval* direct_args[" << num_params << "];\n"
+			<< "zend_get_parameters_array(0, MIN(ZEND_NUM_ARGS (), " << num_params << "), direct_args);\n"
+			<< get_direct_name (name) << " (direct_args, INTERNAL_FUNCTION_PARAM_PASSTHRU);\n"
+			;
+		}
+		else
+			buf << get_direct_name (name) << " (NULL, INTERNAL_FUNCTION_PARAM_PASSTHRU);\n";
+
+		buf << "}\n";
 	}
 };
 
@@ -1015,7 +1370,13 @@ public:
 	{
 		lhs = new Wildcard<VARIABLE_NAME>;
 		agn = new Assign_var (lhs, /* ignored */ false, rhs_pattern ());
-		return (that->match (agn));
+		if (!that->match (agn))
+			return false;
+
+		// Matching doesnt copy the optimizer's annotations, such as
+		// phc.optimize.array_size.
+		agn->attrs = that->attrs;
+		return true;
 	}
 
 protected:
@@ -1210,6 +1571,13 @@ public:
 		// No other casts are allowed.
 		assert (symnames.has (*cast->value->value));
 
+		if (agn->attrs->has ("phc.optimize.array_size"))
+		{
+			::Integer* size = agn->attrs->get_integer ("phc.optimize.array_size");
+			INST (buf, "assign_expr_new_array",
+					lhs->value, s(lexical_cast<string> (size->value ())));
+			return;
+		}
 
 		INST (buf, "assign_expr_cast",
 				lhs->value, rhs->value, s(symnames[*cast->value->value]));
@@ -1263,6 +1631,16 @@ public:
 		return new Bin_op (left, op, right); 
 	}
 
+	bool match (Statement* that)
+	{
+		if (!Pattern_assign_var::match (that))
+			return false;
+
+		// The templates use the annotations on the Bin_op itself.
+		bin_op = dyc<Bin_op> (dyc<Assign_var> (that)->rhs);
+		return true;
+	}
+
 	void generate_code (Generate_C* gen)
 	{
 		assert (lhs);
@@ -1272,11 +1650,12 @@ public:
 		string op_fn = op_functions[*op->value->value];
 
 		INST (buf, "assign_expr_bin_op",
-				lhs->value, left->value, right->value, s(op_fn));
+				lhs->value, left->value, right->value, s(op_fn), bin_op);
 	}
 
 
 protected:
+	Bin_op* bin_op;
 	Wildcard<Rvalue>* left;
 	Wildcard<OP>* op;
 	Wildcard<Rvalue>* right;
@@ -1490,6 +1869,7 @@ protected:
 
 class Pattern_assign_expr_foreach_has_key : public Pattern_assign_var
 {
+public:
 	Expr* rhs_pattern()
 	{
 		has_key = new Wildcard<Foreach_has_key>;
@@ -1508,6 +1888,7 @@ protected:
 
 class Pattern_assign_expr_foreach_get_key : public Pattern_assign_var
 {
+public:
 	Expr* rhs_pattern()
 	{
 		get_key = new Wildcard<Foreach_get_key>;
@@ -1526,6 +1907,7 @@ protected:
 
 class Pattern_assign_expr_foreach_get_val : public Pattern_assign_var
 {
+public:
 	Expr* rhs_pattern()
 	{
 		get_val = new Wildcard<Foreach_get_val>;
@@ -1616,6 +1998,21 @@ protected:
 	Wildcard<Actual_parameter>* arg;
 };
 
+/*
+ * The number of classes whose methods a method call site caches: all of the
+ * receiver's classes when the optimizer knows them, else the last few.
+ */
+#define METHOD_CACHE_SIZE 4
+
+static int
+method_cache_size (Node* call)
+{
+	if (call->attrs->has ("phc.optimize.receiver_classes"))
+		return call->attrs->get_integer ("phc.optimize.receiver_classes")->value ();
+
+	return METHOD_CACHE_SIZE;
+}
+
 class Pattern_assign_expr_param_is_ref : public Pattern_assign_var
 {
 public:
@@ -1628,6 +2025,22 @@ public:
 	void generate_code (Generate_C* gen)
 	{
 		assert (!agn->is_ref);
+
+		if (Variable_method* var_method = dynamic_cast<Variable_method*> (rhs->value->method_name))
+		{
+			if (rhs->value->target != NULL)
+				phc_unsupported (rhs->value, "variable method");
+
+			INST (buf, "assign_param_is_ref_variable_function",
+					rhs->value->get_filename (),
+					s(lexical_cast<string> (rhs->value->get_line_number ())),
+					s(lexical_cast<string> (rhs->value->param_index->value)),
+					var_method->variable_name,
+					lhs->value);
+
+			return;
+		}
+
 		string function_name = *dyc<METHOD_NAME> (rhs->value->method_name)->value;
 		string fci_name = suffix (function_name, "fci");
 		string fcic_name = suffix (function_name, "fcic");
@@ -1640,20 +2053,15 @@ public:
 
 			if(object_name != NULL)
 			{
-				// TODO: if we statically knew the type of the object that is
-				// invoked (type inference) then we should be able to use
-				// the cached function info. As it stands, we have to
-				// lookup the function every time since the variable can be
-				// bound to a different class every time we encounter this
-				// statement
-		
+				// See Pattern_expr_method_invocation.
 				INST (buf, "assign_param_is_ref_method", 
 						s(function_name),
 						rhs->value->get_filename (),
 						s(lexical_cast<string> (rhs->value->get_line_number ())),
 						s(lexical_cast<string> (rhs->value->param_index->value)),
 						object_name,
-						lhs->value);
+						lhs->value,
+						s(lexical_cast<string> (method_cache_size (rhs->value))));
 
 				return;
 			}
@@ -1730,7 +2138,23 @@ public:
 
 		// Variable function or ordinary function?
 		METHOD_NAME* name = dynamic_cast<METHOD_NAME*>(rhs->value->method_name);
-		if (name == NULL) phc_unsupported (rhs->value, "variable function");
+		if (name == NULL)
+		{
+			if (rhs->value->target != NULL)
+				phc_unsupported (rhs->value, "variable method");
+
+			INST (buf, "variable_function_invocation",
+					rhs->value,
+					params,
+					rhs->value->get_filename (),
+					s(lexical_cast<string> (rhs->value->get_line_number ())),
+					s(lexical_cast<string>(rhs->value->actual_parameters->size ())),
+					dyc<Variable_method> (rhs->value->method_name)->variable_name,
+					lhs_descriptor,
+					lhs ? lhs->value : NULL);
+
+			return;
+		}
 
 		// Names of the runtime variables that will hold the (potentially
 		// cached) location of the function
@@ -1747,13 +2171,11 @@ public:
 
 			if(object_name != NULL)
 			{
-				// TODO: if we statically knew the type of the object that is
-				// invoked (type inference) then we should be able to use
-				// the cached function info. As it stands, we have to
-				// lookup the function every time since the variable can be
-				// bound to a different class every time we encounter this
-				// statement
-		
+				// Each call site caches the method it finds for each class of
+				// receiver. If we know the receiver can only be an object of
+				// one of a few classes, the cache holds all of them. Otherwise
+				// the variable can be bound to a different class every time
+				// we encounter this statement, and we keep the last few.
 				function_name = *name->value;
 
 				INST (buf, "method_invocation",
@@ -1765,7 +2187,8 @@ public:
 						s(lexical_cast<string>(rhs->value->actual_parameters->size ())),
 						object_name,
 						lhs_descriptor,
-						lhs ? lhs->value : NULL);
+						lhs ? lhs->value : NULL,
+						s(lexical_cast<string> (method_cache_size (rhs->value))));
 
 				return;
 			}
@@ -1786,6 +2209,25 @@ public:
 			fci_name  = suffix (*name->value, "fci");
 			fcic_name = suffix (*name->value, "fcic");
 			function_name = *name->value;
+
+			// Functions in this module may be called directly.
+			string lc_name = *name->value->to_lower ();
+			if (direct_functions.has (lc_name))
+			{
+				INST (buf, "direct_function_invocation",
+						rhs->value,
+						s(direct_functions[lc_name]),
+						params,
+						rhs->value->get_filename (),
+						s(lexical_cast<string> (rhs->value->get_line_number ())),
+						s(fci_name),
+						s(fcic_name),
+						s(lexical_cast<string>(rhs->value->actual_parameters->size ())),
+						lhs_descriptor,
+						lhs ? lhs->value : NULL);
+
+				return;
+			}
 		}
 
 		INST (buf, "function_invocation",
@@ -2161,6 +2603,7 @@ protected:
 
 class Pattern_return : public Pattern
 {
+public:
 	bool match(Statement* that)
 	{
 		ret = new Wildcard<Return>;
@@ -2206,6 +2649,7 @@ protected:
  */
 class Pattern_unset : public Pattern
 {
+public:
 	bool match(Statement* that)
 	{
 		unset = new Wildcard<Unset>;
@@ -2443,6 +2887,7 @@ protected:
 
 class Pattern_foreach_reset : public Pattern
 {
+public:
 	bool match (Statement* that)
 	{
 		reset = new Wildcard<Foreach_reset>;
@@ -2461,6 +2906,7 @@ protected:
 
 class Pattern_foreach_next : public Pattern
 {
+public:
 	bool match (Statement* that)
 	{
 		next = new Wildcard<Foreach_next>;
@@ -2479,6 +2925,7 @@ protected:
 
 class Pattern_foreach_end : public Pattern
 {
+public:
 	bool match (Statement* that)
 	{
 		end = new Wildcard<Foreach_end>;
@@ -2495,57 +2942,721 @@ protected:
 	Wildcard<Foreach_end>* end;
 };
 
-
-
 /*
- * Visitor methods to generate C code
- * Visitor for statements uses the patterns defined above.
+ * Unboxed locals. These only match if all the variables are unboxed.
  */
 
-string Generate_C::compile_statement(Statement* in)
+class Pattern_native_assign_literal : public Pattern_assign_literal
 {
-	// TODO: this should be static, but making it static causes a segfault
-	// TODO: possibly due to a pattern assuming all of its local state is reset?
-	Pattern* patterns[] = 
+public:
+	Pattern_native_assign_literal () { native = true; }
+
+	bool match (Statement* that)
 	{
-	// Top-level constructs
-		new Pattern_method_definition ()
-	,  new Pattern_class_def ()
-	// Expressions, which can only be RHSs to Assign_vars
-	,	new Pattern_assign_expr_constant ()
-	,	new Pattern_assign_expr_var ()
-	,	new Pattern_assign_expr_var_var ()
-	,	new Pattern_assign_expr_array_access ()
-	// TODO: array_next
-	,	new Pattern_assign_expr_param_is_ref ()
-	,	new Pattern_assign_expr_isset()
-	,	new Pattern_assign_expr_bin_op()
-	,	new Pattern_assign_expr_unary_op()
-	,	new Pattern_assign_expr_cast ()
-	,	new Pattern_assign_expr_foreach_has_key ()
-	,	new Pattern_assign_expr_foreach_get_key ()
-	,	new Pattern_assign_expr_foreach_get_val ()
-	// Literals are special, as they constant pool, and can be used as Rvalues
-	,	new Pattern_assign_literal ()
-	// Method invocations and NEWs can be part of Eval_expr or just Assign_vars
-	,	new Pattern_expr_builtin()
-	,	new Pattern_expr_method_invocation()
-	// OOP
-	, new Pattern_assign_field()
-	, new Pattern_assign_expr_field_access()
-	, new Pattern_assign_expr_new()
-	// All the rest are just statements
-	,	new Pattern_assign_array ()
-	,	new Pattern_assign_next ()
-	,  new Pattern_assign_var_var ()
-	,	new Pattern_class_or_interface_alias ()
-	,	new Pattern_method_alias ()
-	,	new Pattern_branch()
-	,	new Pattern_goto()
-	,	new Pattern_label()
-	,	new Pattern_foreach_end ()
-	,	new Pattern_foreach_next ()
-	,	new Pattern_foreach_reset ()
+		return Pattern_assign_literal::match (that)
+			&& is_native (lhs->value)
+			&& same_native_type (lhs->value, rhs->value);
+	}
+
+	void generate_code (Generate_C* gen)
+	{
+		INST (buf, "native_assign", lhs->value, s(native_rvalue (rhs->value)));
+	}
+};
+
+class Pattern_native_assign_var : public Pattern_assign_expr_var
+{
+public:
+	Pattern_native_assign_var () { native = true; }
+
+	bool match (Statement* that)
+	{
+		return Pattern_assign_expr_var::match (that)
+			&& !agn->is_ref
+			&& is_native (lhs->value)
+			&& is_native (rhs->value)
+			&& same_native_type (lhs->value, rhs->value);
+	}
+
+	void generate_code (Generate_C* gen)
+	{
+		INST (buf, "native_assign", lhs->value, s(native_rvalue (rhs->value)));
+	}
+};
+
+class Pattern_native_assign_bin_op : public Pattern_assign_expr_bin_op
+{
+public:
+	Pattern_native_assign_bin_op () { native = true; }
+
+	bool match (Statement* that)
+	{
+		if (!Pattern_assign_expr_bin_op::match (that))
+			return false;
+
+		if (!is_native (lhs->value)
+			|| (!is_native (left->value) && !is_native (right->value))
+			|| !same_native_type (left->value, right->value))
+			return false;
+
+		c_op = native_operator (
+			*op->value->value,
+			*get_native_type (left->value),
+			*get_native_type (lhs->value),
+			bin_op->attrs->is_true ("phc.optimize.no_overflow"));
+
+		return c_op != "";
+	}
+
+	void generate_code (Generate_C* gen)
+	{
+		INST (buf, "native_assign_bin_op",
+				lhs->value,
+				s(native_rvalue (left->value)),
+				s(c_op),
+				s(native_rvalue (right->value)));
+	}
+
+protected:
+	string c_op;
+};
+
+class Pattern_native_assign_unary_op : public Pattern_assign_expr_unary_op
+{
+public:
+	Pattern_native_assign_unary_op () { native = true; }
+
+	bool match (Statement* that)
+	{
+		return Pattern_assign_expr_unary_op::match (that)
+			&& (*op->value->value == "!" || *op->value->value == "not")
+			&& is_native (lhs->value)
+			&& is_native (rhs->value)
+			&& *get_native_type (lhs->value) == "zend_bool";
+	}
+
+	void generate_code (Generate_C* gen)
+	{
+		INST (buf, "native_assign",
+				lhs->value, s("!" + native_rvalue (rhs->value)));
+	}
+};
+
+class Pattern_native_pre_op : public Pattern_pre_op
+{
+public:
+	Pattern_native_pre_op () { native = true; }
+
+	bool match (Statement* that)
+	{
+		if (!Pattern_pre_op::match (that) || !is_native (var->value))
+			return false;
+
+		string type = *get_native_type (var->value);
+		return type == "double"
+			|| (type == "long" && that->attrs->is_true ("phc.optimize.no_overflow"));
+	}
+
+	void generate_code (Generate_C* gen)
+	{
+		INST (buf, "native_pre_op", var->value, op->value->value);
+	}
+};
+
+class Pattern_native_branch : public Pattern_branch
+{
+public:
+	Pattern_native_branch () { native = true; }
+
+	bool match (Statement* that)
+	{
+		return Pattern_branch::match (that)
+			&& is_native (cond->value);
+	}
+
+	void generate_code (Generate_C* gen)
+	{
+		INST (buf, "native_branch",
+			cond->value, iftrue->value->value, iffalse->value->value);
+	}
+};
+
+class Pattern_native_return : public Pattern_return
+{
+public:
+	Pattern_native_return () { native = true; }
+
+	bool match (Statement* that)
+	{
+		return Pattern_return::match (that)
+			&& is_native (ret->value->rvalue)
+			&& !ret->value->attrs->is_true ("phc.codegen.return_by_ref");
+	}
+
+	void generate_code (Generate_C* gen)
+	{
+		INST (buf, "native_return",
+			ret->value->rvalue,
+			s(native_constructor (get_native_type (ret->value->rvalue))));
+	}
+};
+
+/*
+ * Packed arrays. These match statements which use a packed array in a way a
+ * vector supports. The templates check that the array is still a vector, and
+ * use the generic templates if it is not.
+ */
+
+class Pattern_vector_new_array : public Pattern_assign_expr_cast
+{
+public:
+	bool match (Statement* that)
+	{
+		if (!Pattern_assign_expr_cast::match (that)
+			|| agn->is_ref
+			|| !agn->attrs->is_true ("phc.optimize.packed_array")
+			|| !use_vector (lhs->value))
+			return false;
+
+		// The operand is NULL, so it isnt read.
+		use_vector (rhs->value);
+		return true;
+	}
+
+	void generate_code (Generate_C* gen)
+	{
+		long size = 0;
+		if (agn->attrs->has ("phc.optimize.array_size"))
+			size = agn->attrs->get_integer ("phc.optimize.array_size")->value ();
+
+		INST (buf, "assign_expr_new_vector",
+			lhs->value, s(lexical_cast<string> (size)));
+	}
+};
+
+class Pattern_vector_assign_var : public Pattern_assign_expr_var
+{
+public:
+	bool match (Statement* that)
+	{
+		if (!Pattern_assign_expr_var::match (that)
+			|| agn->is_ref
+			|| !is_packed (lhs->value)
+			|| !is_packed (rhs->value))
+			return false;
+
+		use_vector (lhs->value);
+		use_vector (rhs->value);
+		return true;
+	}
+
+	void generate_code (Generate_C* gen)
+	{
+		INST (buf, "vector_assign_var", lhs->value, rhs->value);
+	}
+};
+
+class Pattern_vector_assign_expr_array_access : public Pattern_assign_expr_array_access
+{
+public:
+	bool match (Statement* that)
+	{
+		return Pattern_assign_expr_array_access::match (that)
+			&& !agn->is_ref
+			&& use_vector (rhs->value->variable_name);
+	}
+
+	void generate_code (Generate_C* gen)
+	{
+		INST (buf, "vector_assign_expr_array_access",
+			lhs->value, rhs->value->variable_name, rhs->value->index);
+	}
+};
+
+class Pattern_vector_assign_array : public Pattern_assign_array
+{
+public:
+	bool match (Statement* that)
+	{
+		return Pattern_assign_array::match (that)
+			&& !agn->is_ref
+			&& use_vector (lhs->value);
+	}
+
+	void generate_code (Generate_C* gen)
+	{
+		INST (buf, "vector_assign_array", lhs->value, index->value, rhs->value);
+	}
+};
+
+class Pattern_vector_assign_next : public Pattern_assign_next
+{
+public:
+	bool match (Statement* that)
+	{
+		return Pattern_assign_next::match (that)
+			&& !agn->is_ref
+			&& use_vector (lhs->value);
+	}
+
+	void generate_code (Generate_C* gen)
+	{
+		INST (buf, "vector_assign_next", lhs->value, rhs->value);
+	}
+};
+
+// $x = count ($a); or $x = is_array ($a);
+class Pattern_vector_builtin : public Pattern_expr_method_invocation
+{
+public:
+	bool match (Statement* that)
+	{
+		if (!Pattern_expr_method_invocation::match (that)
+			|| lhs == NULL
+			|| agn->is_ref
+			|| rhs->value->target != NULL)
+			return false;
+
+		METHOD_NAME* name = dynamic_cast<METHOD_NAME*> (rhs->value->method_name);
+		if (name == NULL
+			|| (*name->value != "count" && *name->value != "is_array"))
+			return false;
+
+		Actual_parameter_list* params = rhs->value->actual_parameters;
+		if (params->size () != 1 || params->front ()->is_ref)
+			return false;
+
+		array = params->front ()->rvalue;
+		return use_vector (array);
+	}
+
+	// The call is only made if the array isnt a vector.
+	void generate_code (Generate_C* gen)
+	{
+		METHOD_NAME* name = dyc<METHOD_NAME> (rhs->value->method_name);
+
+		buf
+		<< "if (" << get_vector_name (dyc<VARIABLE_NAME> (array)->value) << " != NULL)\n"
+		<< "{\n"
+		;
+		INST (buf, "vector_" + *name->value, lhs->value, array);
+		buf
+		<< "}\n"
+		<< "else\n"
+		<< "{\n"
+		;
+		Pattern_expr_method_invocation::generate_code (gen);
+		buf << "}\n";
+	}
+
+protected:
+	Rvalue* array;
+};
+
+class Pattern_vector_unset : public Pattern_unset
+{
+public:
+	bool match (Statement* that)
+	{
+		return Pattern_unset::match (that)
+			&& unset->value->array_indices->size () == 0
+			&& isa<VARIABLE_NAME> (unset->value->variable_name)
+			&& use_vector (dyc<VARIABLE_NAME> (unset->value->variable_name));
+	}
+
+	void generate_code (Generate_C* gen)
+	{
+		INST (buf, "vector_unset", unset->value->variable_name);
+		Pattern_unset::generate_code (gen);
+	}
+};
+
+class Pattern_vector_foreach_reset : public Pattern_foreach_reset
+{
+public:
+	bool match (Statement* that)
+	{
+		return Pattern_foreach_reset::match (that)
+			&& use_vector (reset->value->array);
+	}
+
+	void generate_code (Generate_C* gen)
+	{
+		INST (buf, "vector_foreach_reset",
+			reset->value->array, reset->value->iter->value);
+	}
+};
+
+class Pattern_vector_foreach_next : public Pattern_foreach_next
+{
+public:
+	bool match (Statement* that)
+	{
+		return Pattern_foreach_next::match (that)
+			&& use_vector (next->value->array);
+	}
+
+	void generate_code (Generate_C* gen)
+	{
+		INST (buf, "vector_foreach_next",
+			next->value->array, next->value->iter->value);
+	}
+};
+
+class Pattern_vector_foreach_end : public Pattern_foreach_end
+{
+public:
+	bool match (Statement* that)
+	{
+		return Pattern_foreach_end::match (that)
+			&& use_vector (end->value->array);
+	}
+
+	void generate_code (Generate_C* gen)
+	{
+		INST (buf, "vector_foreach_end",
+			end->value->array, end->value->iter->value);
+	}
+};
+
+class Pattern_vector_foreach_has_key : public Pattern_assign_expr_foreach_has_key
+{
+public:
+	bool match (Statement* that)
+	{
+		return Pattern_assign_expr_foreach_has_key::match (that)
+			&& use_vector (has_key->value->array);
+	}
+
+	void generate_code (Generate_C* gen)
+	{
+		INST (buf, "vector_foreach_has_key",
+			lhs->value, has_key->value->array, has_key->value->iter->value);
+	}
+};
+
+class Pattern_vector_foreach_get_key : public Pattern_assign_expr_foreach_get_key
+{
+public:
+	bool match (Statement* that)
+	{
+		return Pattern_assign_expr_foreach_get_key::match (that)
+			&& use_vector (get_key->value->array);
+	}
+
+	void generate_code (Generate_C* gen)
+	{
+		INST (buf, "vector_foreach_get_key",
+			lhs->value, get_key->value->array, get_key->value->iter->value);
+	}
+};
+
+class Pattern_vector_foreach_get_val : public Pattern_assign_expr_foreach_get_val
+{
+public:
+	bool match (Statement* that)
+	{
+		return Pattern_assign_expr_foreach_get_val::match (that)
+			&& !agn->is_ref
+			&& use_vector (get_val->value->array);
+	}
+
+	void generate_code (Generate_C* gen)
+	{
+		INST (buf, "vector_foreach_get_val",
+			lhs->value, get_val->value->array, get_val->value->iter->value);
+	}
+};
+
+/*
+ * String builders. The template checks that the variable is not a
+ * reference, and uses concat_function if it is.
+ */
+
+class Pattern_builder_append : public Pattern_assign_expr_bin_op
+{
+public:
+	bool match (Statement* that)
+	{
+		if (!Pattern_assign_expr_bin_op::match (that)
+			|| agn->is_ref
+			|| *op->value->value != "."
+			|| !is_builder (lhs->value))
+			return false;
+
+		VARIABLE_NAME* var = dynamic_cast<VARIABLE_NAME*> (left->value);
+		if (var == NULL || *var->value != *lhs->value->value)
+			return false;
+
+		use_builder (lhs->value);
+		use_builder (var);
+		return true;
+	}
+
+	void generate_code (Generate_C* gen)
+	{
+		INST (buf, "builder_append",
+			lhs->value, left->value, right->value, bin_op);
+	}
+};
+
+/*
+ * Find the packed arrays which a statement uses, other than those in
+ * VECTORS.
+ */
+class Packed_array_collector : public MIR::Visitor, virtual public GC_obj
+{
+public:
+	VARIABLE_NAME_list* vectors;
+	Map<string, VARIABLE_NAME*> vars;
+
+	Packed_array_collector (VARIABLE_NAME_list* vectors)
+	: vectors (vectors)
+	{
+	}
+
+	void pre_variable_name (VARIABLE_NAME* in)
+	{
+		if (is_packed (in) && !vectors->has (in))
+			vars[*in->value] = in;
+	}
+};
+
+// Convert the packed arrays which IN uses, but whose vectors PATTERN doesnt
+// handle, to HashTables.
+string Generate_C::unpack_arrays (Statement* in, Pattern* pattern)
+{
+	Generate_C* gen = this;
+	Packed_array_collector* collector = new Packed_array_collector (pattern->vectors);
+	in->visit (collector);
+
+	stringstream ss;
+	foreach (VARIABLE_NAME* var, *collector->vars.values ())
+		INST (ss, "unpack_array", var);
+
+	return ss.str ();
+}
+
+/*
+ * Find the string builders which a statement uses, other than those in
+ * BUILDERS.
+ */
+class String_builder_collector : public MIR::Visitor, virtual public GC_obj
+{
+public:
+	VARIABLE_NAME_list* builders;
+	Map<string, VARIABLE_NAME*> vars;
+
+	String_builder_collector (VARIABLE_NAME_list* builders)
+	: builders (builders)
+	{
+	}
+
+	void pre_variable_name (VARIABLE_NAME* in)
+	{
+		if (is_builder (in) && !builders->has (in))
+			vars[*in->value] = in;
+	}
+};
+
+// Move the strings which IN uses, but whose builders PATTERN doesnt
+// handle, back into their zvals.
+string Generate_C::finish_builders (Statement* in, Pattern* pattern)
+{
+	Generate_C* gen = this;
+	String_builder_collector* collector = new String_builder_collector (pattern->builders);
+	in->visit (collector);
+
+	stringstream ss;
+	foreach (VARIABLE_NAME* var, *collector->vars.values ())
+		INST (ss, "finish_builder", var);
+
+	return ss.str ();
+}
+
+/*
+ * Find the unboxed locals used in a statement.
+ */
+class Native_local_collector : public MIR::Visitor, virtual public GC_obj
+{
+public:
+	Map<string, VARIABLE_NAME*> vars;
+
+	void pre_variable_name (VARIABLE_NAME* in)
+	{
+		if (is_native (in))
+			vars[*in->value] = in;
+	}
+};
+
+// Update the zvals of the unboxed locals which IN uses.
+string Generate_C::box_locals (Statement* in)
+{
+	Generate_C* gen = this;
+	Native_local_collector* collector = new Native_local_collector;
+
+	// The LHS is overwritten, so its value isnt needed.
+	if (Assign_var* assign_var = dynamic_cast<Assign_var*> (in))
+		assign_var->rhs->visit (collector);
+	else
+		in->visit (collector);
+
+	stringstream ss;
+	foreach (VARIABLE_NAME* var, *collector->vars.values ())
+	{
+		INST (ss, "box_local", var,
+			s(native_constructor (get_native_type (var))));
+	}
+
+	return ss.str ();
+}
+
+// Update the unboxed local which IN defines from its zval.
+string Generate_C::unbox_locals (Statement* in)
+{
+	Generate_C* gen = this;
+	VARIABLE_NAME* def = NULL;
+
+	if (Assign_var* assign_var = dynamic_cast<Assign_var*> (in))
+		def = assign_var->lhs;
+	else if (Pre_op* pre_op = dynamic_cast<Pre_op*> (in))
+		def = pre_op->variable_name;
+
+	stringstream ss;
+	if (def && is_native (def))
+	{
+		INST (ss, "unbox_local", def,
+			s(native_accessor (get_native_type (def))));
+	}
+
+	return ss.str ();
+}
+
+// Release the locals which die after IN, rather than at the end of the
+// function. Unboxed locals have nothing worth releasing.
+string Generate_C::release_dead_locals (Statement* in)
+{
+	if (!in->attrs->has ("phc.optimize.dead_locals"))
+		return "";
+
+	Generate_C* gen = this;
+	stringstream ss;
+	foreach (VARIABLE_NAME* var, *in->attrs->get_list<VARIABLE_NAME> ("phc.optimize.dead_locals"))
+	{
+		if (!is_native (var) && var->attrs->is_true ("phc.optimize.releasable"))
+			INST (ss, "release_local", var);
+	}
+
+	return ss.str ();
+}
+
+
+// In a method with a lazy symbol table, copy the locals into the symbol
+// table before CODE, if IN uses the symbol table, and copy them back out
+// after.
+string Generate_C::sync_symbol_table (Statement* in, string code)
+{
+	if (lazy_st_vars == NULL || !uses_symbol_table (in))
+		return code;
+
+	Generate_C* gen = this;
+	stringstream ss;
+
+	ss
+	<< "{\n"
+	<< "HashTable* caller_symbol_table = phc_begin_symbol_table (&locals TSRMLS_CC);\n"
+	;
+
+	foreach (String* var, *lazy_st_vars)
+		INST (ss, "sync_into_symbol_table", var);
+
+	ss << code;
+
+	foreach (String* var, *lazy_st_vars)
+		INST (ss, "sync_from_symbol_table", var);
+
+	ss
+	<< "EG(active_symbol_table) = caller_symbol_table;\n"
+	<< "}\n"
+	;
+
+	return ss.str ();
+}
+
+
+/*
+ * Visitor methods to generate C code
+ * Visitor for statements uses the patterns defined above.
+ */
+
+string Generate_C::compile_statement(Statement* in)
+{
+	// TODO: this should be static, but making it static causes a segfault
+	// TODO: possibly due to a pattern assuming all of its local state is reset?
+	Pattern* patterns[] = 
+	{
+	// Top-level constructs
+		new Pattern_method_definition ()
+	,  new Pattern_class_def ()
+	// Unboxed locals must come before the general patterns
+	,	new Pattern_native_assign_literal ()
+	,	new Pattern_native_assign_var ()
+	,	new Pattern_native_assign_bin_op ()
+	,	new Pattern_native_assign_unary_op ()
+	,	new Pattern_native_pre_op ()
+	,	new Pattern_native_branch ()
+	,	new Pattern_native_return ()
+	// So must packed arrays
+	,	new Pattern_vector_new_array ()
+	,	new Pattern_vector_assign_var ()
+	,	new Pattern_vector_assign_expr_array_access ()
+	,	new Pattern_vector_assign_array ()
+	,	new Pattern_vector_assign_next ()
+	,	new Pattern_vector_builtin ()
+	,	new Pattern_vector_unset ()
+	,	new Pattern_vector_foreach_reset ()
+	,	new Pattern_vector_foreach_next ()
+	,	new Pattern_vector_foreach_end ()
+	,	new Pattern_vector_foreach_has_key ()
+	,	new Pattern_vector_foreach_get_key ()
+	,	new Pattern_vector_foreach_get_val ()
+	// And string builders
+	,	new Pattern_builder_append ()
+	// Expressions, which can only be RHSs to Assign_vars
+	,	new Pattern_assign_expr_constant ()
+	,	new Pattern_assign_expr_var ()
+	,	new Pattern_assign_expr_var_var ()
+	,	new Pattern_assign_expr_array_access ()
+	// TODO: array_next
+	,	new Pattern_assign_expr_param_is_ref ()
+	,	new Pattern_assign_expr_isset()
+	,	new Pattern_assign_expr_bin_op()
+	,	new Pattern_assign_expr_unary_op()
+	,	new Pattern_assign_expr_cast ()
+	,	new Pattern_assign_expr_foreach_has_key ()
+	,	new Pattern_assign_expr_foreach_get_key ()
+	,	new Pattern_assign_expr_foreach_get_val ()
+	// Literals are special, as they constant pool, and can be used as Rvalues
+	,	new Pattern_assign_literal ()
+	// Method invocations and NEWs can be part of Eval_expr or just Assign_vars
+	,	new Pattern_expr_builtin()
+	,	new Pattern_expr_method_invocation()
+	// OOP
+	, new Pattern_assign_field()
+	, new Pattern_assign_expr_field_access()
+	, new Pattern_assign_expr_new()
+	// All the rest are just statements
+	,	new Pattern_assign_array ()
+	,	new Pattern_assign_next ()
+	,  new Pattern_assign_var_var ()
+	,	new Pattern_class_or_interface_alias ()
+	,	new Pattern_method_alias ()
+	,	new Pattern_branch()
+	,	new Pattern_goto()
+	,	new Pattern_label()
+	,	new Pattern_foreach_end ()
+	,	new Pattern_foreach_next ()
+	,	new Pattern_foreach_reset ()
 	,	new Pattern_global()
 	,	new Pattern_return()
 	,	new Pattern_unset()
@@ -2573,7 +3684,19 @@ string Generate_C::compile_statement(Statement* in)
 	{
 		if(pattern->match(in))
 		{
-			return pattern->generate (s(comment.str()), this);
+			if (isa<Method> (in) || isa<Class_def> (in))
+				return pattern->generate (s(comment.str()), this);
+
+			if (pattern->native)
+				return pattern->generate (s(comment.str()), this)
+					+ release_dead_locals (in);
+
+			return unpack_arrays (in, pattern)
+				+ finish_builders (in, pattern)
+				+ box_locals (in)
+				+ sync_symbol_table (in, pattern->generate (s(comment.str()), this))
+				+ unbox_locals (in)
+				+ release_dead_locals (in);
 		}
 	}
 	phc_unsupported (in, "unknown construct");
@@ -2634,6 +3757,7 @@ void Generate_C::pre_php_script(PHP_script* in)
 	include_file (prologue, s("support.c"));
 	include_file (prologue, s("debug.c"));
 	include_file (prologue, s("zval.c"));
+	include_file (prologue, s("operators.c"));
 	include_file (prologue, s("string.c"));
 	include_file (prologue, s("arrays.c"));
 	include_file (prologue, s("isset.c"));
@@ -2668,6 +3792,32 @@ void Generate_C::pre_php_script(PHP_script* in)
 			<< "ALLOC_INIT_ZVAL (" << *var << ");\n"
 			<< write_literal_directly_into_zval (*var, lit);
 		}
+
+		// Array keys with their hashes worked out.
+		STRING_list* pooled_keys =
+			in->attrs->get_list<STRING> ("phc.codegen.pooled_keys");
+
+		foreach (STRING* key, *pooled_keys)
+		{
+			String* var = key->attrs->get_string ("phc.codegen.key_name");
+			prologue
+			<< "static const phc_key " << *var << " = { "
+			<<		"\"" << *escape_C_dq (key->value) << "\", "
+			<<		key->value->size () + 1 << ", ";
+
+			if (key->attrs->has ("phc.codegen.key_index"))
+			{
+				prologue
+				<< "0, 1, "
+				<< key->attrs->get_integer ("phc.codegen.key_index")->value ()
+				<< " };\n";
+			}
+			else
+			{
+				prologue
+				<< get_hash (key->value) << ", 0, 0 };\n";
+			}
+		}
 	}
 
 	
@@ -2686,6 +3836,20 @@ void Generate_C::pre_php_script(PHP_script* in)
 		;
 	}
 
+	// Declare the direct entry points, so they can be called before they
+	// are defined.
+	direct_functions.clear ();
+	String_list* direct_names = dyc<String_list> (in->attrs->get ("phc.codegen.direct_functions"));
+	foreach (String* name, *direct_names)
+	{
+		direct_functions[*name->to_lower ()] = *name;
+
+		prologue
+		<< "static void " << get_direct_name (*name)
+		<< " (zval** direct_args, INTERNAL_FUNCTION_PARAMETERS);\n"
+		;
+	}
+
 	// Add function cache declarations
 	String_list* cached_functions = dyc<String_list> (in->attrs->get ("phc.codegen.cached_functions"));
 	foreach (String* name, *cached_functions)
@@ -2780,6 +3944,9 @@ void Generate_C::post_php_script(PHP_script* in)
 		"\n"
 		"void sighandler(int signum)\n"
 		"{\n"
+		"	TSRMLS_FETCH ();\n"
+		"	phc_drain_output_after_crash (TSRMLS_C);\n"
+		"\n"
 		"	switch(signum)\n"
 		"	{\n"
 		"		case SIGABRT:\n"
@@ -2824,6 +3991,9 @@ void Generate_C::post_php_script(PHP_script* in)
 		"      zend_alter_ini_entry (\"report_zend_debug\", sizeof(\"report_zend_debug\"), \"0\", sizeof(\"0\") - 1, PHP_INI_ALL, PHP_INI_STAGE_RUNTIME);\n"
 		"      zend_alter_ini_entry (\"display_startup_errors\", sizeof(\"display_startup_errors\"), \"1\", sizeof(\"1\") - 1, PHP_INI_ALL, PHP_INI_STAGE_RUNTIME);\n"
 		"\n"
+		"      // Write the output in large chunks\n"
+		"      phc_start_output_buffer (TSRMLS_C);\n"
+		"\n"
 		<<	embed_initializations.str () <<
 		"\n"
 		"      // call __MAIN__\n"
@@ -2845,6 +4015,7 @@ void Generate_C::post_php_script(PHP_script* in)
 		"   }\n"
 		"   zend_end_try ();\n"
 		"   phc_exit_status = EG(exit_status);\n"
+		"   phc_end_output_buffer (TSRMLS_C);\n"
 		"   php_embed_shutdown (TSRMLS_C);\n"
 		"\n"
 		"  return phc_exit_status;\n"
@@ -2858,6 +4029,7 @@ void Generate_C::post_php_script(PHP_script* in)
 
 Generate_C::Generate_C (ostream& os)
 : os(os)
+, lazy_st_vars (NULL)
 {
 	if (args_info.extension_given)
 	{
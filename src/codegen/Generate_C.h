@@ -13,6 +13,8 @@
 #include "codegen/MICG_gen.h"
 #include "pass_manager/Pass.h"
 
+class Pattern;
+
 class Generate_C : public MIR::Visitor, virtual public GC_obj
 {
 	std::ostream& os;
@@ -35,8 +37,18 @@ public:
 
 	MICG_gen micg;
 
+	// In a method with a lazy symbol table, the locals to copy to and from
+	// the symbol table. NULL otherwise.
+	String_list* lazy_st_vars;
+
 public:
 	string compile_statement(MIR::Statement* in);
+	string unpack_arrays (MIR::Statement* in, Pattern* pattern);
+	string finish_builders (MIR::Statement* in, Pattern* pattern);
+	string box_locals (MIR::Statement* in);
+	string unbox_locals (MIR::Statement* in);
+	string release_dead_locals (MIR::Statement* in);
+	string sync_symbol_table (MIR::Statement* in, string code);
 	void compile_static_value(string result, std::ostream& os, MIR::Static_value* sv);
 };
 
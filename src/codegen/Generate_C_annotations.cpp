@@ -7,10 +7,16 @@
 
 #include "Generate_C_annotations.h"
 #include <sstream>
+#include <boost/lexical_cast.hpp>
+
+#include "optimize/Method_info.h"
+#include "optimize/Oracle.h"
+#include "process_ir/General.h"
 
 #include "cmdline.h"
 extern struct gengetopt_args_info args_info;
 
+using namespace boost;
 using namespace MIR;
 using namespace std;
 
@@ -33,6 +39,9 @@ void
 Generate_C_annotations::pre_php_script (PHP_script* in)
 {
 	pool_values.clear ();
+	pool_keys.clear ();
+	occurrences = new VARIABLE_NAME_list;
+	lazy_symbol_table = false;
 	compiled_functions.push(new Signature_list);
 }
 
@@ -48,6 +57,14 @@ Generate_C_annotations::post_php_script (PHP_script* in)
 
 	in->attrs->set_list ("phc.codegen.pooled_literals", program_literals);
 
+	STRING_list* keys = new STRING_list;
+	string name;
+	STRING* key;
+	foreach (tie (name, key), pool_keys)
+		keys->push_back (key);
+
+	in->attrs->set_list ("phc.codegen.pooled_keys", keys);
+
 
 	// Add a list of methods called.
 	String_list* method_names = new String_list;
@@ -56,6 +73,8 @@ Generate_C_annotations::post_php_script (PHP_script* in)
 
 	in->attrs->set ("phc.codegen.cached_functions", method_names);
 
+	in->attrs->set ("phc.codegen.direct_functions", wrap_strings (direct_functions));
+
 
 	// Get a list of compiled functions
   Signature_list* cf;
@@ -89,16 +108,121 @@ Generate_C_annotations::post_literal (Literal* in)
 		pool [index]->attrs->get_string ("phc.codegen.pool_name")->clone ());
 }
 
+/*
+ * Work out whether PHP treats KEY as an integer key, as ZEND_HANDLE_NUMERIC
+ * does. Returns false if that depends on the size of a long on the target.
+ */
+static bool
+classify_key (String* key, bool& is_numeric, long& index)
+{
+	is_numeric = false;
+
+	size_t start = (key->size () > 0 && (*key)[0] == '-') ? 1 : 0;
+	if (key->size () == start)
+		return true;
+
+	for (size_t i = start; i < key->size (); i++)
+		if ((*key)[i] < '0' || (*key)[i] > '9')
+			return true;
+
+	// Leading zeros, and "-0", make it a string key.
+	if ((*key)[start] == '0' && key->size () > 1)
+		return true;
+
+	// Anything this short fits in 32 bits.
+	if (key->size () - start > 9)
+		return false;
+
+	is_numeric = true;
+	index = lexical_cast<long> (*key);
+	return true;
+}
+
+// Give a string literal used as an array index a pre-hashed key.
+void
+Generate_C_annotations::pool_key (Rvalue* index)
+{
+	if (!args_info.optimize_given)
+		return;
+
+	STRING* str = dynamic_cast<STRING*> (index);
+	if (str == NULL)
+		return;
+
+	bool is_numeric;
+	long value;
+	if (!classify_key (str->value, is_numeric, value))
+		return;
+
+	string name = *str->attrs->get_string ("phc.codegen.pool_name") + "_key";
+	str->attrs->set ("phc.codegen.key_name", s (name));
+
+	if (is_numeric)
+		str->attrs->set ("phc.codegen.key_index", new ::Integer (value));
+
+	if (!pool_keys.has (name))
+		pool_keys [name] = str;
+}
+
+void
+Generate_C_annotations::post_array_access (Array_access* in)
+{
+	pool_key (in->index);
+}
+
+void
+Generate_C_annotations::post_assign_array (Assign_array* in)
+{
+	pool_key (in->index);
+}
+
 void
 Generate_C_annotations::post_param_is_ref (Param_is_ref* in)
 {
 	if (METHOD_NAME* method_name = dynamic_cast<METHOD_NAME*> (in->method_name))
 		cached_functions.insert (*method_name->value);
+	else
+		keep_boxed (dyc<Variable_method> (in->method_name)->variable_name);
 }
 
 void
 Generate_C_annotations::post_method_invocation (Method_invocation* in)
 {
+	// Parameters passed by reference cannot be unboxed. Builtins take their
+	// parameters by value.
+	METHOD_NAME* name = dynamic_cast<METHOD_NAME*> (in->method_name);
+	if (args_info.unboxed_locals_given
+		&& (name == NULL || !is_builtin_function (name->value)))
+	{
+		Method_info* info = NULL;
+		if (name && in->target == NULL)
+			info = Oracle::get_method_info (name->value);
+
+		int i = 0;
+		foreach (Actual_parameter* ap, *in->actual_parameters)
+		{
+			if (info == NULL || ap->is_ref || info->param_by_ref (i))
+				keep_boxed (ap->rvalue);
+
+			i++;
+		}
+	}
+
+	// Variable functions read the name's zval.
+	if (Variable_method* var_method = dynamic_cast<Variable_method*> (in->method_name))
+		keep_boxed (var_method->variable_name);
+
+	// These read the arguments in the caller's frame, so the engine must
+	// call the caller.
+	if (name == NULL
+		|| (in->target == NULL
+			&& (*name->value == "func_get_args"
+				|| *name->value == "func_get_arg"
+				|| *name->value == "func_num_args"
+				|| *name->value == "debug_backtrace"
+				|| *name->value == "debug_print_backtrace")))
+		needs_call_frame = true;
+
 	if (METHOD_NAME* method_name = dynamic_cast<METHOD_NAME*> (in->method_name))
 	{
 		CLASS_NAME* class_name = dynamic_cast<CLASS_NAME*>(in->target);
@@ -127,7 +251,16 @@ void
 Generate_C_annotations::pre_method (MIR::Method* in)
 {
 	var_names.clear ();
+	lazy_st_vars.clear ();
+	lazy_symbol_table = in->signature->method_name->attrs->is_true ("phc.codegen.lazy_symbol_table");
 	iterators.clear ();
+	native_types.clear ();
+	occurrences = new VARIABLE_NAME_list;
+	boxed_vars.clear ();
+	packed_arrays.clear ();
+	copies = new Assign_var_list;
+	appends = new Assign_var_list;
+	needs_call_frame = false;
 
 	if(!class_name.empty())
 		in->signature->attrs->set ("phc.codegen.class_name", class_name.top()->clone());
@@ -138,7 +271,78 @@ void
 Generate_C_annotations::post_method (MIR::Method* in)
 {
 	in->attrs->set ("phc.codegen.non_st_vars", wrap_strings (var_names));
+	in->attrs->set ("phc.codegen.lazy_st_vars", wrap_strings (lazy_st_vars));
+	lazy_symbol_table = false;
 	in->attrs->set ("phc.codegen.ht_iterators", wrap_strings (iterators));
+
+	// Mark each occurrence of the unboxed variables, and list one of each.
+	VARIABLE_NAME_list* unboxed = new VARIABLE_NAME_list;
+	Set<string> listed;
+	foreach (VARIABLE_NAME* var, *occurrences)
+	{
+		string type = native_types[*var->value];
+		if (type == "")
+			continue;
+
+		var->attrs->set ("phc.codegen.native_type", s (type));
+
+		if (!listed.has (*var->value))
+		{
+			listed.insert (*var->value);
+			unboxed->push_back (var);
+		}
+	}
+	in->attrs->set_list ("phc.codegen.unboxed_vars", unboxed);
+
+	// Mark each occurrence of the packed arrays, and list one of each.
+	Set<string> packed = find_packed_arrays ();
+	VARIABLE_NAME_list* packed_vars = new VARIABLE_NAME_list;
+	listed.clear ();
+	foreach (VARIABLE_NAME* var, *occurrences)
+	{
+		if (!packed.has (*var->value))
+			continue;
+
+		var->attrs->set_true ("phc.codegen.packed");
+
+		if (!listed.has (*var->value))
+		{
+			listed.insert (*var->value);
+			packed_vars->push_back (var);
+		}
+	}
+	in->attrs->set_list ("phc.codegen.packed_vars", packed_vars);
+
+	// Mark each occurrence of the string builders, and list one of each.
+	Set<string> builders = find_string_builders (packed);
+	VARIABLE_NAME_list* builder_vars = new VARIABLE_NAME_list;
+	listed.clear ();
+	foreach (VARIABLE_NAME* var, *occurrences)
+	{
+		if (!builders.has (*var->value))
+			continue;
+
+		var->attrs->set_true ("phc.codegen.string_builder");
+
+		if (!listed.has (*var->value))
+		{
+			listed.insert (*var->value);
+			builder_vars->push_back (var);
+		}
+	}
+	in->attrs->set_list ("phc.codegen.builder_vars", builder_vars);
+
+	// Functions called directly take their parameters from an array, and
+	// return by value.
+	if (args_info.optimize_given
+		&& class_name.empty ()
+		&& *in->signature->method_name->value != "__MAIN__"
+		&& !in->signature->return_by_ref
+		&& !needs_call_frame)
+	{
+		in->signature->attrs->set_true ("phc.codegen.direct_entry");
+		direct_functions.insert (*in->signature->method_name->value);
+	}
 }
 
 
@@ -150,6 +354,41 @@ Generate_C_annotations::post_variable_name (MIR::VARIABLE_NAME* in)
 	{
 		var_names.insert (*in->value);
 	}
+
+	// Variables which the symbol table can see are kept in zvals.
+	if (lazy_symbol_table
+		&& in->attrs->is_true ("phc.codegen.st_entry_not_required")
+		&& !in->attrs->is_true ("phc.codegen.compiler_generated")
+		&& *in->value != "this")
+	{
+		lazy_st_vars.insert (*in->value);
+		keep_boxed (in);
+	}
+
+	if (!args_info.unboxed_locals_given)
+		return;
+
+	// Every occurrence must agree on the type.
+	string type = "";
+	if (in->attrs->is_true ("phc.codegen.st_entry_not_required")
+		&& in->attrs->has ("phc.optimize.type")
+		&& *in->value != "this")
+	{
+		string php_type = *in->attrs->get_string ("phc.optimize.type");
+		if (php_type == "int")
+			type = "long";
+		else if (php_type == "real")
+			type = "double";
+		else if (php_type == "bool")
+			type = "zend_bool";
+	}
+
+	if (!native_types.has (*in->value))
+		native_types[*in->value] = type;
+	else if (native_types[*in->value] != type)
+		native_types[*in->value] = "";
+
+	occurrences->push_back (in);
 }
 
 // Get the list of Hashtable iterators required.
@@ -167,6 +406,208 @@ Generate_C_annotations::post_return (Return* in)
 	in->attrs->set ("phc.codegen.return_by_ref",
 		new Boolean (
 			(compiled_functions.top())->back ()->return_by_ref));
+
+	if ((compiled_functions.top())->back ()->return_by_ref)
+		keep_boxed (in->rvalue);
+}
+
+// The locals released after a statement are marked like other occurrences.
+void
+Generate_C_annotations::post_statement (Statement* in)
+{
+	if (!in->attrs->has ("phc.optimize.dead_locals"))
+		return;
+
+	foreach (VARIABLE_NAME* var, *in->attrs->get_list<VARIABLE_NAME> ("phc.optimize.dead_locals"))
+		occurrences->push_back (var);
+}
+
+/*
+ * Unboxed locals
+ */
+
+void
+Generate_C_annotations::keep_boxed (Node* in)
+{
+	if (VARIABLE_NAME* var = dynamic_cast<VARIABLE_NAME*> (in))
+	{
+		native_types[*var->value] = "";
+		boxed_vars.insert (*var->value);
+	}
+}
+
+/*
+ * Packed arrays
+ */
+
+// Arrays created packed, and variables assigned copies of them. They may be
+// assigned other values too, which are kept in their zvals as usual.
+Set<string>
+Generate_C_annotations::find_packed_arrays ()
+{
+	Set<string> excluded = find_zval_only_vars ();
+
+	Set<string> result;
+	foreach (string name, packed_arrays)
+	{
+		if (!excluded.has (name))
+			result.insert (name);
+	}
+
+	// Copies of packed arrays
+	bool changed = true;
+	while (changed)
+	{
+		changed = false;
+		foreach (Assign_var* copy, *copies)
+		{
+			string lhs = *copy->lhs->value;
+			string rhs = *dyc<VARIABLE_NAME> (copy->rhs)->value;
+			if (result.has (rhs) && !result.has (lhs) && !excluded.has (lhs))
+			{
+				result.insert (lhs);
+				changed = true;
+			}
+		}
+	}
+
+	return result;
+}
+
+/*
+ * String builders
+ */
+
+static bool
+is_append (Assign_var* in)
+{
+	Bin_op* bin_op = dynamic_cast<Bin_op*> (in->rhs);
+	if (in->is_ref || bin_op == NULL || *bin_op->op->value != ".")
+		return false;
+
+	VARIABLE_NAME* left = dynamic_cast<VARIABLE_NAME*> (bin_op->left);
+	VARIABLE_NAME* right = dynamic_cast<VARIABLE_NAME*> (bin_op->right);
+	return left
+		&& *left->value == *in->lhs->value
+		&& (right == NULL || *right->value != *in->lhs->value);
+}
+
+// Variables which are appended to, other than packed arrays.
+Set<string>
+Generate_C_annotations::find_string_builders (Set<string> packed)
+{
+	Set<string> excluded = find_zval_only_vars ();
+
+	Set<string> result;
+	foreach (Assign_var* append, *appends)
+	{
+		string name = *append->lhs->value;
+		if (!excluded.has (name) && !packed.has (name))
+			result.insert (name);
+	}
+
+	return result;
+}
+
+// Variables in the symbol table, referenced, or unboxed.
+Set<string>
+Generate_C_annotations::find_zval_only_vars ()
+{
+	Set<string> result = boxed_vars;
+	foreach (VARIABLE_NAME* var, *occurrences)
+	{
+		if (!var->attrs->is_true ("phc.codegen.st_entry_not_required")
+			|| *var->value == "this"
+			|| native_types[*var->value] != "")
+			result.insert (*var->value);
+	}
+
+	return result;
+}
+
+// Parameters are passed in zvals.
+void
+Generate_C_annotations::pre_formal_parameter (Formal_parameter* in)
+{
+	keep_boxed (in->var->variable_name);
+}
+
+void
+Generate_C_annotations::pre_assign_var (Assign_var* in)
+{
+	if (in->is_ref)
+	{
+		keep_boxed (in->lhs);
+		keep_boxed (in->rhs);
+	}
+	else if (in->attrs->is_true ("phc.optimize.packed_array"))
+		packed_arrays.insert (*in->lhs->value);
+	else if (isa<VARIABLE_NAME> (in->rhs))
+		copies->push_back (in);
+	else if (is_append (in))
+		appends->push_back (in);
+}
+
+void
+Generate_C_annotations::pre_assign_var_var (Assign_var_var* in)
+{
+	if (in->is_ref)
+		keep_boxed (in->rhs);
+}
+
+void
+Generate_C_annotations::pre_assign_array (Assign_array* in)
+{
+	if (in->is_ref)
+		keep_boxed (in->rhs);
+}
+
+void
+Generate_C_annotations::pre_assign_next (Assign_next* in)
+{
+	if (in->is_ref)
+		keep_boxed (in->rhs);
+}
+
+void
+Generate_C_annotations::pre_assign_field (Assign_field* in)
+{
+	if (in->is_ref)
+		keep_boxed (in->rhs);
+}
+
+void
+Generate_C_annotations::pre_global (Global* in)
+{
+	keep_boxed (in->variable_name);
+}
+
+void
+Generate_C_annotations::pre_static_declaration (Static_declaration* in)
+{
+	keep_boxed (in->var->variable_name);
+}
+
+// Unset packed arrays release their vector.
+void
+Generate_C_annotations::pre_unset (Unset* in)
+{
+	if (VARIABLE_NAME* var = dynamic_cast<VARIABLE_NAME*> (in->variable_name))
+		native_types[*var->value] = "";
+}
+
+void
+Generate_C_annotations::pre_catch (Catch* in)
+{
+	keep_boxed (in->variable_name);
+}
+
+// We dont know the constructor, so any parameter may be by reference.
+void
+Generate_C_annotations::pre_new (New* in)
+{
+	foreach (Actual_parameter* ap, *in->actual_parameters)
+		keep_boxed (ap->rvalue);
 }
 
 // Make sure phc.codegen.compiled_functions gets added to the class
@@ -7,6 +7,34 @@
  * The phc.codegen.compiled_functions on the PHP script is a list of 
  * all functions in the global scope, but excluding function definitions
  * inside classes; they are stored in a similar attribute on the class def.
+ *
+ * With --unboxed-locals, variables outside the symbol table whose type is
+ * always int, real or bool, and which are never referenced, are marked with
+ * phc.codegen.native_type, and listed in phc.codegen.unboxed_vars on the
+ * method.
+ *
+ * Also with --unboxed-locals, local arrays which the optimizer marks with
+ * phc.optimize.packed_array when they are created, and their copies, are
+ * marked with phc.codegen.packed, and listed in phc.codegen.packed_vars on
+ * the method. Generate_C keeps them in vectors.
+ *
+ * Also with --unboxed-locals, locals which are appended to ($x = $x . $y)
+ * are marked with phc.codegen.string_builder, and listed in
+ * phc.codegen.builder_vars on the method. Generate_C appends to them in a
+ * string builder.
+ *
+ * In methods with phc.codegen.lazy_symbol_table, the variables which must be
+ * copied to and from the symbol table are listed in phc.codegen.lazy_st_vars.
+ *
+ * When optimizing, functions in the global scope which dont need a call frame
+ * of their own are marked with phc.codegen.direct_entry, and listed in
+ * phc.codegen.direct_functions on the script. Compiled code calls them
+ * directly.
+ *
+ * When optimizing, string literals used as array indices are marked with
+ * phc.codegen.key_name, naming a phc_key which holds their hash, or their
+ * integer value if PHP treats them as integer keys. The keys are listed in
+ * phc.codegen.pooled_keys on the script.
  */
 
 #ifndef PHC_GENERATE_C_ANNOTATIONS_H
@@ -20,14 +48,42 @@ class Generate_C_annotations : public MIR::Visitor, virtual public GC_obj
 {
 protected:
 	Set<string> var_names;
+	Set<string> lazy_st_vars;
+	bool lazy_symbol_table;
 	Set<string> iterators;
 	Set<string> cached_functions;
+	Set<string> direct_functions;
+	bool needs_call_frame;
 	Stack<MIR::Signature_list*> compiled_functions;
 	Stack<String*> class_name;
 
 	// Literal.classid() -> (lit.value -> Literal*)
 	Map<int, Map<string, MIR::Literal*> > pool_values;
 
+	// Key name -> STRING
+	Map<string, MIR::STRING*> pool_keys;
+	void pool_key (MIR::Rvalue* index);
+
+	// Variable name -> C type, or "" if it must be kept in a zval.
+	Map<string, string> native_types;
+	MIR::VARIABLE_NAME_list* occurrences;
+	void keep_boxed (MIR::Node* in);
+
+	// Variables which must be kept in a zval, whatever their type.
+	Set<string> boxed_vars;
+
+	// Variables created as packed arrays, and assignments which may copy them.
+	Set<string> packed_arrays;
+	MIR::Assign_var_list* copies;
+	Set<string> find_packed_arrays ();
+
+	// Assignments which append to a variable.
+	MIR::Assign_var_list* appends;
+	Set<string> find_string_builders (Set<string> packed);
+
+	// Variables which must be kept in their zvals.
+	Set<string> find_zval_only_vars ();
+
 public:
 	// Whole script analysis
 	void pre_php_script (MIR::PHP_script* in);
@@ -35,6 +91,8 @@ public:
 	void post_literal (MIR::Literal* in);
 	void post_param_is_ref (MIR::Param_is_ref* in);
 	void post_method_invocation (MIR::Method_invocation* in);
+	void post_array_access (MIR::Array_access* in);
+	void post_assign_array (MIR::Assign_array* in);
 
 	// OO
 	void pre_class_def(MIR::Class_def* in);
@@ -46,6 +104,20 @@ public:
 	void post_variable_name (MIR::VARIABLE_NAME* in);
 	void post_ht_iterator (MIR::HT_ITERATOR* in);
 	void post_return (MIR::Return* in);
+	void post_statement (MIR::Statement* in);
+
+	// Contexts which may reference a variable
+	void pre_formal_parameter (MIR::Formal_parameter* in);
+	void pre_assign_var (MIR::Assign_var* in);
+	void pre_assign_var_var (MIR::Assign_var_var* in);
+	void pre_assign_array (MIR::Assign_array* in);
+	void pre_assign_next (MIR::Assign_next* in);
+	void pre_assign_field (MIR::Assign_field* in);
+	void pre_global (MIR::Global* in);
+	void pre_static_declaration (MIR::Static_declaration* in);
+	void pre_unset (MIR::Unset* in);
+	void pre_catch (MIR::Catch* in);
+	void pre_new (MIR::New* in);
 
 // Declare Generate_C as a friend so that it can access var_names
 // (necessary in compile_static_value)
@@ -13,6 +13,7 @@
 #include "process_mir/MIR_unparser.h"
 #include "optimize/Method_info.h"
 #include "optimize/Class_info.h"
+#include "optimize/Builtin_model.h"
 
 using namespace MIR;
 
@@ -280,117 +281,9 @@ Internal_method_info::formal_param_count ()
 bool
 Internal_method_info::get_side_effecting ()
 {
-	string name = *this->name;
-	return not (0
-			|| name == "abs"
-			|| name == "acos"
-			|| name == "acosh"
-			|| name == "addslashes"
-			|| name == "asin"
-			|| name == "asinh"
-			|| name == "atan"
-			|| name == "atan2"
-			|| name == "atanh"
-			|| name == "base64_decode"
-			|| name == "base64_encode"
-			|| name == "base_convert"
-			|| name == "basename"
-			|| name == "bindec"
-			|| name == "ceil"
-			|| name == "chop"
-			|| name == "chr"
-			|| name == "cos"
-			|| name == "cosh"
-			|| name == "crc32"
-			|| name == "decbin"
-			|| name == "dechex"
-			|| name == "decoct"
-			|| name == "deg2rad"
-			|| name == "dirname"
-			|| name == "doubleval"
-			|| name == "exp"
-			|| name == "expm1"
-			|| name == "floor"
-			|| name == "floatval"
-			|| name == "fmod"
-			|| name == "getrandmax"
-			|| name == "gettype"
-			|| name == "hexdec"
-			|| name == "htmlentities"
-			|| name == "htmlspecialchars"
-			|| name == "hypot"
-			|| name == "intval"
-			|| name == "ip2long"
-			|| name == "is_a"
-			|| name == "is_array"
-			|| name == "is_binary"
-			|| name == "is_bool"
-			|| name == "is_buffer"
-			|| name == "is_double"
-			|| name == "is_finite"
-			|| name == "is_float"
-			|| name == "is_infinite"
-			|| name == "is_int"
-			|| name == "is_integer"
-			|| name == "is_long"
-			|| name == "is_nan"
-			|| name == "is_null"
-			|| name == "is_numeric"
-			|| name == "is_object"
-			|| name == "is_real"
-			|| name == "is_resource"
-			|| name == "is_scalar"
-			|| name == "is_string"
-			|| name == "is_subclass_of"
-			|| name == "is_unicode"
-			|| name == "lcg_value"
-			|| name == "log"
-			|| name == "log10"
-			|| name == "log1p"
-			|| name == "long2ip"
-			|| name == "ltrim"
-			|| name == "max"
-			|| name == "md5"
-			|| name == "min"
-			|| name == "mt_getrandmax"
-			|| name == "octdec"
-			|| name == "ord"
-			|| name == "php_egg_logo_guide"
-			|| name == "php_logo_guide"
-			|| name == "pi"
-			|| name == "pow"
-			|| name == "rad2deg"
-			|| name == "realpath"
-			|| name == "round"
-			|| name == "rtrim"
-			|| name == "sha1"
-			|| name == "sin"
-			|| name == "sinh"
-			|| name == "sqrt"
-			|| name == "strcasecmp"
-			|| name == "strcmp"
-			|| name == "strlen"
-			|| name == "strncasecmp"
-			|| name == "strncmp"
-			|| name == "str_pad"
-			|| name == "str_repeat"
-			|| name == "strtoupper"
-			|| name == "strval"
-			|| name == "substr"
-			|| name == "tan"
-			|| name == "tanh"
-			|| name == "trim"
-			|| name == "version_compare"
-			|| name == "zend_function"
-			|| name == "zend_logo_guide"
-			)
-			;
+	return not Builtin_models::is_pure (this->name);
 }
 
 
 
-
-
-
-
 #endif // HAVE_EMBED
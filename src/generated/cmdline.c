@@ -60,6 +60,7 @@ const char *gengetopt_args_info_full_help[] = {
   "      --generate-c              Generate C code  (default=off)",
   "      --extension=EXTENSION     Generate a PHP extension called EXTENSION \n                                  instead of a standalone application",
   "      --web-app=CONFIG          Generate a web-application (experimental)",
+  "      --unboxed-locals          Store local ints, reals and bools in C \n                                  variables where the optimizer proves their \n                                  types  (default=off)",
   "      --with-php=PATH           PHP installation path",
   "  -O, --optimize=STRING         Optimize  (default=`0')",
   "  -o, --output=FILE             Place executable into file FILE",
@@ -89,7 +90,15 @@ const char *gengetopt_args_info_full_help[] = {
   "\nOPTIMIZATION OPTIONS:",
   "      --flow-insensitive        Turn off flow-sensitivity  (default=off)",
   "      --call-string-length=LENGTH\n                                Choose the call-string length ('0' indicates \n                                  infinite call-string)  (default=`0')",
+  "      --adaptive-context        Analyse large or widely-called functions \n                                  context-insensitively  (default=off)",
+  "      --context-call-sites=N    With --adaptive-context, the most call-sites a \n                                  function may have and be analysed \n                                  context-sensitively  (default=`16')",
+  "      --context-blocks=N        With --adaptive-context, the most basic blocks \n                                  a function may have and be analysed \n                                  context-sensitively  (default=`200')",
+  "      --function-time-budget=MS Analyse a function context-insensitively once \n                                  it has taken MS milliseconds to analyse ('0' \n                                  indicates no budget)  (default=`0')",
+  "      --function-memory-budget=MB\n                                Analyse a function context-insensitively once \n                                  its analysis has allocated MB megabytes ('0' \n                                  indicates no budget)  (default=`0')",
+  "      --widening-threshold=N    Widen the analysis results at a loop header \n                                  after it has been visited N times in a \n                                  context ('0' disables widening, except of \n                                  integer ranges)  (default=`3')",
   "      --ssi-type=FLAVOR         Select SSI flavor.  (possible values=\"ssi\", \n                                  \"essa\" default=`ssi')",
+  "      --summary-db=FILE         Reuse summaries of side-effect-free functions \n                                  from the database FILE, and add new ones to \n                                  it",
+  "      --builtin-model=FILE      Read additional models of builtin functions \n                                  from FILE",
   "\nDEBUGGING PHC:",
   "      --stats                   Print compile-time statistics  (default=off)",
   "      --rt-stats                Print statistics about a program at run-time  \n                                  (default=off)",
@@ -131,7 +140,7 @@ init_help_array(void)
   gengetopt_args_info_help[23] = gengetopt_args_info_full_help[24];
   gengetopt_args_info_help[24] = gengetopt_args_info_full_help[26];
   gengetopt_args_info_help[25] = gengetopt_args_info_full_help[27];
-  gengetopt_args_info_help[26] = gengetopt_args_info_full_help[29];
+  gengetopt_args_info_help[26] = gengetopt_args_info_full_help[28];
   gengetopt_args_info_help[27] = gengetopt_args_info_full_help[30];
   gengetopt_args_info_help[28] = gengetopt_args_info_full_help[31];
   gengetopt_args_info_help[29] = gengetopt_args_info_full_help[32];
@@ -143,17 +152,26 @@ init_help_array(void)
   gengetopt_args_info_help[35] = gengetopt_args_info_full_help[38];
   gengetopt_args_info_help[36] = gengetopt_args_info_full_help[39];
   gengetopt_args_info_help[37] = gengetopt_args_info_full_help[40];
-  gengetopt_args_info_help[38] = gengetopt_args_info_full_help[43];
-  gengetopt_args_info_help[39] = gengetopt_args_info_full_help[54];
+  gengetopt_args_info_help[38] = gengetopt_args_info_full_help[41];
+  gengetopt_args_info_help[39] = gengetopt_args_info_full_help[44];
   gengetopt_args_info_help[40] = gengetopt_args_info_full_help[55];
   gengetopt_args_info_help[41] = gengetopt_args_info_full_help[56];
   gengetopt_args_info_help[42] = gengetopt_args_info_full_help[57];
-  gengetopt_args_info_help[43] = gengetopt_args_info_full_help[66];
-  gengetopt_args_info_help[44] = 0; 
+  gengetopt_args_info_help[43] = gengetopt_args_info_full_help[58];
+  gengetopt_args_info_help[44] = gengetopt_args_info_full_help[59];
+  gengetopt_args_info_help[45] = gengetopt_args_info_full_help[60];
+  gengetopt_args_info_help[46] = gengetopt_args_info_full_help[61];
+  gengetopt_args_info_help[47] = gengetopt_args_info_full_help[62];
+  gengetopt_args_info_help[48] = gengetopt_args_info_full_help[63];
+  gengetopt_args_info_help[49] = gengetopt_args_info_full_help[64];
+  gengetopt_args_info_help[50] = gengetopt_args_info_full_help[65];
+  gengetopt_args_info_help[51] = gengetopt_args_info_full_help[66];
+  gengetopt_args_info_help[52] = gengetopt_args_info_full_help[75];
+  gengetopt_args_info_help[53] = 0; 
   
 }
 
-const char *gengetopt_args_info_help[45];
+const char *gengetopt_args_info_help[54];
 
 typedef enum {ARG_NO
   , ARG_FLAG
@@ -207,6 +225,7 @@ void clear_given (struct gengetopt_args_info *args_info)
   args_info->generate_c_given = 0 ;
   args_info->extension_given = 0 ;
   args_info->web_app_given = 0 ;
+  args_info->unboxed_locals_given = 0 ;
   args_info->with_php_given = 0 ;
   args_info->optimize_given = 0 ;
   args_info->output_given = 0 ;
@@ -230,7 +249,15 @@ void clear_given (struct gengetopt_args_info *args_info)
   args_info->no_xml_attrs_given = 0 ;
   args_info->flow_insensitive_given = 0 ;
   args_info->call_string_length_given = 0 ;
+  args_info->adaptive_context_given = 0 ;
+  args_info->context_call_sites_given = 0 ;
+  args_info->context_blocks_given = 0 ;
+  args_info->function_time_budget_given = 0 ;
+  args_info->function_memory_budget_given = 0 ;
+  args_info->widening_threshold_given = 0 ;
   args_info->ssi_type_given = 0 ;
+  args_info->summary_db_given = 0 ;
+  args_info->builtin_model_given = 0 ;
   args_info->stats_given = 0 ;
   args_info->rt_stats_given = 0 ;
   args_info->cfg_dump_given = 0 ;
@@ -276,6 +303,7 @@ void clear_args (struct gengetopt_args_info *args_info)
   args_info->extension_orig = NULL;
   args_info->web_app_arg = NULL;
   args_info->web_app_orig = NULL;
+  args_info->unboxed_locals_flag = 0;
   args_info->with_php_arg = NULL;
   args_info->with_php_orig = NULL;
   args_info->optimize_arg = gengetopt_strdup ("0");
@@ -307,8 +335,23 @@ void clear_args (struct gengetopt_args_info *args_info)
   args_info->flow_insensitive_flag = 0;
   args_info->call_string_length_arg = 0;
   args_info->call_string_length_orig = NULL;
+  args_info->adaptive_context_flag = 0;
+  args_info->context_call_sites_arg = 16;
+  args_info->context_call_sites_orig = NULL;
+  args_info->context_blocks_arg = 200;
+  args_info->context_blocks_orig = NULL;
+  args_info->function_time_budget_arg = 0;
+  args_info->function_time_budget_orig = NULL;
+  args_info->function_memory_budget_arg = 0;
+  args_info->function_memory_budget_orig = NULL;
+  args_info->widening_threshold_arg = 3;
+  args_info->widening_threshold_orig = NULL;
   args_info->ssi_type_arg = ssi_type_arg_ssi;
   args_info->ssi_type_orig = NULL;
+  args_info->summary_db_arg = NULL;
+  args_info->summary_db_orig = NULL;
+  args_info->builtin_model_arg = NULL;
+  args_info->builtin_model_orig = NULL;
   args_info->stats_flag = 0;
   args_info->rt_stats_flag = 0;
   args_info->cfg_dump_arg = NULL;
@@ -364,49 +407,58 @@ void init_args_info(struct gengetopt_args_info *args_info)
   args_info->generate_c_help = gengetopt_args_info_full_help[25] ;
   args_info->extension_help = gengetopt_args_info_full_help[26] ;
   args_info->web_app_help = gengetopt_args_info_full_help[27] ;
-  args_info->with_php_help = gengetopt_args_info_full_help[28] ;
-  args_info->optimize_help = gengetopt_args_info_full_help[29] ;
-  args_info->output_help = gengetopt_args_info_full_help[30] ;
-  args_info->execute_help = gengetopt_args_info_full_help[31] ;
-  args_info->next_line_curlies_help = gengetopt_args_info_full_help[33] ;
-  args_info->no_leading_tab_help = gengetopt_args_info_full_help[34] ;
-  args_info->tab_help = gengetopt_args_info_full_help[35] ;
-  args_info->no_hash_bang_help = gengetopt_args_info_full_help[36] ;
-  args_info->dump_help = gengetopt_args_info_full_help[38] ;
+  args_info->unboxed_locals_help = gengetopt_args_info_full_help[28] ;
+  args_info->with_php_help = gengetopt_args_info_full_help[29] ;
+  args_info->optimize_help = gengetopt_args_info_full_help[30] ;
+  args_info->output_help = gengetopt_args_info_full_help[31] ;
+  args_info->execute_help = gengetopt_args_info_full_help[32] ;
+  args_info->next_line_curlies_help = gengetopt_args_info_full_help[34] ;
+  args_info->no_leading_tab_help = gengetopt_args_info_full_help[35] ;
+  args_info->tab_help = gengetopt_args_info_full_help[36] ;
+  args_info->no_hash_bang_help = gengetopt_args_info_full_help[37] ;
+  args_info->dump_help = gengetopt_args_info_full_help[39] ;
   args_info->dump_min = 0;
   args_info->dump_max = 0;
-  args_info->dump_xml_help = gengetopt_args_info_full_help[39] ;
+  args_info->dump_xml_help = gengetopt_args_info_full_help[40] ;
   args_info->dump_xml_min = 0;
   args_info->dump_xml_max = 0;
-  args_info->dump_dot_help = gengetopt_args_info_full_help[40] ;
+  args_info->dump_dot_help = gengetopt_args_info_full_help[41] ;
   args_info->dump_dot_min = 0;
   args_info->dump_dot_max = 0;
-  args_info->dump_parse_tree_help = gengetopt_args_info_full_help[41] ;
-  args_info->dump_tokens_help = gengetopt_args_info_full_help[42] ;
-  args_info->list_passes_help = gengetopt_args_info_full_help[43] ;
-  args_info->convert_uppered_help = gengetopt_args_info_full_help[45] ;
-  args_info->no_dot_line_numbers_help = gengetopt_args_info_full_help[47] ;
-  args_info->no_dot_nulls_help = gengetopt_args_info_full_help[48] ;
-  args_info->no_dot_empty_lists_help = gengetopt_args_info_full_help[49] ;
-  args_info->no_xml_line_numbers_help = gengetopt_args_info_full_help[51] ;
-  args_info->no_xml_base_64_help = gengetopt_args_info_full_help[52] ;
-  args_info->no_xml_attrs_help = gengetopt_args_info_full_help[53] ;
-  args_info->flow_insensitive_help = gengetopt_args_info_full_help[55] ;
-  args_info->call_string_length_help = gengetopt_args_info_full_help[56] ;
-  args_info->ssi_type_help = gengetopt_args_info_full_help[57] ;
-  args_info->stats_help = gengetopt_args_info_full_help[59] ;
-  args_info->rt_stats_help = gengetopt_args_info_full_help[60] ;
-  args_info->cfg_dump_help = gengetopt_args_info_full_help[61] ;
+  args_info->dump_parse_tree_help = gengetopt_args_info_full_help[42] ;
+  args_info->dump_tokens_help = gengetopt_args_info_full_help[43] ;
+  args_info->list_passes_help = gengetopt_args_info_full_help[44] ;
+  args_info->convert_uppered_help = gengetopt_args_info_full_help[46] ;
+  args_info->no_dot_line_numbers_help = gengetopt_args_info_full_help[48] ;
+  args_info->no_dot_nulls_help = gengetopt_args_info_full_help[49] ;
+  args_info->no_dot_empty_lists_help = gengetopt_args_info_full_help[50] ;
+  args_info->no_xml_line_numbers_help = gengetopt_args_info_full_help[52] ;
+  args_info->no_xml_base_64_help = gengetopt_args_info_full_help[53] ;
+  args_info->no_xml_attrs_help = gengetopt_args_info_full_help[54] ;
+  args_info->flow_insensitive_help = gengetopt_args_info_full_help[56] ;
+  args_info->call_string_length_help = gengetopt_args_info_full_help[57] ;
+  args_info->adaptive_context_help = gengetopt_args_info_full_help[58] ;
+  args_info->context_call_sites_help = gengetopt_args_info_full_help[59] ;
+  args_info->context_blocks_help = gengetopt_args_info_full_help[60] ;
+  args_info->function_time_budget_help = gengetopt_args_info_full_help[61] ;
+  args_info->function_memory_budget_help = gengetopt_args_info_full_help[62] ;
+  args_info->widening_threshold_help = gengetopt_args_info_full_help[63] ;
+  args_info->ssi_type_help = gengetopt_args_info_full_help[64] ;
+  args_info->summary_db_help = gengetopt_args_info_full_help[65] ;
+  args_info->builtin_model_help = gengetopt_args_info_full_help[66] ;
+  args_info->stats_help = gengetopt_args_info_full_help[68] ;
+  args_info->rt_stats_help = gengetopt_args_info_full_help[69] ;
+  args_info->cfg_dump_help = gengetopt_args_info_full_help[70] ;
   args_info->cfg_dump_min = 0;
   args_info->cfg_dump_max = 0;
-  args_info->debug_help = gengetopt_args_info_full_help[62] ;
+  args_info->debug_help = gengetopt_args_info_full_help[71] ;
   args_info->debug_min = 0;
   args_info->debug_max = 0;
-  args_info->dont_fail_help = gengetopt_args_info_full_help[63] ;
-  args_info->disable_help = gengetopt_args_info_full_help[64] ;
+  args_info->dont_fail_help = gengetopt_args_info_full_help[72] ;
+  args_info->disable_help = gengetopt_args_info_full_help[73] ;
   args_info->disable_min = 0;
   args_info->disable_max = 0;
-  args_info->pause_help = gengetopt_args_info_full_help[65] ;
+  args_info->pause_help = gengetopt_args_info_full_help[74] ;
   
 }
 
@@ -571,7 +623,16 @@ cmdline_parser_release (struct gengetopt_args_info *args_info)
   free_multiple_string_field (args_info->dump_xml_given, &(args_info->dump_xml_arg), &(args_info->dump_xml_orig));
   free_multiple_string_field (args_info->dump_dot_given, &(args_info->dump_dot_arg), &(args_info->dump_dot_orig));
   free_string_field (&(args_info->call_string_length_orig));
+  free_string_field (&(args_info->context_call_sites_orig));
+  free_string_field (&(args_info->context_blocks_orig));
+  free_string_field (&(args_info->function_time_budget_orig));
+  free_string_field (&(args_info->function_memory_budget_orig));
+  free_string_field (&(args_info->widening_threshold_orig));
   free_string_field (&(args_info->ssi_type_orig));
+  free_string_field (&(args_info->summary_db_arg));
+  free_string_field (&(args_info->summary_db_orig));
+  free_string_field (&(args_info->builtin_model_arg));
+  free_string_field (&(args_info->builtin_model_orig));
   free_multiple_string_field (args_info->cfg_dump_given, &(args_info->cfg_dump_arg), &(args_info->cfg_dump_orig));
   free_multiple_string_field (args_info->debug_given, &(args_info->debug_arg), &(args_info->debug_orig));
   free_multiple_string_field (args_info->disable_given, &(args_info->disable_arg), &(args_info->disable_orig));
@@ -703,6 +764,8 @@ cmdline_parser_dump(FILE *outfile, struct gengetopt_args_info *args_info)
     write_into_file(outfile, "extension", args_info->extension_orig, 0);
   if (args_info->web_app_given)
     write_into_file(outfile, "web-app", args_info->web_app_orig, 0);
+  if (args_info->unboxed_locals_given)
+    write_into_file(outfile, "unboxed-locals", 0, 0 );
   if (args_info->with_php_given)
     write_into_file(outfile, "with-php", args_info->with_php_orig, 0);
   if (args_info->optimize_given)
@@ -746,8 +809,24 @@ cmdline_parser_dump(FILE *outfile, struct gengetopt_args_info *args_info)
     write_into_file(outfile, "flow-insensitive", 0, 0 );
   if (args_info->call_string_length_given)
     write_into_file(outfile, "call-string-length", args_info->call_string_length_orig, 0);
+  if (args_info->adaptive_context_given)
+    write_into_file(outfile, "adaptive-context", 0, 0 );
+  if (args_info->context_call_sites_given)
+    write_into_file(outfile, "context-call-sites", args_info->context_call_sites_orig, 0);
+  if (args_info->context_blocks_given)
+    write_into_file(outfile, "context-blocks", args_info->context_blocks_orig, 0);
+  if (args_info->function_time_budget_given)
+    write_into_file(outfile, "function-time-budget", args_info->function_time_budget_orig, 0);
+  if (args_info->function_memory_budget_given)
+    write_into_file(outfile, "function-memory-budget", args_info->function_memory_budget_orig, 0);
+  if (args_info->widening_threshold_given)
+    write_into_file(outfile, "widening-threshold", args_info->widening_threshold_orig, 0);
   if (args_info->ssi_type_given)
     write_into_file(outfile, "ssi-type", args_info->ssi_type_orig, cmdline_parser_ssi_type_values);
+  if (args_info->summary_db_given)
+    write_into_file(outfile, "summary-db", args_info->summary_db_orig, 0);
+  if (args_info->builtin_model_given)
+    write_into_file(outfile, "builtin-model", args_info->builtin_model_orig, 0);
   if (args_info->stats_given)
     write_into_file(outfile, "stats", 0, 0 );
   if (args_info->rt_stats_given)
@@ -1412,6 +1491,7 @@ cmdline_parser_internal (
         { "generate-c",	0, NULL, 0 },
         { "extension",	1, NULL, 0 },
         { "web-app",	1, NULL, 0 },
+        { "unboxed-locals",	0, NULL, 0 },
         { "with-php",	1, NULL, 0 },
         { "optimize",	1, NULL, 'O' },
         { "output",	1, NULL, 'o' },
@@ -1435,7 +1515,15 @@ cmdline_parser_internal (
         { "no-xml-attrs",	0, NULL, 0 },
         { "flow-insensitive",	0, NULL, 0 },
         { "call-string-length",	1, NULL, 0 },
+        { "adaptive-context",	0, NULL, 0 },
+        { "context-call-sites",	1, NULL, 0 },
+        { "context-blocks",	1, NULL, 0 },
+        { "function-time-budget",	1, NULL, 0 },
+        { "function-memory-budget",	1, NULL, 0 },
+        { "widening-threshold",	1, NULL, 0 },
         { "ssi-type",	1, NULL, 0 },
+        { "summary-db",	1, NULL, 0 },
+        { "builtin-model",	1, NULL, 0 },
         { "stats",	0, NULL, 0 },
         { "rt-stats",	0, NULL, 0 },
         { "cfg-dump",	1, NULL, 0 },
@@ -1763,6 +1851,18 @@ cmdline_parser_internal (
                 additional_error))
               goto failure;
           
+          }
+          /* Store local ints, reals and bools in C variables where the optimizer proves their types.  */
+          else if (strcmp (long_options[option_index].name, "unboxed-locals") == 0)
+          {
+          
+          
+            if (update_arg((void *)&(args_info->unboxed_locals_flag), 0, &(args_info->unboxed_locals_given),
+                &(local_args_info.unboxed_locals_given), optarg, 0, 0, ARG_FLAG,
+                check_ambiguity, override, 1, 0, "unboxed-locals", '-',
+                additional_error))
+              goto failure;
+          
           }
           /* PHP installation path.  */
           else if (strcmp (long_options[option_index].name, "with-php") == 0)
@@ -2006,6 +2106,88 @@ cmdline_parser_internal (
                 additional_error))
               goto failure;
           
+          }
+          /* Analyse large or widely-called functions context-insensitively.  */
+          else if (strcmp (long_options[option_index].name, "adaptive-context") == 0)
+          {
+          
+          
+            if (update_arg((void *)&(args_info->adaptive_context_flag), 0, &(args_info->adaptive_context_given),
+                &(local_args_info.adaptive_context_given), optarg, 0, 0, ARG_FLAG,
+                check_ambiguity, override, 1, 0, "adaptive-context", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* With --adaptive-context, the most call-sites a function may have and be analysed context-sensitively.  */
+          else if (strcmp (long_options[option_index].name, "context-call-sites") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->context_call_sites_arg), 
+                 &(args_info->context_call_sites_orig), &(args_info->context_call_sites_given),
+                &(local_args_info.context_call_sites_given), optarg, 0, "16", ARG_INT,
+                check_ambiguity, override, 0, 0,
+                "context-call-sites", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* With --adaptive-context, the most basic blocks a function may have and be analysed context-sensitively.  */
+          else if (strcmp (long_options[option_index].name, "context-blocks") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->context_blocks_arg), 
+                 &(args_info->context_blocks_orig), &(args_info->context_blocks_given),
+                &(local_args_info.context_blocks_given), optarg, 0, "200", ARG_INT,
+                check_ambiguity, override, 0, 0,
+                "context-blocks", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Analyse a function context-insensitively once it has taken MS milliseconds to analyse ('0' indicates no budget).  */
+          else if (strcmp (long_options[option_index].name, "function-time-budget") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->function_time_budget_arg), 
+                 &(args_info->function_time_budget_orig), &(args_info->function_time_budget_given),
+                &(local_args_info.function_time_budget_given), optarg, 0, "0", ARG_INT,
+                check_ambiguity, override, 0, 0,
+                "function-time-budget", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Analyse a function context-insensitively once its analysis has allocated MB megabytes ('0' indicates no budget).  */
+          else if (strcmp (long_options[option_index].name, "function-memory-budget") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->function_memory_budget_arg), 
+                 &(args_info->function_memory_budget_orig), &(args_info->function_memory_budget_given),
+                &(local_args_info.function_memory_budget_given), optarg, 0, "0", ARG_INT,
+                check_ambiguity, override, 0, 0,
+                "function-memory-budget", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Widen the analysis results at a loop header after it has been visited N times in a context ('0' disables widening).  */
+          else if (strcmp (long_options[option_index].name, "widening-threshold") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->widening_threshold_arg), 
+                 &(args_info->widening_threshold_orig), &(args_info->widening_threshold_given),
+                &(local_args_info.widening_threshold_given), optarg, 0, "3", ARG_INT,
+                check_ambiguity, override, 0, 0,
+                "widening-threshold", '-',
+                additional_error))
+              goto failure;
+          
           }
           /* Select SSI flavor..  */
           else if (strcmp (long_options[option_index].name, "ssi-type") == 0)
@@ -2020,6 +2202,34 @@ cmdline_parser_internal (
                 additional_error))
               goto failure;
           
+          }
+          /* Reuse summaries of side-effect-free functions from the database FILE, and add new ones to it.  */
+          else if (strcmp (long_options[option_index].name, "summary-db") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->summary_db_arg), 
+                 &(args_info->summary_db_orig), &(args_info->summary_db_given),
+                &(local_args_info.summary_db_given), optarg, 0, 0, ARG_STRING,
+                check_ambiguity, override, 0, 0,
+                "summary-db", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Read additional models of builtin functions from FILE.  */
+          else if (strcmp (long_options[option_index].name, "builtin-model") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->builtin_model_arg), 
+                 &(args_info->builtin_model_orig), &(args_info->builtin_model_given),
+                &(local_args_info.builtin_model_given), optarg, 0, 0, ARG_STRING,
+                check_ambiguity, override, 0, 0,
+                "builtin-model", '-',
+                additional_error))
+              goto failure;
+          
           }
           /* Print compile-time statistics.  */
           else if (strcmp (long_options[option_index].name, "stats") == 0)
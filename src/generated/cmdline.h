@@ -113,6 +113,8 @@ struct gengetopt_args_info
   char * web_app_arg;	/**< @brief Generate a web-application (experimental).  */
   char * web_app_orig;	/**< @brief Generate a web-application (experimental) original value given at command line.  */
   const char *web_app_help; /**< @brief Generate a web-application (experimental) help description.  */
+  int unboxed_locals_flag;	/**< @brief Store local ints, reals and bools in C variables where the optimizer proves their types (default=off).  */
+  const char *unboxed_locals_help; /**< @brief Store local ints, reals and bools in C variables where the optimizer proves their types help description.  */
   char * with_php_arg;	/**< @brief PHP installation path.  */
   char * with_php_orig;	/**< @brief PHP installation path original value given at command line.  */
   const char *with_php_help; /**< @brief PHP installation path help description.  */
@@ -173,9 +175,32 @@ struct gengetopt_args_info
   int call_string_length_arg;	/**< @brief Choose the call-string length ('0' indicates infinite call-string) (default='0').  */
   char * call_string_length_orig;	/**< @brief Choose the call-string length ('0' indicates infinite call-string) original value given at command line.  */
   const char *call_string_length_help; /**< @brief Choose the call-string length ('0' indicates infinite call-string) help description.  */
+  int adaptive_context_flag;	/**< @brief Analyse large or widely-called functions context-insensitively (default=off).  */
+  const char *adaptive_context_help; /**< @brief Analyse large or widely-called functions context-insensitively help description.  */
+  int context_call_sites_arg;	/**< @brief With --adaptive-context, the most call-sites a function may have and be analysed context-sensitively (default='16').  */
+  char * context_call_sites_orig;	/**< @brief With --adaptive-context, the most call-sites a function may have and be analysed context-sensitively original value given at command line.  */
+  const char *context_call_sites_help; /**< @brief With --adaptive-context, the most call-sites a function may have and be analysed context-sensitively help description.  */
+  int context_blocks_arg;	/**< @brief With --adaptive-context, the most basic blocks a function may have and be analysed context-sensitively (default='200').  */
+  char * context_blocks_orig;	/**< @brief With --adaptive-context, the most basic blocks a function may have and be analysed context-sensitively original value given at command line.  */
+  const char *context_blocks_help; /**< @brief With --adaptive-context, the most basic blocks a function may have and be analysed context-sensitively help description.  */
+  int function_time_budget_arg;	/**< @brief Analyse a function context-insensitively once it has taken MS milliseconds to analyse ('0' indicates no budget) (default='0').  */
+  char * function_time_budget_orig;	/**< @brief Analyse a function context-insensitively once it has taken MS milliseconds to analyse ('0' indicates no budget) original value given at command line.  */
+  const char *function_time_budget_help; /**< @brief Analyse a function context-insensitively once it has taken MS milliseconds to analyse ('0' indicates no budget) help description.  */
+  int function_memory_budget_arg;	/**< @brief Analyse a function context-insensitively once its analysis has allocated MB megabytes ('0' indicates no budget) (default='0').  */
+  char * function_memory_budget_orig;	/**< @brief Analyse a function context-insensitively once its analysis has allocated MB megabytes ('0' indicates no budget) original value given at command line.  */
+  const char *function_memory_budget_help; /**< @brief Analyse a function context-insensitively once its analysis has allocated MB megabytes ('0' indicates no budget) help description.  */
+  int widening_threshold_arg;	/**< @brief Widen the analysis results at a loop header after it has been visited N times in a context ('0' disables widening) (default='3').  */
+  char * widening_threshold_orig;	/**< @brief Widen the analysis results at a loop header after it has been visited N times in a context ('0' disables widening) original value given at command line.  */
+  const char *widening_threshold_help; /**< @brief Widen the analysis results at a loop header after it has been visited N times in a context ('0' disables widening) help description.  */
   enum enum_ssi_type ssi_type_arg;	/**< @brief Select SSI flavor. (default='ssi').  */
   char * ssi_type_orig;	/**< @brief Select SSI flavor. original value given at command line.  */
   const char *ssi_type_help; /**< @brief Select SSI flavor. help description.  */
+  char * summary_db_arg;	/**< @brief Reuse summaries of side-effect-free functions from the database FILE, and add new ones to it.  */
+  char * summary_db_orig;	/**< @brief Reuse summaries of side-effect-free functions from the database FILE, and add new ones to it original value given at command line.  */
+  const char *summary_db_help; /**< @brief Reuse summaries of side-effect-free functions from the database FILE, and add new ones to it help description.  */
+  char * builtin_model_arg;	/**< @brief Read additional models of builtin functions from FILE.  */
+  char * builtin_model_orig;	/**< @brief Read additional models of builtin functions from FILE original value given at command line.  */
+  const char *builtin_model_help; /**< @brief Read additional models of builtin functions from FILE help description.  */
   int stats_flag;	/**< @brief Print compile-time statistics (default=off).  */
   const char *stats_help; /**< @brief Print compile-time statistics help description.  */
   int rt_stats_flag;	/**< @brief Print statistics about a program at run-time (default=off).  */
@@ -225,6 +250,7 @@ struct gengetopt_args_info
   unsigned int generate_c_given ;	/**< @brief Whether generate-c was given.  */
   unsigned int extension_given ;	/**< @brief Whether extension was given.  */
   unsigned int web_app_given ;	/**< @brief Whether web-app was given.  */
+  unsigned int unboxed_locals_given ;	/**< @brief Whether unboxed-locals was given.  */
   unsigned int with_php_given ;	/**< @brief Whether with-php was given.  */
   unsigned int optimize_given ;	/**< @brief Whether optimize was given.  */
   unsigned int output_given ;	/**< @brief Whether output was given.  */
@@ -248,7 +274,15 @@ struct gengetopt_args_info
   unsigned int no_xml_attrs_given ;	/**< @brief Whether no-xml-attrs was given.  */
   unsigned int flow_insensitive_given ;	/**< @brief Whether flow-insensitive was given.  */
   unsigned int call_string_length_given ;	/**< @brief Whether call-string-length was given.  */
+  unsigned int adaptive_context_given ;	/**< @brief Whether adaptive-context was given.  */
+  unsigned int context_call_sites_given ;	/**< @brief Whether context-call-sites was given.  */
+  unsigned int context_blocks_given ;	/**< @brief Whether context-blocks was given.  */
+  unsigned int function_time_budget_given ;	/**< @brief Whether function-time-budget was given.  */
+  unsigned int function_memory_budget_given ;	/**< @brief Whether function-memory-budget was given.  */
+  unsigned int widening_threshold_given ;	/**< @brief Whether widening-threshold was given.  */
   unsigned int ssi_type_given ;	/**< @brief Whether ssi-type was given.  */
+  unsigned int summary_db_given ;	/**< @brief Whether summary-db was given.  */
+  unsigned int builtin_model_given ;	/**< @brief Whether builtin-model was given.  */
   unsigned int stats_given ;	/**< @brief Whether stats was given.  */
   unsigned int rt_stats_given ;	/**< @brief Whether rt-stats was given.  */
   unsigned int cfg_dump_given ;	/**< @brief Whether cfg-dump was given.  */
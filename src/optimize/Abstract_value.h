@@ -20,6 +20,7 @@
 #include "lib/String.h"
 
 namespace MIR { class Literal; }
+class Range_cell;
 
 typedef Set<string> Types;
 
@@ -29,9 +30,13 @@ public:
 	const MIR::Literal* const lit;
 	const Types* const types;
 
+	// The range of the value, if it is an int (see VRP). NULL if unknown.
+	const Range_cell* const range;
+
 public:
 	Abstract_value (const MIR::Literal* lit);
 	Abstract_value (const Types* types);
+	Abstract_value (const Types* types, const Range_cell* range);
 
 	// An unknown type is awful.
 	static Abstract_value* unknown ();
@@ -47,7 +52,7 @@ public:
 	void dump (std::ostream& os = cdebug) const;
 
 private:
-	Abstract_value (const MIR::Literal*, const Types* types);
+	Abstract_value (const MIR::Literal*, const Types* types, const Range_cell* range = NULL);
 };
 
 namespace Type_info
@@ -0,0 +1,186 @@
+/*
+ * phc -- the open source PHP compiler
+ * See doc/license/README.license for licensing information
+ *
+ * Declarative models of PHP builtin functions.
+ */
+
+#include <fstream>
+#include <sstream>
+
+#include "lib/error.h"
+#include "pass_manager/Pass_manager.h"
+
+#include "Builtin_model.h"
+
+extern Pass_manager* pm;
+
+using namespace std;
+using namespace boost;
+
+Value_model::Value_model (bool is_array, Types* types)
+: is_array (is_array)
+, types (types)
+{
+}
+
+Function_model::Function_model (String* name)
+: name (name)
+, returns (NULL)
+, pure (false)
+, foldable (false)
+, special (false)
+{
+}
+
+Map<string, Function_model*> Builtin_models::models;
+bool Builtin_models::initialized = false;
+
+void
+Builtin_models::initialize ()
+{
+	if (initialized)
+		return;
+
+	initialized = true;
+
+	// Check the current directory first, like the runtime files.
+	String* filename = s("models/builtins.model");
+	if (!ifstream (filename->c_str ()).is_open ())
+	{
+		stringstream ss;
+		ss << DATADIR << "/phc/models/builtins.model";
+		filename = s(ss.str ());
+	}
+
+	if (!ifstream (filename->c_str ()).is_open ())
+		phc_internal_error ("Expected file missing: %s", filename->c_str ());
+
+	load (filename);
+
+	if (pm->args_info->builtin_model_given)
+		load (s(pm->args_info->builtin_model_arg));
+}
+
+// Parse "int,string" or "array(int,string)". "-" is NULL.
+Value_model*
+Builtin_models::parse_value (string spec, String* filename, int line)
+{
+	if (spec == "-")
+		return NULL;
+
+	bool is_array = false;
+	if (spec.find ("array(") == 0)
+	{
+		if (spec[spec.size () - 1] != ')')
+			phc_error ("Expected ')' in '%s'", filename, line, 0, spec.c_str ());
+
+		is_array = true;
+		spec = spec.substr (6, spec.size () - 7);
+	}
+
+	Types* types = new Types;
+	stringstream ss (spec);
+	string type;
+	while (getline (ss, type, ','))
+		types->insert (type);
+
+	return new Value_model (is_array, types);
+}
+
+void
+Builtin_models::load (String* filename)
+{
+	ifstream file (filename->c_str ());
+	if (!file.is_open ())
+		phc_error ("Could not open model file", filename, 0, 0);
+
+	string text;
+	for (int line = 1; getline (file, text); line++)
+	{
+		if (text.size () == 0 || text[0] == '#')
+			continue;
+
+		stringstream ss (text);
+		string name, returns, coerced, flags;
+		ss >> name >> returns >> coerced >> flags;
+
+		if (name == "")
+			continue;
+
+		if (flags == "")
+			phc_error ("Expected 4 fields in model of '%s'", filename, line, 0, name.c_str ());
+
+		Function_model* model = new Function_model (s(name));
+		model->returns = parse_value (returns, filename, line);
+
+		if (coerced != "-")
+		{
+			stringstream cs (coerced);
+			string param;
+			while (getline (cs, param, ','))
+				model->coerced.push_back (atoi (param.c_str ()));
+		}
+
+		// Split the flags on commas, but not commas within array(...).
+		if (flags != "-")
+		{
+			int depth = 0;
+			string flag;
+			for (unsigned int i = 0; i <= flags.size (); i++)
+			{
+				if (i < flags.size () && (flags[i] != ',' || depth > 0))
+				{
+					if (flags[i] == '(') depth++;
+					if (flags[i] == ')') depth--;
+					flag += flags[i];
+					continue;
+				}
+
+				if (flag == "pure")
+					model->pure = true;
+				else if (flag == "fold")
+					model->foldable = true;
+				else if (flag == "special")
+					model->special = true;
+				else if (flag.find ("out:") == 0 && flag.find ('=') != string::npos)
+				{
+					int param = atoi (flag.substr (4).c_str ());
+					string value = flag.substr (flag.find ('=') + 1);
+					model->out_params[param] = parse_value (value, filename, line);
+				}
+				else
+					phc_error ("Unknown flag '%s' in model of '%s'", filename, line, 0, flag.c_str (), name.c_str ());
+
+				flag = "";
+			}
+		}
+
+		models[name] = model;
+	}
+}
+
+Function_model*
+Builtin_models::get_model (String* name)
+{
+	initialize ();
+
+	if (models.has (*name))
+		return models[*name];
+
+	return NULL;
+}
+
+bool
+Builtin_models::is_pure (String* name)
+{
+	Function_model* model = get_model (name);
+	return model && model->pure;
+}
+
+bool
+Builtin_models::is_foldable (String* name)
+{
+	Function_model* model = get_model (name);
+	return model && model->foldable;
+}
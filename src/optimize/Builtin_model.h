@@ -0,0 +1,76 @@
+/*
+ * phc -- the open source PHP compiler
+ * See doc/license/README.license for licensing information
+ *
+ * Declarative models of PHP builtin functions. The models are read from
+ * models/builtins.model (see that file for the format), and from any files
+ * given with --builtin-model.
+ */
+
+#ifndef PHC_BUILTIN_MODEL
+#define PHC_BUILTIN_MODEL
+
+#include "lib/List.h"
+#include "lib/Map.h"
+#include "lib/String.h"
+#include "Abstract_value.h"
+
+// A value the function returns, or writes to a by-ref parameter.
+class Value_model : virtual public GC_obj
+{
+public:
+	// If IS_ARRAY, TYPES are the types of the array's elements.
+	bool is_array;
+	Types* types;
+
+	Value_model (bool is_array, Types* types);
+};
+
+class Function_model : virtual public GC_obj
+{
+public:
+	String* name;
+
+	// NULL if the return value isnt modelled.
+	Value_model* returns;
+
+	// Parameters coerced to strings.
+	List<int> coerced;
+
+	// Values written to by-ref parameters, indexed by parameter.
+	Map<int, Value_model*> out_params;
+
+	// No side-effects.
+	bool pure;
+
+	// Deterministic, and so can be evaluated at compile-time.
+	bool foldable;
+
+	// Modelled in Whole_program.cpp, we only use the flags above.
+	bool special;
+
+	Function_model (String* name);
+};
+
+class Builtin_models
+{
+private:
+	Builtin_models ();
+	static Map<string, Function_model*> models;
+	static bool initialized;
+
+	static void initialize ();
+	static Value_model* parse_value (string spec, String* filename, int line);
+
+public:
+	// Add the models in FILENAME. Later models replace earlier ones.
+	static void load (String* filename);
+
+	// NULL if NAME isnt modelled.
+	static Function_model* get_model (String* name);
+
+	static bool is_pure (String* name);
+	static bool is_foldable (String* name);
+};
+
+#endif // PHC_BUILTIN_MODEL
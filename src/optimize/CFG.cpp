@@ -260,6 +260,23 @@ public:
 	}
 };
 
+class Back_edge_targets : public default_dfs_visitor, virtual public GC_obj
+{
+public:
+	Set<Basic_block*>* result;
+
+	Back_edge_targets (Set<Basic_block*>* result)
+	: result (result)
+	{
+	}
+
+	template <class Graph>
+	void back_edge (edge_t e, const Graph& g)
+	{
+		result->insert (get(vertex_bb_t(), g)[target (e, g)]);
+	}
+};
+
 
 #define FIELD_SEPARATOR " | "
 
@@ -1058,6 +1075,17 @@ CFG::get_all_bbs_top_down ()
 	return result;
 }
 
+Set<Basic_block*>*
+CFG::get_loop_headers ()
+{
+	Set<Basic_block*>* result = new Set<Basic_block*>;
+
+	renumber_vertex_indices ();
+	depth_first_search (bs, visitor (Back_edge_targets (result)).root_vertex (entry));
+
+	return result;
+}
+
 BB_list*
 CFG::get_all_bbs_bottom_up ()
 {
@@ -15,6 +15,7 @@
 
 #include "lib/List.h"
 #include "lib/Map.h"
+#include "lib/Set.h"
 #include "lib/String.h"
 
 #include "ssa/SSA_name.h"
@@ -258,6 +259,9 @@ public:
 	BB_list* get_all_bbs_top_down ();
 	BB_list* get_all_bbs_bottom_up ();
 
+	// Blocks which are the target of a back edge.
+	Set<Basic_block*>* get_loop_headers ();
+
 	Edge* get_entry_edge ();
 	Edge* get_exit_edge ();
 	Edge_list* get_all_edges ();
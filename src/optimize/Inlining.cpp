@@ -2,46 +2,348 @@
  * phc -- the open source PHP compiler
  * See doc/license/README.license for licensing information
  *
- * Very simple inlining. Probably just removing calls to empty functions.
-  */
+ * Inline small user functions whose bodies are straight-line code.
+ *
+ * Whole_program optimizes the methods bottom-up over the callgraph, so a
+ * callee has already had its own calls inlined by the time we look at it.
+ * The callee's locals are renamed with a fresh prefix, the parameters are
+ * bound by assignment (or by reference), and the return becomes an
+ * assignment to the call's LHS. The renamed locals are unset afterwards, so
+ * that each execution of the inlined body starts with them uninitialized,
+ * as a call would.
+ *
+ * The cost model is simple: very small callees are always inlined, since
+ * the call costs as much as the body. Somewhat larger callees are inlined
+ * only where they are called frequently, which we take to be inside loops.
+ */
 
 #include "Inlining.h"
 #include "Oracle.h"
 #include "process_ir/General.h"
 
 using namespace MIR;
+using namespace std;
+using namespace boost;
 
-void
-Inlining::transform_eval_expr (Statement_block* bb, Eval_expr* in, BB_list* out)
+// Callees with at most this many statements are always inlined.
+#define ALWAYS_INLINE_SIZE 4
+
+// Callees with at most this many statements are inlined into loops.
+#define LOOP_INLINE_SIZE 16
+
+static int num_inlined = 0;
+
+/*
+ * Return the statements of CFG, in order, or NULL if it has any branches.
+ */
+static Statement_list*
+get_straight_line_body (CFG* cfg)
 {
-	// remove it later
-	out->push_back (bb);
+	Statement_list* result = new Statement_list;
+	int num_bbs = cfg->get_all_bbs ()->size ();
 
-	Method_invocation* mi = dynamic_cast<Method_invocation*> (in->expr);
-	if (  mi == NULL
-		|| mi->target
-		|| isa<Variable_method> (mi->method_name))
-		return;
+	Basic_block* bb = cfg->get_entry_bb ()->get_successor ();
+	while (not isa<Exit_block> (bb))
+	{
+		// An infinite loop
+		if (num_bbs-- == 0)
+			return NULL;
+
+		if (isa<Branch_block> (bb))
+			return NULL;
+
+		if (Statement_block* sb = dynamic_cast<Statement_block*> (bb))
+		{
+			result->push_back (sb->statement);
+
+			// Anything after the return is dead.
+			if (isa<Return> (sb->statement))
+				break;
+		}
+
+		bb = bb->get_successor ();
+	}
+
+	return result;
+}
+
+static bool
+in_loop (Basic_block* bb)
+{
+	Set<Basic_block*> seen;
+	BB_list* worklist = bb->get_successors ();
+	while (worklist->size ())
+	{
+		Basic_block* next = worklist->front ();
+		worklist->pop_front ();
+
+		if (next == bb)
+			return true;
+
+		if (seen.has (next))
+			continue;
+
+		seen.insert (next);
+		worklist->push_back_all (next->get_successors ());
+	}
+
+	return false;
+}
+
+/*
+ * Find constructs which depend on being in their own function: access to the
+ * symbol table or the call stack, globals, statics, and recursion.
+ */
+class Inline_checker : public Visitor, virtual public GC_obj
+{
+public:
+	bool can_inline;
+	String* caller;
+	String* callee;
+
+	Inline_checker (String* caller, String* callee)
+	: can_inline (true)
+	, caller (caller)
+	, callee (callee)
+	{
+	}
+
+	void pre_global (Global*) { can_inline = false; }
+	void pre_static_declaration (Static_declaration*) { can_inline = false; }
+	void pre_variable_variable (Variable_variable*) { can_inline = false; }
+	void pre_assign_var_var (Assign_var_var*) { can_inline = false; }
+	void pre_foreach_reset (Foreach_reset*) { can_inline = false; }
+	void pre_try (Try*) { can_inline = false; }
+
+	void pre_method_invocation (Method_invocation* in)
+	{
+		METHOD_NAME* name = dynamic_cast<METHOD_NAME*> (in->method_name);
+		if (name == NULL)
+		{
+			can_inline = false;
+			return;
+		}
+
+		if (in->target)
+			return;
+
+		if (*name->value == *caller
+			or *name->value == *callee
+			or *name->value == "func_get_args"
+			or *name->value == "func_get_arg"
+			or *name->value == "func_num_args"
+			or *name->value == "get_defined_vars"
+			or *name->value == "debug_backtrace"
+			or *name->value == "debug_print_backtrace")
+		{
+			can_inline = false;
+		}
+	}
+
+	void pre_variable_name (VARIABLE_NAME* in)
+	{
+		if (*in->value == "this"
+			or *in->value == "GLOBALS"
+			or *in->value == "_GET"
+			or *in->value == "_POST"
+			or *in->value == "_COOKIE"
+			or *in->value == "_SERVER"
+			or *in->value == "_ENV"
+			or *in->value == "_FILES"
+			or *in->value == "_REQUEST"
+			or *in->value == "_SESSION")
+		{
+			can_inline = false;
+		}
+	}
+};
+
+/*
+ * Give the callee's locals fresh names in the caller.
+ */
+class Local_renamer : public Visitor, virtual public GC_obj
+{
+public:
+	string prefix;
+	Map<string, VARIABLE_NAME*> renamed;
+
+	Local_renamer (string prefix)
+	: prefix (prefix)
+	{
+	}
+
+	VARIABLE_NAME* rename (VARIABLE_NAME* in)
+	{
+		VARIABLE_NAME* result = in->clone ();
+		pre_variable_name (result);
+		return result;
+	}
+
+	void pre_variable_name (VARIABLE_NAME* in)
+	{
+		in->value = s (prefix + *in->value);
+
+		// The caller doesn't need a symbol table, so neither do these.
+		in->attrs->set_true ("phc.codegen.st_entry_not_required");
+
+		if (!renamed.has (*in->value))
+			renamed[*in->value] = in->clone ();
+	}
+};
+
+Statement_list*
+Inlining::inline_call (Statement_block* bb, Method_invocation* mi, VARIABLE_NAME* lhs)
+{
+	if (mi->target || isa<Variable_method> (mi->method_name))
+		return NULL;
 
-	// Simplest thing possible: remove calls to empty functions
 	User_method_info* info = Oracle::get_user_method_info (
 		dyc<METHOD_NAME> (mi->method_name)->value);
 
-	if (info == NULL)
-		return;
+	if (info == NULL || not info->has_implementation ())
+		return NULL;
+
+	Method* caller = bb->cfg->method;
+	Method* callee = info->get_method ();
+
+	// The renamed locals would be visible in the caller's symbol table, and
+	// __MAIN__'s locals are globals.
+	if (not caller->signature->method_name->attrs->is_true ("phc.codegen.st_entry_not_required")
+		|| not callee->signature->method_name->attrs->is_true ("phc.codegen.st_entry_not_required"))
+		return NULL;
+
+	if (callee->signature->return_by_ref)
+		return NULL;
+
+	Statement_list* body = get_straight_line_body (info->get_cfg ());
+	if (body == NULL)
+		return NULL;
+
+	// Cost model
+	int size = body->size ();
+	if (size > LOOP_INLINE_SIZE
+		|| (size > ALWAYS_INLINE_SIZE && not in_loop (bb)))
+		return NULL;
+
+	Inline_checker checker (caller->signature->method_name->value, info->name);
+	foreach (Statement* s, *body)
+		s->visit (&checker);
+	if (not checker.can_inline)
+		return NULL;
+
+
+	Statement_list* result = new Statement_list;
+	Local_renamer renamer ("INL" + lexical_cast<string> (num_inlined) + "_");
+
+	/*
+	 * Bind the parameters
+	 */
+	Formal_parameter_list* formals = callee->signature->formal_parameters;
+	Actual_parameter_list* actuals = mi->actual_parameters;
+	if (actuals->size () > formals->size ())
+		return NULL;
+
+	Actual_parameter_list::const_iterator ap = actuals->begin ();
+	foreach (Formal_parameter* fp, *formals)
+	{
+		// Type hints are checked by the call.
+		if (fp->type->class_name)
+			return NULL;
+
+		VARIABLE_NAME* param = renamer.rename (fp->var->variable_name);
+
+		if (ap != actuals->end ())
+		{
+			if ((*ap)->is_ref)
+				return NULL;
+
+			if (fp->is_ref)
+			{
+				VARIABLE_NAME* actual = dynamic_cast<VARIABLE_NAME*> ((*ap)->rvalue);
+				if (actual == NULL)
+					return NULL;
+
+				result->push_back (new Assign_var (param, true, actual->clone ()));
+			}
+			else
+				result->push_back (new Assign_var (param, false, (*ap)->rvalue->clone ()));
+
+			ap++;
+		}
+		else
+		{
+			// Missing parameters without defaults warn.
+			Static_value* default_value = fp->var->default_value;
+			if (not isa<Literal> (default_value) && not isa<Constant> (default_value))
+				return NULL;
 
-	// TODO: technically, we have ignored the problem that a function call can
-	// initialize a parameter which is called by ref. We've also ignored that
-	// elsewhere, which really needs to be fixed.
-	// TODO: shoudln't this be killed by DCE
-	// TODO: use a User_method_info property
+			result->push_back (new Assign_var (param, false, dyc<Expr> (default_value->clone ())));
+		}
+	}
 
-	// Empty CFGs have 2 statements only
-	if (info->get_cfg ()->get_all_bbs()->size() != 2)
+	/*
+	 * Copy the body
+	 */
+	bool has_return = false;
+	foreach (Statement* s, *body)
+	{
+		Statement* clone = s->clone ();
+		clone->visit (&renamer);
+
+		if (Return* ret = dynamic_cast<Return*> (clone))
+		{
+			if (lhs)
+				result->push_back (new Assign_var (lhs->clone (), false, ret->rvalue));
+
+			has_return = true;
+		}
+		else
+			result->push_back (clone);
+	}
+
+	if (lhs && not has_return)
+		result->push_back (new Assign_var (lhs->clone (), false, new NIL));
+
+	// Reinitialize the locals for the next time through.
+	string name;
+	VARIABLE_NAME* var;
+	foreach (tie (name, var), renamer.renamed)
+		result->push_back (new Unset (NULL, var, new Rvalue_list));
+
+	num_inlined++;
+	DEBUG ("BB " << bb->ID << ": inlining call to " << *info->name);
+
+	return result;
+}
+
+void
+Inlining::transform_eval_expr (Statement_block* bb, Eval_expr* in, BB_list* out)
+{
+	Method_invocation* mi = dynamic_cast<Method_invocation*> (in->expr);
+	Statement_list* inlined = mi ? inline_call (bb, mi, NULL) : NULL;
+
+	if (inlined == NULL)
+	{
+		out->push_back (bb);
 		return;
+	}
+
+	foreach (Statement* s, *inlined)
+		out->push_back (new Statement_block (bb->cfg, s));
+}
 
-	DEBUG ("BB " << bb->ID << ": removing call to " << *info->name);
+void
+Inlining::transform_assign_var (Statement_block* bb, Assign_var* in, BB_list* out)
+{
+	Method_invocation* mi = dynamic_cast<Method_invocation*> (in->rhs);
+	Statement_list* inlined = (mi && not in->is_ref) ? inline_call (bb, mi, in->lhs) : NULL;
+
+	if (inlined == NULL)
+	{
+		out->push_back (bb);
+		return;
+	}
 
-	// Remove it
-	out->clear ();
+	foreach (Statement* s, *inlined)
+		out->push_back (new Statement_block (bb->cfg, s));
 }
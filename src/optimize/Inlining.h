@@ -2,7 +2,7 @@
  * phc -- the open source PHP compiler
  * See doc/license/README.license for licensing information
  *
- * Very simple inlining. Probably just removing calls to empty functions.
+ * Inline small user functions whose bodies are straight-line code.
  */
 
 #ifndef PHC_INLINING
@@ -14,6 +14,10 @@ class Inlining : public Visit_once
 {
 public:
 	void transform_eval_expr (Statement_block* in, MIR::Eval_expr*, BB_list* out);
+	void transform_assign_var (Statement_block* in, MIR::Assign_var*, BB_list* out);
+
+private:
+	MIR::Statement_list* inline_call (Statement_block* bb, MIR::Method_invocation* mi, MIR::VARIABLE_NAME* lhs);
 };
 
 #endif // PHC_INLINING
@@ -0,0 +1,269 @@
+/*
+ * phc -- the open source PHP compiler
+ * See doc/license/README.license for licensing information
+ *
+ * Live-variable analysis over the final CFG, for code generation.
+ *
+ * This runs after the SSA form has been dropped, on the same code the
+ * generator sees, so it is a plain backwards dataflow problem over variable
+ * names. Only locals outside the symbol table are considered: nothing else
+ * can read their zvals, except through a reference, and the generated code
+ * checks that they are not references before moving them.
+ *
+ * Every occurrence of a variable is a use, except the LHS of a copy, which
+ * kills it. This is conservative for statements which define variables in
+ * other ways, such as by-reference parameters.
+ */
+
+#include "MIR_visitor.h"
+
+#include "Liveness.h"
+
+using namespace MIR;
+using namespace std;
+
+/*
+ * The variables a block uses, and the one it kills.
+ */
+class Use_collector : public Visitor, virtual public GC_obj
+{
+public:
+	Set<string> uses;
+
+	void pre_variable_name (VARIABLE_NAME* in)
+	{
+		uses.insert (*in->value);
+	}
+};
+
+static Set<string>
+get_uses (Basic_block* bb)
+{
+	Use_collector collector;
+
+	if (Statement_block* sb = dynamic_cast<Statement_block*> (bb))
+	{
+		Assign_var* assign = dynamic_cast<Assign_var*> (sb->statement);
+		if (assign && !assign->is_ref)
+			assign->rhs->visit (&collector);
+		else
+			sb->statement->visit (&collector);
+	}
+	else if (Branch_block* brb = dynamic_cast<Branch_block*> (bb))
+		collector.uses.insert (*brb->branch->variable_name->value);
+
+	return collector.uses;
+}
+
+static String*
+get_kill (Basic_block* bb)
+{
+	if (Statement_block* sb = dynamic_cast<Statement_block*> (bb))
+	{
+		Assign_var* assign = dynamic_cast<Assign_var*> (sb->statement);
+		if (assign && !assign->is_ref)
+			return assign->lhs->value;
+	}
+
+	return NULL;
+}
+
+/*
+ * Variables which are not in the symbol table.
+ */
+class Local_collector : public Visitor, virtual public GC_obj
+{
+public:
+	Set<string> locals;
+
+	void pre_variable_name (VARIABLE_NAME* in)
+	{
+		if (in->attrs->is_true ("phc.codegen.st_entry_not_required")
+			&& *in->value != "this")
+			locals.insert (*in->value);
+	}
+};
+
+/*
+ * Remove the marks from earlier runs, which inlining may have copied.
+ */
+class Last_use_remover : public Visitor, virtual public GC_obj
+{
+public:
+	void pre_variable_name (VARIABLE_NAME* in)
+	{
+		in->attrs->erase ("phc.optimize.last_use");
+	}
+};
+
+void
+Liveness::run (CFG* cfg)
+{
+	Last_use_remover remover;
+	foreach (Basic_block* bb, *cfg->get_all_bbs ())
+	{
+		if (Statement_block* sb = dynamic_cast<Statement_block*> (bb))
+		{
+			sb->statement->visit (&remover);
+			sb->statement->attrs->erase ("phc.optimize.dead_locals");
+		}
+	}
+
+	find_locals (cfg);
+	if (locals.size () == 0)
+		return;
+
+	solve (cfg);
+	mark_last_uses (cfg);
+	mark_dead_locals (cfg);
+}
+
+void
+Liveness::find_locals (CFG* cfg)
+{
+	locals.clear ();
+
+	// Copying the locals into the symbol table uses all of them.
+	if (cfg->method->signature->method_name->attrs->is_true ("phc.codegen.lazy_symbol_table"))
+		return;
+
+	foreach (Basic_block* bb, *cfg->get_all_bbs ())
+	{
+		Statement_block* sb = dynamic_cast<Statement_block*> (bb);
+		if (sb == NULL)
+			continue;
+
+		Local_collector collector;
+		sb->statement->visit (&collector);
+		foreach (string var, collector.locals)
+			locals.insert (var);
+	}
+}
+
+void
+Liveness::solve (CFG* cfg)
+{
+	live_out.clear ();
+
+	bool changed = true;
+	while (changed)
+	{
+		changed = false;
+		foreach (Basic_block* bb, *cfg->get_all_bbs ())
+		{
+			Set<string> out;
+			foreach (Basic_block* succ, *bb->get_successors ())
+			{
+				Set<string> in = live_out[succ->ID];
+				String* kill = get_kill (succ);
+				if (kill)
+					in.erase (*kill);
+
+				foreach (string use, get_uses (succ))
+					in.insert (use);
+
+				foreach (string var, in)
+				{
+					if (locals.has (var))
+						out.insert (var);
+				}
+			}
+
+			if (out != live_out[bb->ID])
+			{
+				live_out[bb->ID] = out;
+				changed = true;
+			}
+		}
+	}
+}
+
+bool
+Liveness::is_dead_after (Basic_block* bb, VARIABLE_NAME* var)
+{
+	return locals.has (*var->value) && !live_out[bb->ID].has (*var->value);
+}
+
+// Mark a copy of VAR, which may be shared with other statements.
+VARIABLE_NAME*
+Liveness::last_use (VARIABLE_NAME* var)
+{
+	VARIABLE_NAME* result = var->clone ();
+	result->attrs->set_true ("phc.optimize.last_use");
+	return result;
+}
+
+void
+Liveness::mark_last_uses (CFG* cfg)
+{
+	foreach (Basic_block* bb, *cfg->get_all_bbs ())
+	{
+		Statement_block* sb = dynamic_cast<Statement_block*> (bb);
+		if (sb == NULL)
+			continue;
+
+		// $x = $y;
+		if (Assign_var* assign = dynamic_cast<Assign_var*> (sb->statement))
+		{
+			VARIABLE_NAME* rhs = dynamic_cast<VARIABLE_NAME*> (assign->rhs);
+			if (rhs
+				&& !assign->is_ref
+				&& *rhs->value != *assign->lhs->value
+				&& is_dead_after (bb, rhs))
+				assign->rhs = last_use (rhs);
+		}
+
+		// return $x;
+		if (Return* ret = dynamic_cast<Return*> (sb->statement))
+		{
+			VARIABLE_NAME* rvalue = dynamic_cast<VARIABLE_NAME*> (ret->rvalue);
+			if (rvalue && locals.has (*rvalue->value))
+				ret->rvalue = last_use (rvalue);
+		}
+	}
+}
+
+/*
+ * A local dies after a statement if it is live before it, or the statement
+ * uses or defines it, but it is not live after it. Variables which die on
+ * the edge out of a branch are listed on the statement after the edge.
+ */
+void
+Liveness::mark_dead_locals (CFG* cfg)
+{
+	foreach (Basic_block* bb, *cfg->get_all_bbs ())
+	{
+		Statement_block* sb = dynamic_cast<Statement_block*> (bb);
+		if (sb == NULL)
+			continue;
+
+		// The function is about to release everything anyway.
+		if (isa<Return> (sb->statement))
+			continue;
+
+		Set<string> candidates = get_uses (bb);
+		if (String* kill = get_kill (bb))
+			candidates.insert (*kill);
+
+		foreach (Basic_block* pred, *bb->get_predecessors ())
+			foreach (string var, live_out[pred->ID])
+				candidates.insert (var);
+
+		List<string>* names = candidates.to_list ();
+		names->sort ();
+
+		VARIABLE_NAME_list* dead = new VARIABLE_NAME_list;
+		foreach (string var, *names)
+		{
+			if (locals.has (var) && !live_out[bb->ID].has (var))
+			{
+				VARIABLE_NAME* var_name = new VARIABLE_NAME (s(var));
+				var_name->attrs->set_true ("phc.codegen.st_entry_not_required");
+				dead->push_back (var_name);
+			}
+		}
+
+		if (dead->size ())
+			sb->statement->attrs->set_list ("phc.optimize.dead_locals", dead);
+	}
+}
@@ -0,0 +1,43 @@
+/*
+ * phc -- the open source PHP compiler
+ * See doc/license/README.license for licensing information
+ *
+ * Live-variable analysis over the final CFG, for code generation. Uses
+ * of a local whose value is not used afterwards are marked with
+ * phc.optimize.last_use, so that the generated code can move its zval
+ * instead of sharing it. Statements after which locals die list them in
+ * phc.optimize.dead_locals, so that the generated code can release them
+ * without waiting for the function to return. The Optimization_annotator
+ * decides which of them are safe to release (phc.optimize.releasable).
+ */
+
+#ifndef PHC_LIVENESS
+#define PHC_LIVENESS
+
+#include "lib/Map.h"
+#include "lib/Set.h"
+
+#include "CFG_visitor.h"
+
+class Liveness : public CFG_visitor
+{
+public:
+	void run (CFG* cfg);
+
+private:
+	// Locals whose uses we can mark.
+	Set<string> locals;
+
+	// Basic_block ID -> variables live after the block.
+	Map<long, Set<string> > live_out;
+
+	void find_locals (CFG* cfg);
+	void solve (CFG* cfg);
+	void mark_last_uses (CFG* cfg);
+	void mark_dead_locals (CFG* cfg);
+
+	bool is_dead_after (Basic_block* bb, MIR::VARIABLE_NAME* var);
+	MIR::VARIABLE_NAME* last_use (MIR::VARIABLE_NAME* var);
+};
+
+#endif // PHC_LIVENESS
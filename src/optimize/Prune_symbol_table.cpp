@@ -4,6 +4,12 @@
  *
  * We can easily tell when a function isnt using its symbol table. If they
  * arent, mark the variables in a function as not using the symbol table.
+ *
+ * Functions which only use their symbol table in a few statements (variable
+ * variables, compact, extract, include, etc) are marked with
+ * phc.codegen.lazy_symbol_table. Their variables are marked as not using the
+ * symbol table too, and the code generator builds the symbol table only
+ * when one of those statements runs.
  */
 
 
@@ -39,6 +45,7 @@ using namespace std;
 // TODO: pruning globals is not correct. However, pruning superglobals still should be.
 Prune_symbol_table::Prune_symbol_table () 
 : prune (false)
+, lazy (false)
 , var_reflection_present (false)
 {
 	vars = new Map<string, bool>;
@@ -50,6 +57,9 @@ public:
 	bool prune;
 	bool var_reflection_present;
 
+	// The symbol table is used by a statement
+	bool uses_symbol_table;
+
 	// variables which are present anywhere in the method
 	Map<string, bool>* vars;
 
@@ -60,6 +70,7 @@ public:
 	Analysis (Map<string, bool>* vars)
 	: prune (true)
 	, var_reflection_present (false)
+	, uses_symbol_table (false)
 	, vars(vars)
 	, record_globals(true)
 	{
@@ -67,30 +78,36 @@ public:
 
 	void pre_variable_variable (Variable_variable* in)
 	{
-		prune = false;
+		uses_symbol_table = true;
+	}
+
+	void pre_assign_var_var (Assign_var_var* in)
+	{
+		uses_symbol_table = true;
 	}
 
 
 	void pre_method_invocation (Method_invocation* in)
 	{
 		METHOD_NAME* name = dynamic_cast<METHOD_NAME*>(in->method_name);
-		if (name && (
-					// TODO look at extract () and anything else that affects the symbol table
+		if (name && in->target == NULL && (
 					*name->value == "eval"
 					or *name->value == "include"
 					or *name->value == "require" 
 					or *name->value == "extract" 
 					or *name->value == "compact" 
+					or *name->value == "get_defined_vars" 
+					or *name->value == "parse_str" 
 					or *name->value == "include_once" 
 					or *name->value == "require_once"))
 		{
-			prune = false;
+			uses_symbol_table = true;
 		}
 		else if (name == NULL)
 		{
 			// Although eval, include etc are builtin, and cant be called as
 			// variable-methods, compact and extract can.
-			prune = false;
+			uses_symbol_table = true;
 		}
 	}
 
@@ -125,23 +142,35 @@ public:
 
 };
 
+bool
+uses_symbol_table (Statement* in)
+{
+	Analysis a (new Map<string, bool>);
+	in->visit (&a);
+	return a.uses_symbol_table;
+}
+
 // We do the "analysis" in the pre_ methods, and update in the post_ methods.
 void Prune_symbol_table::pre_method (Method* in)
 {
 	Analysis a (vars);
 	in->visit (&a);
-	prune = a.prune;
+	prune = a.prune && !a.uses_symbol_table;
+	lazy = a.prune && a.uses_symbol_table;
 	var_reflection_present = a.var_reflection_present;
 	vars = a.vars;
 
 	// We cant prune in __MAIN__, due to globals.
 	if (*in->signature->method_name->value == "__MAIN__")
+	{
 		prune = false;
+		lazy = false;
+	}
 }
 
 void Prune_symbol_table::post_variable_name (VARIABLE_NAME* in)
 {
-	if (prune)
+	if (prune || lazy)
 		in->attrs->set_true ("phc.codegen.st_entry_not_required");
 }
 
@@ -188,5 +217,7 @@ void Prune_symbol_table::post_method (Method* in)
 		if (!var_reflection_present)
 			in->transform_children (new Remove_globals (vars));
 	}
+	else if (lazy)
+		in->signature->method_name->attrs->set_true ("phc.codegen.lazy_symbol_table");
 }
 
@@ -15,6 +15,7 @@ class Prune_symbol_table : public MIR::Visitor, public virtual GC_obj
 {
 private:
 	bool prune;
+	bool lazy;
 	bool var_reflection_present;
 	Map<string, bool>* vars;
 
@@ -28,4 +29,7 @@ public:
 	void post_variable_name (MIR::VARIABLE_NAME* in);
 };
 
+// Does the statement use the symbol table of the function its in?
+bool uses_symbol_table (MIR::Statement* in);
+
 #endif  // _PRUNE_SYMBOL_TABLE_H_
@@ -116,7 +116,7 @@ Aliasing::backward_bind (Context* caller, Context* exit)
 	ptg->consistency_check (exit, R_OUT, wp);
 
 	// No point clearing if there isn't an infinite call-string.
-	if (wp->pm->args_info->call_string_length_arg == 0)
+	if (exit->has_unbounded_call_string ())
 		ptg->close_scope (exit->symtable_node ());
 
 	// See comment in WPA_lattice.
@@ -194,6 +194,15 @@ Aliasing::finish_block (Context* cx)
 	outs[cx] = ptg;
 }
 
+void
+Aliasing::release_block (Context* cx)
+{
+	// WORKING is not shared with OUT, as OUT has had its unreachable nodes
+	// removed, so this saves a whole graph per block.
+	working.erase (cx);
+	post_bind.erase (cx);
+}
+
 void
 Aliasing::kill_value (Context* cx, const Index_node* lhs, bool also_kill_refs)
 {
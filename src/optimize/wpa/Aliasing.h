@@ -81,6 +81,7 @@ public:
 
 
 	void finish_block (Context* cx);
+	void release_block (Context* cx);
 
 	bool equals (WPA* other);
 	void dump (Context* cx, Result_state state, string comment) const;
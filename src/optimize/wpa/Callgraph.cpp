@@ -44,36 +44,76 @@ Callgraph::bottom_up ()
 {
 	Method_info_list* result = new Method_info_list;
 
-	Method_info_list* worklist = new Method_info_list;
-	
-	foreach (Method_info* mi, methods)
-	{
-		if (*mi->name == "__MAIN__")
-			worklist->push_back (mi);
-	}
+	foreach (Method_info_list* scc, *get_sccs ())
+		result->push_back_all (scc);
 
-	Set<Method_info*> seen;
+	return result;
+}
 
-	while (worklist->size ())
-	{
-		Method_info* info = worklist->front ();
-		worklist->pop_front ();
+/*
+ * Tarjan's algorithm. An SCC is only completed once every SCC it can reach
+ * has been completed, so the SCCs come out with callees first.
+ */
+List<Method_info_list*>*
+Callgraph::get_sccs ()
+{
+	List<Method_info_list*>* result = new List<Method_info_list*>;
 
-		if (seen.has (info))
-			continue;
+	Map<Method_info*, int> index;
+	Map<Method_info*, int> lowlink;
+	Method_info_list* stack = new Method_info_list;
+	Set<Method_info*> on_stack;
 
-		seen.insert (info);
+	foreach (Method_info* mi, methods)
+	{
+		if (*mi->name == "__MAIN__" && !index.has (mi))
+			find_sccs (mi, index, lowlink, stack, on_stack, result);
+	}
 
-		// Note _front_ for bottom-up
-		result->push_front (info);
+	return result;
+}
 
-		// Successors
-		foreach (Method_info* mi, call_edges[info])
-			worklist->push_back (mi);
+void
+Callgraph::find_sccs (Method_info* info,
+							 Map<Method_info*, int>& index,
+							 Map<Method_info*, int>& lowlink,
+							 Method_info_list* stack,
+							 Set<Method_info*>& on_stack,
+							 List<Method_info_list*>* result)
+{
+	int num = index.size ();
+	index[info] = num;
+	lowlink[info] = num;
+	stack->push_front (info);
+	on_stack.insert (info);
 
+	foreach (Method_info* callee, call_edges[info])
+	{
+		if (!index.has (callee))
+		{
+			find_sccs (callee, index, lowlink, stack, on_stack, result);
+			lowlink[info] = min (lowlink[info], lowlink[callee]);
+		}
+		else if (on_stack.has (callee))
+			lowlink[info] = min (lowlink[info], index[callee]);
 	}
 
-	return result;
+	// INFO is the root of an SCC: pop its members.
+	if (lowlink[info] == index[info])
+	{
+		Method_info_list* scc = new Method_info_list;
+		Method_info* member;
+		do
+		{
+			member = stack->front ();
+			stack->pop_front ();
+			on_stack.erase (member);
+			scc->push_front (member);
+		}
+		while (member != info);
+
+		result->push_back (scc);
+	}
 }
 
 bool
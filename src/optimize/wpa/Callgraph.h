@@ -27,6 +27,10 @@ public:
 	Method_info_list* get_called_methods ();
 	Method_info_list* bottom_up ();
 
+	// The strongly connected components of the callgraph, reachable from
+	// __MAIN__, with callees before their callers.
+	List<Method_info_list*>* get_sccs ();
+
 	bool equals (WPA* other);
 	void dump (Context* cx, Result_state state, string comment) const;
 	void dump_everything (string comment) const;
@@ -39,6 +43,13 @@ public:
 	Class_info_list* get_used_classes ();
 private:
 
+	void find_sccs (Method_info* info,
+						 Map<Method_info*, int>& index,
+						 Map<Method_info*, int>& lowlink,
+						 Method_info_list* stack,
+						 Set<Method_info*>& on_stack,
+						 List<Method_info_list*>* result);
+
 	void dump_graphviz (String* label) const;
 };
 
@@ -9,6 +9,8 @@
 
 #include "Context.h"
 #include "Points_to.h"
+#include "optimize/Class_info.h"
+#include "optimize/Method_info.h"
 
 using namespace std;
 using namespace boost;
@@ -120,6 +122,16 @@ Context::name () const
 	if (pm->args_info->call_string_length_arg == 0)
 		ignore_length = 0;
 
+	// A collapsed method's context is only its own block. It would hide
+	// recursion from the check below, so check it here.
+	if (use_caller && is_collapsed (get_bb ()))
+	{
+		if (is_recursive ())
+			phc_optimization_exception ("Recursion not supported");
+
+		ignore_length = BBs.size () - 1;
+	}
+
 	stringstream ss;
 	foreach (Basic_block* bb, BBs)
 	{
@@ -159,6 +171,39 @@ Context::is_recursive () const
 	return false;
 }
 
+bool
+Context::has_unbounded_call_string () const
+{
+	return pm->args_info->call_string_length_arg == 0
+		&& !(use_caller && is_collapsed (get_bb ()));
+}
+
+Set<string> Context::collapsed_methods;
+
+string
+Context::method_name (Basic_block* bb)
+{
+	string name = *bb->cfg->method->signature->method_name->value;
+
+	Method_info* info = bb->cfg->method_info;
+	if (info && info->get_class_info ())
+		return *info->get_class_info ()->name + "::" + name;
+
+	return name;
+}
+
+void
+Context::collapse (Basic_block* bb)
+{
+	collapsed_methods.insert (method_name (bb));
+}
+
+bool
+Context::is_collapsed (Basic_block* bb)
+{
+	return collapsed_methods.has (method_name (bb));
+}
+
 string
 Context::full_name () const
 {
@@ -184,7 +229,7 @@ Context::symtable_name () const
 	// TODO: This name should include the class, or else we're overlapping other
 	// methods of the same name.
 
-	if (this->use_caller)
+	if (this->use_caller && !is_collapsed (get_bb ()))
 		return "SYM" + get_bb()->get_prefix () + this->caller ()->name();
 	else
 		return "SYM" + get_bb()->get_prefix ();
@@ -10,6 +10,7 @@
 
 #include <ostream>
 
+#include "lib/Set.h"
 #include "optimize/Lattice.h"
 #include "optimize/CFG_visitor.h"
 
@@ -63,6 +64,23 @@ public:
 
 	bool is_recursive () const;
 
+	// Does the name include the whole call-string?
+	bool has_unbounded_call_string () const;
+
+	/*
+	 * Adaptive context-sensitivity. All contexts of a collapsed method have
+	 * the same name, so the method is analysed context-insensitively from
+	 * then on. Collapsing is permanent, so that later iterations of the
+	 * whole-program analysis see consistent names.
+	 */
+	static void collapse (Basic_block* bb);
+	static bool is_collapsed (Basic_block* bb);
+
+	// The name of BB's method, qualified by its class.
+	static string method_name (Basic_block* bb);
+
+private:
+	static Set<string> collapsed_methods;
 };
 
 std::ostream &operator<< (std::ostream &out, const Context* cx);
@@ -166,6 +166,18 @@ Debug_WPA::pull_finish (Context* cx)
 	DEBUG (__FUNCTION__ << " " << cx);
 }
 
+void
+Debug_WPA::save_for_widening (Context* cx)
+{
+	DEBUG (__FUNCTION__ << " " << cx);
+}
+
+void
+Debug_WPA::widen (Context* cx)
+{
+	DEBUG (__FUNCTION__ << " " << cx);
+}
+
 
 void
 Debug_WPA::finish_block (Context* cx)
@@ -173,6 +185,12 @@ Debug_WPA::finish_block (Context* cx)
 	DEBUG (__FUNCTION__ << " " << cx);
 }
 
+void
+Debug_WPA::release_block (Context* cx)
+{
+	DEBUG (__FUNCTION__ << " " << cx);
+}
+
 bool
 Debug_WPA::solution_changed (Context* cx) const
 {
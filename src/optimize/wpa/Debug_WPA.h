@@ -43,7 +43,11 @@ public:
 	void pull_possible_null (Context* cx, const Index_node* node);
 	void pull_finish (Context* cx);
 
+	void save_for_widening (Context* cx);
+	void widen (Context* cx);
+
 	void finish_block (Context* cx);
+	void release_block (Context* cx);
 
 	bool solution_changed (Context* cx) const;
 	bool has_analysis_result (Context* cx, Result_state) const;
@@ -6,8 +6,12 @@
  * code.
  * */
 
+#include "lib/Integer.h"
+
 #include "Aliasing.h"
 #include "Points_to.h"
+#include "Value_analysis.h"
+#include "VRP.h"
 #include "Whole_program.h"
 
 #include "Optimization_annotator.h"
@@ -42,6 +46,136 @@ Optimization_annotator::visit_entry_block (Entry_block* bb)
 	bb->cfg->method->attrs->set_true ("phc.optimize.used");
 }
 
+/*
+ * Mark each variable whose type is known, and each literal, with
+ * phc.optimize.type, for the code generator.
+ */
+class Type_annotator : public MIR::Visitor, virtual public GC_obj
+{
+public:
+	Whole_program* wp;
+	Context* cx;
+	Result_state state;
+
+	Type_annotator (Whole_program* wp, Context* cx, Result_state state)
+	: wp (wp)
+	, cx (cx)
+	, state (state)
+	{
+	}
+
+	static String* get_type (Whole_program* wp, Context* cx, Result_state state, Rvalue* in)
+	{
+		const Abstract_value* absval = wp->get_abstract_value (cx, state, in);
+		if (absval->types == NULL || absval->types->size () != 1)
+			return NULL;
+
+		return s (*absval->types->begin ());
+	}
+
+	void pre_variable_name (VARIABLE_NAME* in)
+	{
+		annotate (get_type (wp, cx, state, in), in);
+	}
+
+	void pre_literal (Literal* in)
+	{
+		annotate (get_type (wp, cx, state, in), in);
+	}
+
+	static void annotate (String* type, Rvalue* in)
+	{
+		if (type)
+			in->attrs->set ("phc.optimize.type", type);
+		else
+			in->attrs->erase ("phc.optimize.type");
+	}
+};
+
+/*
+ * Can INDEX's value only be a scalar, or an array holding only scalars
+ * (including in nested arrays)? Releasing such a value can not run a
+ * destructor or close a resource.
+ */
+static bool
+holds_only_scalars (Whole_program* wp, Context* cx, const Index_node* index, Set<const Storage_node*>& seen)
+{
+	const Abstract_value* absval = wp->values->get_value (cx, R_OUT, index)->value;
+	if (absval->types == NULL)
+		return false;
+
+	foreach (string type, *absval->types)
+	{
+		if (Type_info::is_scalar (type))
+			continue;
+
+		if (type != "array")
+			return false;
+
+		foreach (const Storage_node* st, *wp->aliasing->get_points_to (cx, R_OUT, index))
+		{
+			if (isa<Value_node> (st) || seen.has (st))
+				continue;
+
+			seen.insert (st);
+			foreach (const Index_node* field, *wp->aliasing->get_fields (cx, R_OUT, st))
+				if (!holds_only_scalars (wp, cx, field, seen))
+					return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+ * Locals which die after the statement (see Liveness) are marked with
+ * phc.optimize.releasable if they can be released straight away. Releasing
+ * anything which may hold an object would run its destructor earlier than
+ * PHP does.
+ */
+static void
+mark_releasable_locals (Whole_program* wp, Context* cx, Statement* in)
+{
+	if (!in->attrs->has ("phc.optimize.dead_locals"))
+		return;
+
+	foreach (VARIABLE_NAME* var, *in->attrs->get_list<VARIABLE_NAME> ("phc.optimize.dead_locals"))
+	{
+		Set<const Storage_node*> seen;
+		if (holds_only_scalars (wp, cx, VN (cx->symtable_name (), var), seen))
+			var->attrs->set_true ("phc.optimize.releasable");
+	}
+}
+
+void
+Optimization_annotator::visit_statement_block (Statement_block* bb)
+{
+	Context* cx = Context::non_contextual (bb);
+	bb->statement->visit (new Type_annotator (wp, cx, R_IN));
+
+	mark_releasable_locals (wp, cx, bb->statement);
+
+	// Variables defined by the statement have their new type.
+	if (Assign_var* av = dynamic_cast<Assign_var*> (bb->statement))
+	{
+		Type_annotator::annotate (
+			Type_annotator::get_type (wp, cx, R_OUT, av->lhs), av->lhs);
+	}
+	else if (Pre_op* pre_op = dynamic_cast<Pre_op*> (bb->statement))
+	{
+		String* in_type = Type_annotator::get_type (wp, cx, R_IN, pre_op->variable_name);
+		String* out_type = Type_annotator::get_type (wp, cx, R_OUT, pre_op->variable_name);
+		if (in_type == NULL || out_type == NULL || *in_type != *out_type)
+			Type_annotator::annotate (NULL, pre_op->variable_name);
+	}
+}
+
+void
+Optimization_annotator::visit_branch_block (Branch_block* bb)
+{
+	Context* cx = Context::non_contextual (bb);
+	bb->branch->visit (new Type_annotator (wp, cx, R_IN));
+}
 
 void
 Optimization_annotator::visit_assign_array (Statement_block* bb, MIR::Assign_array* in)
@@ -58,9 +192,139 @@ Optimization_annotator::visit_assign_next (Statement_block* bb, MIR::Assign_next
 {
 }
 
+/*
+ * Escape analysis. An array escapes its function if, once the function
+ * returns, it can be reached from anything other than the function's own
+ * local variables: the return value, globals, statics, parameters, or other
+ * arrays and objects which escape. We also treat anything aliased by
+ * reference as escaping.
+ */
+static bool
+escapes (Whole_program* wp, Context* exit_cx, const Storage_node* st)
+{
+	Aliasing* aliasing = wp->aliasing;
+
+	// It is already dead.
+	if (!aliasing->has_storage_node (exit_cx, R_OUT, st))
+		return false;
+
+	string symtable = exit_cx->symtable_name ();
+
+	Set<const Storage_node*> seen;
+	cStorage_node_list* worklist = new cStorage_node_list (st);
+	while (worklist->size ())
+	{
+		const Storage_node* next = worklist->front ();
+		worklist->pop_front ();
+
+		if (seen.has (next))
+			continue;
+		seen.insert (next);
+
+		cIndex_node_list* incoming = aliasing->get_incoming (exit_cx, R_OUT, next);
+
+		// Reachable from some root other than our symbol table.
+		if (next != st && incoming->size () == 0)
+			return true;
+
+		foreach (const Index_node* index, *incoming)
+		{
+			if (index->storage == symtable)
+			{
+				if (index->index == RETNAME)
+					return true;
+
+				if (aliasing->get_references (exit_cx, R_OUT, index, PTG_ALL)->size ())
+					return true;
+			}
+			else if (index->storage.find ("SYM") == 0)
+				return true;
+			else
+				worklist->push_back (SN (index->storage));
+		}
+	}
+
+	return false;
+}
+
+// INDEX is a decimal integer key which fits a 32-bit long, as a list would
+// use.
+static bool
+is_list_index (string index)
+{
+	if (index.size () == 0 || index.size () > 9)
+		return false;
+
+	if (index[0] == '0' && index.size () > 1)
+		return false;
+
+	foreach (char c, index)
+	{
+		if (c < '0' || c > '9')
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Nothing outside a function can add to an array which does not escape it,
+ * and which is only allocated once per call, so we know how many entries it
+ * will have. Mark that with phc.optimize.array_size, so that its hashtable
+ * can be allocated at the right size. If all of the indices we know are
+ * small non-negative integers, the array is likely to be a list, and is
+ * marked with phc.optimize.packed_array.
+ */
 void
 Optimization_annotator::visit_assign_var (Statement_block* bb, MIR::Assign_var* in)
 {
+	if (in->is_ref)
+		return;
+
+	Context* cx = Context::non_contextual (bb);
+
+	// Arrays are created by casting a NULL (MIR has no array literals).
+	Cast* cast = dynamic_cast<Cast*> (in->rhs);
+	if (cast == NULL || *cast->cast->value != "array")
+		return;
+
+	const Abstract_value* operand = wp->get_abstract_value (cx, R_IN, cast->variable_name);
+	if (operand->types == NULL || *operand->types != Types ("unset"))
+		return;
+
+	Context* exit_cx = Context::non_contextual (bb->cfg->get_exit_bb ());
+	if (!wp->aliasing->has_analysis_result (exit_cx, R_OUT))
+		return;
+
+	const Index_node* lhs = VN (cx->symtable_name (), in->lhs);
+	cStorage_node_list* storages = wp->aliasing->get_points_to (cx, R_OUT, lhs);
+	if (storages->size () != 1)
+		return;
+
+	const Storage_node* st = storages->front ();
+	if (isa<Value_node> (st)
+		|| wp->aliasing->is_abstract (cx, R_OUT, st)
+		|| escapes (wp, exit_cx, st))
+		return;
+
+	if (wp->aliasing->has_storage_node (exit_cx, R_OUT, st))
+	{
+		long size = 0;
+		bool packed = true;
+		foreach (const Index_node* field, *wp->aliasing->get_fields (exit_cx, R_OUT, st))
+		{
+			if (field->index != UNKNOWN)
+			{
+				size++;
+				packed = packed && is_list_index (field->index);
+			}
+		}
+
+		in->attrs->set ("phc.optimize.array_size", new ::Integer (size));
+
+		if (packed)
+			in->attrs->set_true ("phc.optimize.packed_array");
+	}
 }
 
 void
@@ -116,6 +380,11 @@ Optimization_annotator::visit_method_alias (Statement_block* bb, MIR::Method_ali
 void
 Optimization_annotator::visit_pre_op (Statement_block* bb, MIR::Pre_op* in)
 {
+	Context* cx = Context::non_contextual (bb);
+	const Abstract_value* operand = wp->get_abstract_value (cx, R_IN, in->variable_name);
+
+	if (VRP::cannot_overflow (operand, *in->op->value))
+		in->attrs->set_true ("phc.optimize.no_overflow");
 }
 
 void
@@ -157,6 +426,14 @@ Optimization_annotator::visit_array_next (Statement_block* bb, MIR::Array_next*
 void
 Optimization_annotator::visit_bin_op (Statement_block* bb, MIR::Bin_op* in)
 {
+	// The result of integer arithmetic which cannot overflow is always an
+	// int, so the generated code doesnt need to check.
+	Context* cx = Context::non_contextual (bb);
+	const Abstract_value* left = wp->get_abstract_value (cx, R_IN, in->left);
+	const Abstract_value* right = wp->get_abstract_value (cx, R_IN, in->right);
+
+	if (VRP::cannot_overflow (left, right, *in->op->value))
+		in->attrs->set_true ("phc.optimize.no_overflow");
 }
 
 void
@@ -210,9 +487,35 @@ Optimization_annotator::visit_isset (Statement_block* bb, MIR::Isset* in)
 }
 
 
+// Method calls whose receiver can only be one of this many classes are
+// devirtualized.
+#define MAX_RECEIVER_CLASSES 4
+
+/*
+ * Mark method calls on objects of a few known classes with
+ * phc.optimize.receiver_classes, the number of classes, so the code generator
+ * can cache the method for each.
+ */
 void
 Optimization_annotator::visit_method_invocation (Statement_block* bb, MIR::Method_invocation* in)
 {
+	VARIABLE_NAME* target = dynamic_cast<VARIABLE_NAME*> (in->target);
+	if (target == NULL || not isa<METHOD_NAME> (in->method_name))
+		return;
+
+	Context* cx = Context::non_contextual (bb);
+	const Abstract_value* absval = wp->get_abstract_value (cx, R_IN, target);
+	if (absval->types == NULL)
+		return;
+
+	// The receiver must be an object, whatever its class.
+	int num_classes = Type_info::get_object_types (absval->types)->size ();
+	if (num_classes == 0
+		|| num_classes != (int) absval->types->size ()
+		|| num_classes > MAX_RECEIVER_CLASSES)
+		return;
+
+	in->attrs->set ("phc.optimize.receiver_classes", new ::Integer (num_classes));
 }
 
 void
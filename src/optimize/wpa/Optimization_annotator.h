@@ -25,6 +25,8 @@ public:
 	bool assign_var_is_ref;
 
 	void visit_entry_block (Entry_block* bb);
+	void visit_statement_block (Statement_block* bb);
+	void visit_branch_block (Branch_block* bb);
 
 	DECLARE_STATEMENT_CFG_VISITORS
 	DECLARE_EXPR_CFG_VISITORS
@@ -0,0 +1,464 @@
+/*
+ * phc -- the open source PHP compiler
+ * See doc/license/README.license for licensing information
+ *
+ * A database of function summaries, which persists between compilations.
+ *
+ * The file format is line-based:
+ *
+ *		HASH NAME TYPE,TYPE,... [PARAM-TYPE,PARAM-TYPE,... ...]
+ *
+ * with the return types first, followed by the types of each parameter.
+ *
+ * Lines starting with '#' are ignored.
+ */
+
+#include <fstream>
+#include <sstream>
+
+#include "MIR.h"
+#include "MIR_visitor.h"
+#include "process_mir/MIR_unparser.h"
+#include "optimize/Oracle.h"
+#include "lib/error.h"
+
+#include "Summary_db.h"
+
+using namespace MIR;
+using namespace boost;
+using namespace std;
+
+Function_summary::Function_summary (String* hash, String* name, Types* return_types, List<Types*>* param_types)
+: hash (hash)
+, name (name)
+, return_types (return_types)
+, param_types (param_types)
+{
+}
+
+bool
+Function_summary::applies_to (List<const Types*>* arg_types)
+{
+	if (arg_types->size () != param_types->size ())
+		return false;
+
+	List<Types*>::const_iterator i = param_types->begin ();
+	foreach (const Types* types, *arg_types)
+	{
+		if (types == NULL)
+			return false;
+
+		foreach (string type, *types)
+			if (!(*i)->has (type))
+				return false;
+
+		i++;
+	}
+
+	return true;
+}
+
+static Types*
+read_types (string types)
+{
+	Types* result = new Types;
+	stringstream ts (types);
+	string type;
+	while (getline (ts, type, ','))
+		result->insert (type);
+
+	return result;
+}
+
+static void
+write_types (ostream& os, const Types* types)
+{
+	bool first = true;
+	foreach (string type, *types)
+	{
+		if (!first)
+			os << ",";
+
+		os << type;
+		first = false;
+	}
+}
+
+/*
+ * Summarized_method_info
+ */
+
+Summarized_method_info::Summarized_method_info (User_method_info* user_info, Function_summary* summary)
+: Summary_method_info (user_info->name)
+, user_info (user_info)
+, summary (summary)
+{
+}
+
+bool
+Summarized_method_info::has_implementation ()
+{
+	return false;
+}
+
+bool
+Summarized_method_info::return_by_ref ()
+{
+	// Functions which return by reference are not summarized.
+	return false;
+}
+
+bool
+Summarized_method_info::param_by_ref (int param_index)
+{
+	// Functions with by-ref parameters are not summarized.
+	return false;
+}
+
+MIR::VARIABLE_NAME*
+Summarized_method_info::param_name (int param_index)
+{
+	// The body is not analysed, so use the same names as builtins.
+	return unnamed_param (param_index);
+}
+
+MIR::Static_value*
+Summarized_method_info::default_param (int param_index)
+{
+	return NULL;
+}
+
+int
+Summarized_method_info::formal_param_count ()
+{
+	return user_info->formal_param_count ();
+}
+
+bool
+Summarized_method_info::get_side_effecting ()
+{
+	return false;
+}
+
+Class_info*
+Summarized_method_info::get_class_info ()
+{
+	// Methods are not summarized.
+	return NULL;
+}
+
+/*
+ * Summary_db
+ */
+
+Summary_db::Summary_db ()
+{
+}
+
+void
+Summary_db::load (String* filename)
+{
+	ifstream file (filename->c_str ());
+
+	// A missing database is fine, we'll create it when we save.
+	if (!file.is_open ())
+		return;
+
+	string line;
+	while (getline (file, line))
+	{
+		if (line.size () == 0 || line[0] == '#')
+			continue;
+
+		stringstream ss (line);
+		string hash, name, types;
+		ss >> hash >> name >> types;
+
+		if (types == "")
+		{
+			phc_warning ("Malformed line in summary database: '%s'", filename, 0, 0, line.c_str ());
+			continue;
+		}
+
+		List<Types*>* param_types = new List<Types*>;
+		string param;
+		while (ss >> param)
+			param_types->push_back (read_types (param));
+
+		summaries[hash] = new Function_summary (s(hash), s(name), read_types (types), param_types);
+	}
+}
+
+void
+Summary_db::save (String* filename)
+{
+	ofstream file (filename->c_str ());
+
+	if (!file.is_open ())
+	{
+		phc_warning ("Could not write the summary database", filename, 0, 0);
+		return;
+	}
+
+	file << "# phc function summaries: HASH NAME RETURN-TYPES PARAM-TYPES...\n";
+
+	string hash;
+	Function_summary* summary;
+	foreach (tie (hash, summary), summaries)
+	{
+		file << hash << " " << *summary->name << " ";
+		write_types (file, summary->return_types);
+
+		foreach (Types* types, *summary->param_types)
+		{
+			file << " ";
+			write_types (file, types);
+		}
+
+		file << "\n";
+	}
+}
+
+/*
+ * The user functions which METHOD calls by name, in the order of the calls.
+ */
+static List<User_method_info*>*
+get_user_callees (Method* method)
+{
+	List<User_method_info*>* result = new List<User_method_info*>;
+
+	foreach (Statement* s, *method->statements)
+	{
+		Expr* expr = NULL;
+		if (Assign_var* av = dynamic_cast<Assign_var*> (s))
+			expr = av->rhs;
+		else if (Eval_expr* ee = dynamic_cast<Eval_expr*> (s))
+			expr = ee->expr;
+
+		Method_invocation* mi = dynamic_cast<Method_invocation*> (expr);
+		if (mi == NULL || mi->target || !isa<METHOD_NAME> (mi->method_name))
+			continue;
+
+		Method_info* callee = Oracle::get_method_info (dyc<METHOD_NAME> (mi->method_name)->value);
+		if (User_method_info* user_callee = dynamic_cast<User_method_info*> (callee))
+			result->push_back (user_callee);
+	}
+
+	return result;
+}
+
+/*
+ * FNV-1a over the unparsed function, followed by the hashes of the user
+ * functions it calls. The unparsed form includes the signature, so renaming
+ * a function or changing a default value changes the hash. Recursive calls
+ * only contribute the callee's name (such functions are never summarized).
+ */
+String*
+Summary_db::get_hash (User_method_info* info)
+{
+	if (hashes.has (info))
+		return hashes[info];
+
+	hashing.insert (info);
+
+	stringstream ss;
+	MIR_unparser (ss, true).unparse (info->get_method ());
+	foreach (User_method_info* callee, *get_user_callees (info->get_method ()))
+	{
+		if (hashing.has (callee))
+			ss << "\n" << *callee->name;
+		else
+			ss << "\n" << *get_hash (callee);
+	}
+	string body = ss.str ();
+
+	hashing.erase (info);
+
+	unsigned long long hash = 14695981039346656037ULL;
+	foreach (char c, body)
+	{
+		hash ^= (unsigned char)(c);
+		hash *= 1099511628211ULL;
+	}
+
+	stringstream result;
+	result << hex << hash;
+
+	hashes[info] = s(result.str ());
+	return hashes[info];
+}
+
+Summarized_method_info*
+Summary_db::get_summarized_method_info (User_method_info* info, List<const Types*>* arg_types)
+{
+	// Use the same Summarized_method_info every time, or the WPA will not
+	// converge (it uses the fake CFG's blocks as keys).
+	if (summarized.has (info))
+	{
+		if (!summarized[info]->summary->applies_to (arg_types))
+			return NULL;
+
+		return summarized[info];
+	}
+
+	String* hash = get_hash (info);
+	if (!summaries.has (*hash))
+		return NULL;
+
+	Function_summary* summary = summaries[*hash];
+	if (*summary->name != *info->name || !summary->applies_to (arg_types))
+		return NULL;
+
+	summarized[info] = new Summarized_method_info (info, summary);
+	pure_functions.insert (*info->name);
+	return summarized[info];
+}
+
+bool
+Summary_db::add_summary (User_method_info* info, const Types* return_types, List<const Types*>* param_types)
+{
+	if (return_types == NULL || return_types->size () == 0)
+		return false;
+
+	List<Types*>* saved_params = new List<Types*>;
+	foreach (const Types* types, *param_types)
+	{
+		if (types == NULL || types->size () == 0)
+			return false;
+
+		saved_params->push_back (types->clone ());
+	}
+
+	// Only scalars can be modelled from the types alone.
+	if (Type_info::get_scalar_types (return_types)->size () != return_types->size ())
+		return false;
+
+	if (!is_pure (info))
+		return false;
+
+	String* hash = get_hash (info);
+	summaries[*hash] = new Function_summary (hash, info->name, return_types->clone (), saved_params);
+	pure_functions.insert (*info->name);
+	return true;
+}
+
+/*
+ * Find reads of $GLOBALS.
+ */
+class Globals_finder : public Visitor, virtual public GC_obj
+{
+public:
+	bool found;
+
+	Globals_finder () : found (false) {}
+
+	void pre_variable_name (VARIABLE_NAME* in)
+	{
+		if (*in->value == "GLOBALS")
+			found = true;
+	}
+};
+
+/*
+ * Conservatively check that INFO has no effect on its caller except its
+ * return value: it may not write to anything that outlives it, call anything
+ * impure, or produce output. Its return value may only depend on its
+ * parameters, so it may not read globals or constants, which another
+ * compilation may define differently.
+ */
+bool
+Summary_db::is_pure (User_method_info* info)
+{
+	if (info->get_class_info () != NULL || info->return_by_ref ())
+		return false;
+
+	Set<string> params;
+	for (int i = 0; i < info->formal_param_count (); i++)
+	{
+		if (info->param_by_ref (i) || isa<Constant> (info->default_param (i)))
+			return false;
+
+		params.insert (*info->param_name (i)->value);
+	}
+
+	foreach (Statement* s, *info->get_method ()->statements)
+	{
+		Globals_finder globals;
+		s->visit (&globals);
+		if (globals.found)
+			return false;
+
+		if (isa<Label> (s) || isa<Goto> (s) || isa<Branch> (s) || isa<Return> (s)
+			|| isa<Pre_op> (s))
+			continue;
+
+		// Arrays passed as parameters are copied, but objects are not, and
+		// writing to an ArrayAccess object calls a method.
+		if (isa<Assign_array> (s) || isa<Assign_next> (s) || isa<Foreach_reset> (s)
+			|| isa<Foreach_next> (s) || isa<Foreach_end> (s))
+		{
+			VARIABLE_NAME* array = NULL;
+			if (Assign_array* aa = dynamic_cast<Assign_array*> (s))
+				array = aa->lhs;
+			else if (Assign_next* an = dynamic_cast<Assign_next*> (s))
+				array = an->lhs;
+			else if (Foreach_reset* fr = dynamic_cast<Foreach_reset*> (s))
+				array = fr->array;
+			else if (Foreach_next* fn = dynamic_cast<Foreach_next*> (s))
+				array = fn->array;
+			else
+				array = dyc<Foreach_end> (s)->array;
+
+			if (params.has (*array->value))
+				return false;
+
+			if ((isa<Assign_array> (s) && dyc<Assign_array> (s)->is_ref)
+				|| (isa<Assign_next> (s) && dyc<Assign_next> (s)->is_ref))
+				return false;
+
+			continue;
+		}
+
+		Expr* expr = NULL;
+		if (Assign_var* av = dynamic_cast<Assign_var*> (s))
+		{
+			if (av->is_ref)
+				return false;
+
+			expr = av->rhs;
+		}
+		else if (Eval_expr* ee = dynamic_cast<Eval_expr*> (s))
+			expr = ee->expr;
+		else
+			return false; // Global, Static_declaration, Assign_field, Throw, etc.
+
+		if (isa<New> (expr) || isa<Field_access> (expr) || isa<Array_next> (expr)
+			|| isa<FOREIGN> (expr) || isa<Constant> (expr))
+			return false;
+
+		if (Method_invocation* mi = dynamic_cast<Method_invocation*> (expr))
+		{
+			if (mi->target || !isa<METHOD_NAME> (mi->method_name))
+				return false;
+
+			METHOD_NAME* name = dyc<METHOD_NAME> (mi->method_name);
+			Method_info* callee = Oracle::get_method_info (name->value);
+			if (callee == NULL)
+				return false;
+
+			if (isa<User_method_info> (callee))
+			{
+				if (!pure_functions.has (*callee->name))
+					return false;
+			}
+			else if (!Oracle::is_pure_function (name))
+				return false;
+
+			foreach (Actual_parameter* ap, *mi->actual_parameters)
+				if (ap->is_ref)
+					return false;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,99 @@
+/*
+ * phc -- the open source PHP compiler
+ * See doc/license/README.license for licensing information
+ *
+ * A database of function summaries, which persists between compilations.
+ * Summaries are keyed by a hash of the function's body and the bodies of the
+ * functions it calls, so a function is only summarized from the database if
+ * none of that code has changed. The return types only hold for the
+ * parameter types the function was analysed with, so a call only uses the
+ * summary if its arguments have no other types.
+ *
+ * We only keep summaries which are complete: functions which have no effect
+ * on their caller other than returning a scalar, and which read nothing but
+ * their parameters. Calls to such functions can be modelled from the summary
+ * alone, without analysing the function body.
+ */
+
+#ifndef PHC_SUMMARY_DB
+#define PHC_SUMMARY_DB
+
+#include "lib/Map.h"
+#include "lib/Set.h"
+#include "lib/String.h"
+#include "optimize/Abstract_value.h"
+#include "optimize/Method_info.h"
+
+class Function_summary : virtual public GC_obj
+{
+public:
+	String* hash;
+	String* name;
+	Types* return_types;
+	List<Types*>* param_types;
+
+	Function_summary (String* hash, String* name, Types* return_types, List<Types*>* param_types);
+
+	// Whether the summary holds for a call with arguments of ARG_TYPES. A NULL
+	// entry means the argument's types are unknown.
+	bool applies_to (List<const Types*>* arg_types);
+};
+
+/*
+ * Stands in for a User_method_info whose summary was loaded from the
+ * database. The WPA analyses it like a builtin.
+ */
+class Summarized_method_info : public Summary_method_info
+{
+public:
+	User_method_info* user_info;
+	Function_summary* summary;
+
+	Summarized_method_info (User_method_info* user_info, Function_summary* summary);
+
+	bool has_implementation ();
+
+	bool return_by_ref ();
+	MIR::VARIABLE_NAME* param_name (int param_index);
+	bool param_by_ref (int param_index);
+	MIR::Static_value* default_param (int param_index);
+	int formal_param_count ();
+
+	bool get_side_effecting ();
+	virtual Class_info* get_class_info ();
+};
+
+class Summary_db : virtual public GC_obj
+{
+	// Indexed by hash
+	Map<string, Function_summary*> summaries;
+	Map<Method_info*, String*> hashes;
+	Map<Method_info*, Summarized_method_info*> summarized;
+
+	// Functions whose hash is being computed, to stop at recursive calls.
+	Set<Method_info*> hashing;
+
+	// Functions which are summarized in this compilation.
+	Set<string> pure_functions;
+
+public:
+	Summary_db ();
+
+	void load (String* filename);
+	void save (String* filename);
+
+	// Returns NULL if INFO is not in the database, or its summary does not
+	// hold for arguments of ARG_TYPES.
+	Summarized_method_info* get_summarized_method_info (User_method_info* info, List<const Types*>* arg_types);
+
+	// Record the summary of INFO, if it is eligible (see above). Callees must
+	// be added before their callers.
+	bool add_summary (User_method_info* info, const Types* return_types, List<const Types*>* param_types);
+
+	String* get_hash (User_method_info* info);
+
+private:
+	bool is_pure (User_method_info* info);
+};
+
+#endif // PHC_SUMMARY_DB
@@ -0,0 +1,339 @@
+/*
+ * phc -- the open source PHP compiler
+ * See doc/license/README.license for licensing information
+ *
+ * A fast, flow-insensitive pre-analysis, in the style of Steensgaard's
+ * unification-based alias analysis.
+ */
+
+#include "MIR.h"
+#include "embed/embed.h"
+#include "optimize/Basic_block.h"
+#include "optimize/CFG.h"
+#include "optimize/Class_info.h"
+#include "optimize/Oracle.h"
+
+#include "Context.h"
+#include "Points_to.h"
+#include "Unification_analysis.h"
+
+using namespace MIR;
+using namespace boost;
+using namespace std;
+
+/*
+ * A variable bound by 'global' in any method may be a reference to
+ * __MAIN__'s variable of the same name.
+ */
+class Global_collector : public MIR::Visitor, virtual public GC_obj
+{
+public:
+	Set<string> names;
+	bool uses_globals_array;
+
+	Global_collector ()
+	: uses_globals_array (false)
+	{
+	}
+
+	void pre_global (Global* in)
+	{
+		if (VARIABLE_NAME* var = dynamic_cast<VARIABLE_NAME*> (in->variable_name))
+			names.insert (*var->value);
+		else
+			uses_globals_array = true; // global $$x can bind anything
+	}
+
+	void pre_variable_name (VARIABLE_NAME* in)
+	{
+		if (*in->value == "GLOBALS")
+			uses_globals_array = true;
+	}
+};
+
+Unification_analysis::Unification_analysis ()
+: uses_globals_array (false)
+, all_escape (false)
+, return_by_ref (false)
+{
+}
+
+void
+Unification_analysis::initialize (Method_info_list* methods)
+{
+	Global_collector* collector = new Global_collector;
+
+	foreach (Method_info* info, *methods)
+		if (User_method_info* user_info = dynamic_cast<User_method_info*> (info))
+			user_info->get_method ()->visit (collector);
+
+	global_names = collector->names;
+	uses_globals_array = collector->uses_globals_array;
+}
+
+bool
+Unification_analysis::is_unaliased (Context* cx, const Index_node* index)
+{
+	CFG* cfg = cx->get_bb ()->cfg;
+	if (cfg == NULL || index->storage != cx->symtable_name ())
+		return false;
+
+	if (!unaliased.has (cfg))
+		unaliased[cfg] = analyse (cfg);
+
+	return unaliased[cfg]->has (index->index);
+}
+
+Set<string>*
+Unification_analysis::analyse (CFG* cfg)
+{
+	Set<string>* result = new Set<string>;
+
+	Method_info* info = cfg->method_info;
+	if (info == NULL || !info->has_implementation ())
+		return result;
+
+	parents.clear ();
+	seen.clear ();
+	escaping.clear ();
+	all_escape = false;
+	return_by_ref = info->return_by_ref ();
+
+	for (int i = 0; i < info->formal_param_count (); i++)
+		if (info->param_by_ref (i))
+			escape (info->param_name (i));
+
+	foreach (Basic_block* bb, *cfg->get_all_bbs ())
+	{
+		if (Statement_block* sb = dynamic_cast<Statement_block*> (bb))
+			sb->statement->visit (this);
+		else if (Branch_block* branch = dynamic_cast<Branch_block*> (bb))
+			branch->branch->visit (this);
+	}
+
+	if (all_escape)
+		return result;
+
+	// Superglobals are bound by the WPA, not by the method.
+	foreach (VARIABLE_NAME* sg, *PHP::get_superglobals ())
+		escaping.insert (*sg->value);
+
+	if (*info->name == "__MAIN__")
+	{
+		if (uses_globals_array)
+			return result;
+
+		escaping.insert (global_names.begin (), global_names.end ());
+	}
+
+	Map<string, int> sizes;
+	foreach (string var, seen)
+		sizes[find (var)]++;
+
+	foreach (string var, seen)
+		if (sizes[find (var)] == 1 && !escaping.has (var))
+			result->insert (var);
+
+	return result;
+}
+
+/*
+ * Union-find, with path compression.
+ */
+string
+Unification_analysis::find (string var)
+{
+	if (!parents.has (var))
+		return var;
+
+	string root = find (parents[var]);
+	parents[var] = root;
+	return root;
+}
+
+void
+Unification_analysis::unify (string var1, string var2)
+{
+	string root1 = find (var1);
+	string root2 = find (var2);
+
+	if (root1 != root2)
+		parents[root1] = root2;
+}
+
+void
+Unification_analysis::use (Node* node)
+{
+	if (VARIABLE_NAME* var = dynamic_cast<VARIABLE_NAME*> (node))
+		seen.insert (*var->value);
+}
+
+void
+Unification_analysis::escape (Node* node)
+{
+	if (VARIABLE_NAME* var = dynamic_cast<VARIABLE_NAME*> (node))
+		escaping.insert (*var->value);
+}
+
+/*
+ * Visitors
+ */
+
+void
+Unification_analysis::pre_variable_name (VARIABLE_NAME* in)
+{
+	use (in);
+}
+
+// Variable-variables and dynamic calls may touch any variable, so we give
+// up on the whole method.
+void
+Unification_analysis::pre_variable_variable (Variable_variable* in)
+{
+	all_escape = true;
+}
+
+void
+Unification_analysis::pre_variable_method (Variable_method* in)
+{
+	all_escape = true;
+}
+
+void
+Unification_analysis::pre_foreign (FOREIGN* in)
+{
+	all_escape = true;
+}
+
+void
+Unification_analysis::pre_global (Global* in)
+{
+	escape (in->variable_name);
+}
+
+void
+Unification_analysis::pre_static_declaration (Static_declaration* in)
+{
+	escape (in->var->variable_name);
+}
+
+void
+Unification_analysis::pre_assign_var (Assign_var* in)
+{
+	if (!in->is_ref)
+		return;
+
+	// $x =& $y makes X and Y aliases. Anything else ($x =& $a[$i], $x =&
+	// f()) makes X alias something we dont track.
+	if (VARIABLE_NAME* rhs = dynamic_cast<VARIABLE_NAME*> (in->rhs))
+	{
+		use (rhs);
+		unify (*in->lhs->value, *rhs->value);
+	}
+	else
+		escape (in->lhs);
+}
+
+void
+Unification_analysis::pre_assign_var_var (Assign_var_var* in)
+{
+	if (in->is_ref)
+		escape (in->rhs);
+}
+
+void
+Unification_analysis::pre_assign_array (Assign_array* in)
+{
+	if (in->is_ref)
+		escape (in->rhs);
+}
+
+void
+Unification_analysis::pre_assign_next (Assign_next* in)
+{
+	if (in->is_ref)
+		escape (in->rhs);
+}
+
+void
+Unification_analysis::pre_assign_field (Assign_field* in)
+{
+	if (in->is_ref)
+		escape (in->rhs);
+}
+
+void
+Unification_analysis::pre_method_invocation (Method_invocation* in)
+{
+	METHOD_NAME* name = dynamic_cast<METHOD_NAME*> (in->method_name);
+	if (name == NULL)
+		return; // Variable_method
+
+	// These can create references in the current scope.
+	if (*name->value == "eval"
+		|| *name->value == "extract"
+		|| *name->value == "include"
+		|| *name->value == "include_once"
+		|| *name->value == "require"
+		|| *name->value == "require_once")
+	{
+		all_escape = true;
+		return;
+	}
+
+	// We dont know the receiver's class, so any parameter may be by
+	// reference.
+	Method_info* info = NULL;
+	if (in->target == NULL)
+		info = Oracle::get_method_info (name->value);
+
+	escape_by_ref_params (info, in->actual_parameters);
+}
+
+// The constructor's parameters may be by reference, just like a method's.
+void
+Unification_analysis::pre_new (New* in)
+{
+	Method_info* constructor = NULL;
+
+	if (CLASS_NAME* class_name = dynamic_cast<CLASS_NAME*> (in->class_name))
+	{
+		Class_info* class_info = Oracle::get_class_info (class_name->value);
+		if (class_info)
+		{
+			constructor = class_info->get_method_info (s("__construct"));
+
+			// Look for the old-style constructor
+			if (constructor == NULL)
+				constructor = class_info->get_method_info (class_name->value);
+
+			// The parameters are not bound to anything.
+			if (constructor == NULL)
+				return;
+		}
+	}
+
+	escape_by_ref_params (constructor, in->actual_parameters);
+}
+
+// Escape the actual parameters which may be bound by reference. If INFO is
+// NULL, any of them may be.
+void
+Unification_analysis::escape_by_ref_params (Method_info* info, Actual_parameter_list* params)
+{
+	int i = 0;
+	foreach (Actual_parameter* ap, *params)
+	{
+		if (info == NULL || ap->is_ref || info->param_by_ref (i))
+			escape (ap->rvalue);
+
+		i++;
+	}
+}
+
+void
+Unification_analysis::pre_return (Return* in)
+{
+	if (return_by_ref)
+		escape (in->rvalue);
+}
@@ -0,0 +1,85 @@
+/*
+ * phc -- the open source PHP compiler
+ * See doc/license/README.license for licensing information
+ *
+ * A fast, flow-insensitive pre-analysis, in the style of Steensgaard's
+ * unification-based alias analysis. Before each iteration of the
+ * whole-program analysis, we find the local variables which can never be
+ * part of a reference. These variables can only ever refer to themselves,
+ * so Whole_program does not need to ask the points-to graph for their
+ * references.
+ *
+ * Each method is analysed in time linear in its size, the first time one of
+ * its variables is queried. Variables which may be references are unified;
+ * the remaining singleton variables are unaliased unless they escape (by
+ * being global, static, passed by reference, etc).
+ */
+
+#ifndef PHC_UNIFICATION_ANALYSIS
+#define PHC_UNIFICATION_ANALYSIS
+
+#include "MIR_visitor.h"
+#include "lib/Map.h"
+#include "lib/Set.h"
+#include "optimize/Method_info.h"
+
+class CFG;
+class Context;
+class Index_node;
+
+class Unification_analysis : public MIR::Visitor, virtual public GC_obj
+{
+	// Names bound by a 'global' statement in any method.
+	Set<string> global_names;
+
+	// Is $GLOBALS used anywhere?
+	bool uses_globals_array;
+
+	// Results: the unaliased variables of each method.
+	Map<CFG*, Set<string>*> unaliased;
+
+	// State while analysing a single method.
+	Map<string, string> parents;
+	Set<string> seen;
+	Set<string> escaping;
+	bool all_escape;
+	bool return_by_ref;
+
+public:
+	Unification_analysis ();
+
+	// Find the variables which are global in any of METHODS.
+	void initialize (Method_info_list* methods);
+
+	// Is INDEX a local variable of CX's method, which is never a reference?
+	bool is_unaliased (Context* cx, const Index_node* index);
+
+private:
+	Set<string>* analyse (CFG* cfg);
+
+	// Union-find
+	string find (string var);
+	void unify (string var1, string var2);
+
+	void use (MIR::Node* node);
+	void escape (MIR::Node* node);
+	void escape_by_ref_params (Method_info* info, MIR::Actual_parameter_list* params);
+
+public:
+	void pre_variable_name (MIR::VARIABLE_NAME* in);
+	void pre_variable_variable (MIR::Variable_variable* in);
+	void pre_variable_method (MIR::Variable_method* in);
+	void pre_foreign (MIR::FOREIGN* in);
+	void pre_global (MIR::Global* in);
+	void pre_static_declaration (MIR::Static_declaration* in);
+	void pre_assign_var (MIR::Assign_var* in);
+	void pre_assign_var_var (MIR::Assign_var_var* in);
+	void pre_assign_array (MIR::Assign_array* in);
+	void pre_assign_next (MIR::Assign_next* in);
+	void pre_assign_field (MIR::Assign_field* in);
+	void pre_method_invocation (MIR::Method_invocation* in);
+	void pre_new (MIR::New* in);
+	void pre_return (MIR::Return* in);
+};
+
+#endif // PHC_UNIFICATION_ANALYSIS
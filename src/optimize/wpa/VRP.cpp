@@ -13,9 +13,556 @@
  *
  */
 
+#include <climits>
+
+#include "optimize/Basic_block.h"
+#include "process_ir/IR.h"
+
+#include "Points_to.h"
+#include "Unification_analysis.h"
+#include "Value_analysis.h"
+#include "Whole_program.h"
 #include "VRP.h"
 
+using namespace std;
+using namespace boost;
+using namespace MIR;
+
 VRP::VRP (Whole_program* wp)
-: WPA (wp)
+: WPA_lattice<const Alias_name*, const Range_cell> (wp)
+{
+}
+
+
+const Alias_name*
+VRP::context_merge_key (const Alias_name* name) const
+{
+	return name->convert_context_name ();
+}
+
+
+/*
+ * WPA interface
+ */
+
+void
+VRP::set_scalar (Context* cx, const Value_node* storage, const Abstract_value* val)
+{
+	Lattice_type& lat = working[cx];
+
+	const Range_cell* range = get_range (val);
+	if (range == NULL)
+		range = Range_cell::BOTTOM;
+
+	lat[storage] = lat[storage]->meet (range);
+}
+
+void
+VRP::pull_possible_null (Context* cx, const Index_node* index)
+{
+	Lattice_type& lat = ins[cx];
+
+	// NULL isnt an int, but we must not lose the values from other paths.
+	lat[index] = lat[index]->meet (Range_cell::BOTTOM);
+
+	const Value_node* scalar_name = SCLVAL (index);
+	lat[scalar_name] = lat[scalar_name]->meet (Range_cell::BOTTOM);
+}
+
+const Range_cell*
+VRP::get_value (Context* cx, Result_state state, const Alias_name* name) const
+{
+	return lattices[state][cx][name];
+}
+
+void
+VRP::kill_value (Context* cx, const Index_node* lhs, bool also_kill_refs)
+{
+	Lattice_type& lat = working[cx];
+	lat.erase (lhs);
+	lat.erase (SCLVAL (lhs));
+}
+
+void
+VRP::remove_fake_node (Context* cx, const Index_node* fake)
+{
+	this->kill_value (cx, fake, false /* dont care */);
+}
+
+void
+VRP::assign_value (Context* cx, const Index_node* lhs, const Storage_node* storage)
+{
+	Lattice_type& lat = working[cx];
+
+	lat[lhs] = lat[lhs]->meet (lat[storage]);
+}
+
+
+/*
+ * Branches
+ */
+
+void
+VRP::pull_first_pred (Context* cx, Context* pred)
+{
+	WPA_lattice<const Alias_name*, const Range_cell>::pull_first_pred (cx, pred);
+	refine_for_edge (cx, pred, ins[cx]);
+}
+
+void
+VRP::pull_pred (Context* cx, Context* pred)
+{
+	Lattice_type edge = outs[pred];
+	refine_for_edge (cx, pred, edge);
+	ins[cx].merge (&edge);
+}
+
+// The comparison which holds when OP does not.
+static string
+negate_comparison (string op)
+{
+	if (op == "<") return ">=";
+	if (op == "<=") return ">";
+	if (op == ">") return "<=";
+	if (op == ">=") return "<";
+	if (op == "!=" || op == "!==") return "==";
+	return ""; // == is no use to us when false
+}
+
+static long
+inc_bound (long bound)
+{
+	return (bound == LONG_MAX) ? bound : bound + 1;
+}
+
+static long
+dec_bound (long bound)
+{
+	return (bound == LONG_MIN) ? bound : bound - 1;
+}
+
+/*
+ * If PRED branches on a comparison of integers, the comparison holds (or
+ * doesnt hold) on the edge to CX. For example, in
+ *
+ *		L1:	$TLE0 = $i < 10;
+ *				if ($TLE0) goto L2; else goto L3;
+ *
+ *	$i is in [LONG_MIN, 9] at L2, and [10, LONG_MAX] at L3.
+ */
+void
+VRP::refine_for_edge (Context* cx, Context* pred, Lattice_type& lat)
+{
+	Branch_block* branch = dynamic_cast<Branch_block*> (pred->get_bb ());
+	if (branch == NULL)
+		return;
+
+	bool is_true = (cx->get_bb () == branch->get_true_successor ());
+	bool is_false = (cx->get_bb () == branch->get_false_successor ());
+	if (is_true == is_false)
+		return;
+
+	// The condition must be computed immediately before the branch, so that
+	// the operands still hold the compared values.
+	BB_list* preds = branch->get_predecessors ();
+	if (preds->size () != 1)
+		return;
+
+	Statement_block* sb = dynamic_cast<Statement_block*> (preds->front ());
+	if (sb == NULL)
+		return;
+
+	Assign_var* assign = dynamic_cast<Assign_var*> (sb->statement);
+	if (assign == NULL || assign->is_ref
+		|| *assign->lhs->value != *branch->branch->variable_name->value)
+		return;
+
+	Bin_op* bin_op = dynamic_cast<Bin_op*> (assign->rhs);
+	if (bin_op == NULL)
+		return;
+
+	string op = *bin_op->op->value;
+	if (op == "===") op = "==";
+	if (op == "!==") op = "!=";
+	if (is_false)
+		op = negate_comparison (op);
+
+	const Range_cell* left = get_operand_range (pred, bin_op->left);
+	const Range_cell* right = get_operand_range (pred, bin_op->right);
+	if (left == NULL || right == NULL)
+		return;
+
+	if (op == "<")
+	{
+		refine_operand (pred, lat, bin_op->left, left->intersect (LONG_MIN, dec_bound (right->max)));
+		refine_operand (pred, lat, bin_op->right, right->intersect (inc_bound (left->min), LONG_MAX));
+	}
+	else if (op == "<=")
+	{
+		refine_operand (pred, lat, bin_op->left, left->intersect (LONG_MIN, right->max));
+		refine_operand (pred, lat, bin_op->right, right->intersect (left->min, LONG_MAX));
+	}
+	else if (op == ">")
+	{
+		refine_operand (pred, lat, bin_op->left, left->intersect (inc_bound (right->min), LONG_MAX));
+		refine_operand (pred, lat, bin_op->right, right->intersect (LONG_MIN, dec_bound (left->max)));
+	}
+	else if (op == ">=")
+	{
+		refine_operand (pred, lat, bin_op->left, left->intersect (right->min, LONG_MAX));
+		refine_operand (pred, lat, bin_op->right, right->intersect (LONG_MIN, left->max));
+	}
+	else if (op == "==")
+	{
+		refine_operand (pred, lat, bin_op->left, left->intersect (right->min, right->max));
+		refine_operand (pred, lat, bin_op->right, right->intersect (left->min, left->max));
+	}
+}
+
+// The range of OPERAND at the end of CX, if it is an int. Otherwise NULL,
+// since comparisons of other types dont tell us anything.
+const Range_cell*
+VRP::get_operand_range (Context* cx, Rvalue* operand)
+{
+	if (isa<Literal> (operand))
+		return get_range (new Abstract_value (dyc<Literal> (operand)));
+
+	Index_node* index = VN (cx->symtable_name (), dyc<VARIABLE_NAME> (operand));
+	const Types* types = wp->values->get_value (cx, R_OUT, index)->value->types;
+	if (types == NULL || types->size () != 1 || !types->has ("int"))
+		return NULL;
+
+	const Range_cell* range = outs[cx][index];
+	if (range == Range_cell::TOP)
+		return Range_cell::BOTTOM;
+
+	return range;
+}
+
+void
+VRP::refine_operand (Context* cx, Lattice_type& lat, Rvalue* operand, const Range_cell* range)
+{
+	if (isa<Literal> (operand))
+		return;
+
+	// If the variable may be a reference, we dont know which value to narrow.
+	Index_node* index = VN (cx->symtable_name (), dyc<VARIABLE_NAME> (operand));
+	if (!wp->unification->is_unaliased (cx, index))
+		return;
+
+	lat[index] = range;
+	lat[SCLVAL (index)] = range;
+}
+
+
+/*
+ * Arithmetic
+ */
+
+static bool
+add_overflows (long a, long b)
+{
+	return (b > 0 && a > LONG_MAX - b) || (b < 0 && a < LONG_MIN - b);
+}
+
+static bool
+sub_overflows (long a, long b)
+{
+	return (b < 0 && a > LONG_MAX + b) || (b > 0 && a < LONG_MIN + b);
+}
+
+static bool
+mul_overflows (long a, long b)
+{
+	if (a == 0 || b == 0)
+		return false;
+
+	if (a > 0)
+		return (b > 0) ? a > LONG_MAX / b : b < LONG_MIN / a;
+	else
+		return (b > 0) ? a < LONG_MIN / b : a < LONG_MAX / b;
+}
+
+// Lower bounds go to LONG_MIN when unbounded or on overflow, and upper
+// bounds to LONG_MAX.
+static long
+add_lower (long a, long b)
+{
+	if (a == LONG_MIN || b == LONG_MIN || add_overflows (a, b))
+		return LONG_MIN;
+
+	return a + b;
+}
+
+static long
+add_upper (long a, long b)
+{
+	if (a == LONG_MAX || b == LONG_MAX || add_overflows (a, b))
+		return LONG_MAX;
+
+	return a + b;
+}
+
+static long
+sub_lower (long a, long b)
+{
+	if (a == LONG_MIN || b == LONG_MAX || sub_overflows (a, b))
+		return LONG_MIN;
+
+	return a - b;
+}
+
+static long
+sub_upper (long a, long b)
+{
+	if (a == LONG_MAX || b == LONG_MIN || sub_overflows (a, b))
+		return LONG_MAX;
+
+	return a - b;
+}
+
+const Range_cell*
+VRP::get_range (const Abstract_value* val)
+{
+	if (val->lit)
+	{
+		if (const INT* i = dynamic_cast<const INT*> (val->lit))
+			return new Range_cell (i->value, i->value);
+
+		return NULL;
+	}
+
+	if (val->range == NULL || val->range == Range_cell::TOP)
+		return NULL;
+
+	return val->range;
+}
+
+// The range of VAL if its only an int, else NULL.
+static const Range_cell*
+get_int_range (const Abstract_value* val)
+{
+	if (val->types == NULL || val->types->size () != 1 || !val->types->has ("int"))
+		return NULL;
+
+	const Range_cell* range = VRP::get_range (val);
+	if (range == NULL)
+		return Range_cell::BOTTOM;
+
+	return range;
+}
+
+const Range_cell*
+VRP::get_bin_op_range (const Abstract_value* left, const Abstract_value* right, string op)
+{
+	const Range_cell* l = get_int_range (left);
+	const Range_cell* r = get_int_range (right);
+	if (l == NULL || r == NULL)
+		return NULL;
+
+	if (op == "+")
+		return new Range_cell (add_lower (l->min, r->min), add_upper (l->max, r->max));
+
+	if (op == "-")
+		return new Range_cell (sub_lower (l->min, r->max), sub_upper (l->max, r->min));
+
+	if (op == "*")
+	{
+		if (!l->is_bounded () || !r->is_bounded ())
+			return Range_cell::BOTTOM;
+
+		long corners[4][2] = {
+			{l->min, r->min}, {l->min, r->max},
+			{l->max, r->min}, {l->max, r->max}};
+
+		long min = LONG_MAX;
+		long max = LONG_MIN;
+		for (int i = 0; i < 4; i++)
+		{
+			if (mul_overflows (corners[i][0], corners[i][1]))
+				return Range_cell::BOTTOM;
+
+			long product = corners[i][0] * corners[i][1];
+			min = std::min (min, product);
+			max = std::max (max, product);
+		}
+		return new Range_cell (min, max);
+	}
+
+	if (op == "%")
+	{
+		// The result is smaller than the divisor, and has the sign of the
+		// dividend.
+		long bound = LONG_MAX;
+		if (r->is_bounded ())
+			bound = std::max (-r->min, r->max) - 1;
+
+		// Only division by zero
+		if (bound < 0)
+			return NULL;
+
+		if (l->min >= 0)
+			return new Range_cell (0, std::min (bound, l->max));
+
+		if (l->max <= 0)
+			return new Range_cell (std::max (-bound, l->min), 0);
+
+		return new Range_cell (-bound, bound);
+	}
+
+	if (op == "&")
+	{
+		// Masking with a non-negative number gives a non-negative number.
+		if (l->min >= 0 && r->min >= 0)
+			return new Range_cell (0, std::min (l->max, r->max));
+
+		if (l->min >= 0)
+			return new Range_cell (0, l->max);
+
+		if (r->min >= 0)
+			return new Range_cell (0, r->max);
+	}
+
+	return NULL;
+}
+
+const Range_cell*
+VRP::get_pre_op_range (const Abstract_value* operand, string op)
+{
+	const Range_cell* range = get_int_range (operand);
+	if (range == NULL)
+		return NULL;
+
+	if (op == "++")
+		return new Range_cell (add_lower (range->min, 1), add_upper (range->max, 1));
+
+	if (op == "--")
+		return new Range_cell (sub_lower (range->min, 1), sub_upper (range->max, 1));
+
+	return NULL;
+}
+
+bool
+VRP::cannot_overflow (const Abstract_value* left, const Abstract_value* right, string op)
+{
+	if (op != "+" && op != "-" && op != "*")
+		return false;
+
+	const Range_cell* range = get_bin_op_range (left, right, op);
+	return range && range->is_bounded ();
+}
+
+bool
+VRP::cannot_overflow (const Abstract_value* operand, string op)
+{
+	const Range_cell* range = get_pre_op_range (operand, op);
+	if (range == NULL)
+		return false;
+
+	if (op == "++")
+		return range->max != LONG_MAX;
+
+	return range->min != LONG_MIN;
+}
+
+
+/*
+ * Lattice_cell interface
+ */
+
+const Range_cell* Range_cell::TOP = new Range_cell (LONG_MAX, LONG_MIN);
+const Range_cell* Range_cell::BOTTOM = new Range_cell (LONG_MIN, LONG_MAX);
+
+Range_cell::Range_cell (long min, long max)
+: min (min)
+, max (max)
+{
+}
+
+void
+Range_cell::dump (std::ostream& os) const
+{
+	if (this == TOP)
+	{
+		os << "(T)";
+		return;
+	}
+
+	os << "[";
+	if (min == LONG_MIN)
+		os << "-inf";
+	else
+		os << min;
+
+	os << ", ";
+	if (max == LONG_MAX)
+		os << "inf";
+	else
+		os << max;
+
+	os << "]";
+}
+
+bool
+Range_cell::equals (const Range_cell* other) const
+{
+	return this->min == other->min && this->max == other->max;
+}
+
+const Range_cell*
+Range_cell::meet (const Range_cell* other) const
+{
+	if (this == TOP)
+		return other;
+
+	if (other == TOP)
+		return this;
+
+	return new Range_cell (
+		std::min (this->min, other->min),
+		std::max (this->max, other->max));
+}
+
+/*
+ * Widening: a bound which is still moving goes straight to its limit, so
+ * that loop counters converge.
+ */
+const Range_cell*
+Range_cell::widen (const Range_cell* other) const
+{
+	const Range_cell* result = this->meet (other);
+
+	if (this == TOP || result->equals (this))
+		return result;
+
+	return new Range_cell (
+		(result->min < this->min) ? LONG_MIN : this->min,
+		(result->max > this->max) ? LONG_MAX : this->max);
+}
+
+const Range_cell*
+Range_cell::intersect (long min, long max) const
+{
+	if (this == TOP)
+		return TOP;
+
+	min = std::max (this->min, min);
+	max = std::min (this->max, max);
+
+	if (min > max)
+		return TOP;
+
+	return new Range_cell (min, max);
+}
+
+bool
+Range_cell::is_bounded () const
+{
+	return this != TOP && min != LONG_MIN && max != LONG_MAX;
+}
+
+const Range_cell*
+Range_cell::get_default ()
 {
+	return TOP;
 }
@@ -12,18 +12,106 @@
  * We need this to help determine when integers overflow into doubles. So we
  * don't need anymore than the max and min values.
  *
+ * Ranges are attached to Abstract_values by Whole_program::get_abstract_value,
+ * so they are copied and bound to parameters along with the values. Ranges
+ * are narrowed on the edges out of a branch on an integer comparison, and
+ * widened at loop headers.
  */
 
 #ifndef PHC_VRP
 #define PHC_VRP
 
-#include "WPA.h"
+#include "optimize/Abstract_value.h"
 
-class VRP : public WPA
+#include "WPA_lattice.h"
+
+class Range_cell;
+
+class VRP : public WPA_lattice <const Alias_name*, const Range_cell>
 {
 public:
 	VRP (Whole_program* wp);
-	void dump ();
+
+	/*
+	 * WPA lattice interface
+	 */
+	const Alias_name* context_merge_key (const Alias_name*) const;
+
+	/*
+	 * WPA interface
+	 */
+	void set_scalar (Context* cx, const Value_node* storage, const Abstract_value* val);
+	void pull_possible_null (Context* cx, const Index_node* node);
+
+	void kill_value (Context* cx, const Index_node*, bool);
+	void assign_value (Context* cx, const Index_node*, const Storage_node*);
+
+	void remove_fake_node (Context* cx, const Index_node* fake);
+
+	// Narrow the results on the edges out of a comparison.
+	void pull_first_pred (Context* cx, Context* pred);
+	void pull_pred (Context* cx, Context* pred);
+
+	const Range_cell* get_value (Context* cx, Result_state state, const Alias_name* name) const;
+
+
+	/*
+	 * Arithmetic. These return NULL if the range isnt known.
+	 */
+
+	static const Range_cell* get_range (const Abstract_value* val);
+
+	static const Range_cell* get_bin_op_range (const Abstract_value* left,
+															 const Abstract_value* right,
+															 string op);
+
+	static const Range_cell* get_pre_op_range (const Abstract_value* operand, string op);
+
+	// Are the operands ints, and is the result certain to fit in a long?
+	static bool cannot_overflow (const Abstract_value* left,
+										  const Abstract_value* right,
+										  string op);
+
+	static bool cannot_overflow (const Abstract_value* operand, string op);
+
+private:
+	void refine_for_edge (Context* cx, Context* pred, Lattice_type& lat);
+	const Range_cell* get_operand_range (Context* cx, MIR::Rvalue* operand);
+	void refine_operand (Context* cx, Lattice_type& lat, MIR::Rvalue* operand, const Range_cell* range);
 };
 
+/*
+ * An interval of longs. LONG_MIN and LONG_MAX stand for unbounded.
+ */
+class Range_cell : virtual public GC_obj
+{
+public:
+	const long min;
+	const long max;
+
+	Range_cell (long min, long max);
+
+public:
+	void dump (std::ostream& os = cdebug) const;
+	bool equals (const Range_cell* other) const;
+	const Range_cell* meet (const Range_cell* other) const;
+	const Range_cell* widen (const Range_cell* other) const;
+
+	// TOP if the intersection is empty.
+	const Range_cell* intersect (long min, long max) const;
+
+	bool is_bounded () const;
+
+	static const Range_cell* get_default ();
+	static const Range_cell* TOP;
+	static const Range_cell* BOTTOM;
+};
+
+SET_COMPARABLE (Range_cell);
+typedef Lattice_map<const Alias_name*, const Range_cell> __alias_range_lattice_type;
+typedef CX_lattices<const Alias_name*, const Range_cell> __alias_range_cx_lattice_type;
+
+SET_COMPARABLE (__alias_range_cx_lattice_type);
+SET_COMPARABLE (__alias_range_lattice_type);
+
 #endif // PHC_VRP
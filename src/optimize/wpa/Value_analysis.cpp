@@ -319,6 +319,21 @@ Absval_cell::meet (const Absval_cell* other) const
 	return new Absval_cell (Abstract_value::unknown ());
 }
 
+/*
+ * Widening: a literal may still become a set of types, but a set of types
+ * which is still growing goes straight to BOTTOM.
+ */
+const Absval_cell*
+Absval_cell::widen (const Absval_cell* other) const
+{
+	const Absval_cell* result = this->meet (other);
+
+	if (this == TOP || this->value->lit || result->equals (this))
+		return result;
+
+	return new Absval_cell (Abstract_value::unknown ());
+}
+
 const Absval_cell*
 Absval_cell::get_default ()
 {
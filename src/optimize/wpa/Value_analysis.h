@@ -83,6 +83,7 @@ public:
 	void dump (std::ostream& os = cdebug) const;
 	bool equals (const Absval_cell* other) const;
 	const Absval_cell* meet (const Absval_cell* other) const;
+	const Absval_cell* widen (const Absval_cell* other) const;
 
 	static const Absval_cell* get_default ();
 	static const Absval_cell* TOP;
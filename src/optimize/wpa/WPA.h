@@ -185,10 +185,22 @@ public:
 
 	virtual void pull_finish (Context* cx) CT_IMPL;
 
+	// CX is a loop header which has been visited too often. Before the pull,
+	// save_for_widening() is called to keep the previous IN. After the pull,
+	// widen() should make values which have changed since then climb the
+	// lattice quickly, to force convergence.
+	virtual void save_for_widening (Context* cx) CT_IMPL;
+	virtual void widen (Context* cx) CT_IMPL;
+
 	// Combine local results to an OUT solution. This should set
 	// CHANGED_FLAGS [bb->ID] if neccessary.
 	virtual void finish_block (Context* cx) CT_IMPL;
 
+	// CX has been analysed, and its successors chosen, so its WORKING and
+	// POST_BIND results will not be read again (until CX is next pulled).
+	// Only the INs and OUTs are kept.
+	virtual void release_block (Context* cx) CT_IMPL;
+
 	// Do we need to iterate again?
 	virtual bool solution_changed (Context* cx) const
 	{
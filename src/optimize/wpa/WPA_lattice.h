@@ -28,6 +28,8 @@ protected:
 	CX_lattices<Key_type, Cell_type>& working;
 	CX_lattices<Key_type, Cell_type>& post_bind;
 
+	// The previous INs of loop headers, for widening.
+	CX_lattices<Key_type, Cell_type> widening_ins;
 
 public:
 	WPA_lattice (Whole_program* wp)
@@ -125,7 +127,10 @@ public:
 
 	void pull_first_pred (Context* cx, Context* pred)
 	{
-		ins[cx].merge (&outs[pred]);
+		// The maps are copy-on-write, so a block with a single predecessor
+		// shares its IN with the predecessor's OUT. Only join points get their
+		// own copy, in pull_pred.
+		ins[cx] = outs[pred];
 	}
 
 	void pull_pred (Context* cx, Context* pred)
@@ -140,6 +145,28 @@ public:
 		init_block_results (cx);
 	}
 
+	void save_for_widening (Context* cx)
+	{
+		widening_ins[cx] = ins[cx];
+	}
+
+	void widen (Context* cx)
+	{
+		Lattice_type& old = widening_ins[cx];
+
+		Key_type key;
+		Cell_type* cell;
+		foreach (tie (key, cell), *ins[cx].clone ())
+		{
+			if (old.has (key) && !old[key]->equals (cell))
+				ins[cx][key] = old[key]->widen (cell);
+		}
+
+		widening_ins.erase (cx);
+
+		init_block_results (cx);
+	}
+
 	void finish_block (Context* cx)
 	{
 		changed_flags[cx] = !working[cx].equals (&outs[cx]);
@@ -149,6 +176,12 @@ public:
 		// See comment in Aliasing::finish_block
 	}
 
+	void release_block (Context* cx)
+	{
+		working.erase (cx);
+		post_bind.erase (cx);
+	}
+
 	bool equals (WPA* wpa)
 	{
 		this_type* other = dyc<this_type> (wpa);
@@ -68,6 +68,7 @@
 #include "pass_manager/Pass_manager.h"
 
 #include "optimize/Abstract_value.h"
+#include "optimize/Builtin_model.h"
 #include "optimize/Edge.h"
 #include "optimize/Method_pruner.h"
 #include "optimize/Oracle.h"
@@ -88,6 +89,8 @@
 #include "Optimization_annotator.h"
 #include "Optimization_transformer.h"
 #include "Stat_collector.h"
+#include "Summary_db.h"
+#include "Unification_analysis.h"
 #include "Points_to.h"
 
 #include "lib/error.h"
@@ -105,13 +108,20 @@ Whole_program::Whole_program (Pass_manager* pm)
 	annotator = new Optimization_annotator (this);
 	transformer = new Optimization_transformer (this);
 	stat_coll = new Stat_collector (this);
+	summary_db = NULL;
+	callee_time = 0;
+	callee_heap = 0;
 }
 
 void
 Whole_program::run (MIR::PHP_script* in)
 {
-	// Modelled PHP builtin functions.
-	populate_modelled_functions();
+	if (pm->args_info->summary_db_given)
+	{
+		summary_db = new Summary_db;
+		summary_db->load (s(pm->args_info->summary_db_arg));
+		main_filename = in->get_filename ();
+	}
 
 	// Represents __MAIN__'s caller
 	Basic_block* outer_bb = new Empty_block (NULL);
@@ -170,6 +180,10 @@ Whole_program::run (MIR::PHP_script* in)
 			generate_summary (info);
 		}
 
+		// The specialized clones must be analysed before we can stop.
+		if (w < 8 && specialize (in))
+			continue;
+
 		// Check if we can stop iterating the Whole-program solution.
 		DEBUG ((w+1) << "th Whole-program pass");
 		if (analyses_have_converged ())
@@ -196,6 +210,9 @@ Whole_program::run (MIR::PHP_script* in)
 		info->get_method ()->statements = info->get_cfg ()->get_linear_statements ();
 	}
 
+	if (summary_db)
+		save_summaries ();
+
 	// As a final step, strip all unused functions.	
 	strip (in);
 }
@@ -231,6 +248,19 @@ Whole_program::initialize (Context* outer_cx)
 	old_analyses.push_back_all (&analyses);
 	analyses.clear ();
 
+	call_sites.clear ();
+	header_visits.clear ();
+
+	// Find the variables which are never references, before the more
+	// expensive analyses.
+	Method_info_list* methods = new Method_info_list;
+	methods->push_back_all (Oracle::get_all_methods ());
+	foreach (Class_info* class_info, *Oracle::get_all_classes ())
+		methods->push_back_all (class_info->get_methods ());
+
+	unification = new Unification_analysis;
+	unification->initialize (methods);
+
 	// Create new analyses with empty results
 	aliasing = new Aliasing (this);
 	callgraph = new Callgraph (this);
@@ -238,7 +268,7 @@ Whole_program::initialize (Context* outer_cx)
 	def_use = new Def_use (this);
 	values = new Value_analysis (this);
 //	include_analysis = new Include_analysis (this);
-//	vrp = new VRP (this);
+	vrp = new VRP (this);
 
 	register_analysis ("debug-wpa", new Debug_WPA (this));
 	register_analysis ("aliasing", aliasing);
@@ -246,8 +276,8 @@ Whole_program::initialize (Context* outer_cx)
 	register_analysis ("constants", constants);
 	register_analysis ("def-use", def_use);
 	register_analysis ("values", values);
+	register_analysis ("vrp", vrp);
 //	register_analysis ("Include_analysis", include_analysis);
-//	register_analysis ("VRP", vrp);
 
 
 	/*
@@ -265,6 +295,22 @@ Whole_program::initialize (Context* outer_cx)
 	this->skip_after_die = false;
 }
 
+// With --widening-threshold=0, integer ranges are still widened after this
+// many visits to a loop header.
+#define RANGE_WIDENING_THRESHOLD 3
+
+// Bytes allocated since startup. Without the GC we cant tell, so
+// --function-memory-budget has no effect.
+static long
+get_allocated_bytes ()
+{
+#ifdef DISABLE_GC
+	return 0;
+#else
+	return GC_get_total_bytes ();
+#endif
+}
+
 void
 Whole_program::analyse_function (User_method_info* info, Context* caller_cx, MIR::Actual_parameter_list* actuals, MIR::VARIABLE_NAME* lhs)
 {
@@ -280,6 +326,22 @@ Whole_program::analyse_function (User_method_info* info, Context* caller_cx, MIR
 	Worklist wl;
 	wl.add (cfg->get_entry_edge ());
 
+	if (pm->args_info->adaptive_context_flag)
+		apply_context_policy (info, caller_cx);
+
+	// Charge our callees' analysis to them, not us.
+	clock_t saved_callee_time = callee_time;
+	long saved_callee_heap = callee_heap;
+	callee_time = 0;
+	callee_heap = 0;
+	clock_t start_time = clock ();
+	long start_heap = get_allocated_bytes ();
+	bool over_budget = false;
+
+	// Results at loop headers are widened after this many visits.
+	int widening_threshold = pm->args_info->widening_threshold_arg;
+	Set<Basic_block*>* loop_headers = cfg->get_loop_headers ();
+
 	// Process the entry blocks first (there is no edge here)
 	DEBUG ("Initing functions");
 	Context* entry_cx = Context::contextual (caller_cx, cfg->get_entry_bb ());
@@ -308,13 +370,45 @@ Whole_program::analyse_function (User_method_info* info, Context* caller_cx, MIR
 				preds->push_back (pred_edge->get_source ());
 		}
 
-		// Merge results from predecessors
+		// Merge results from predecessors. If a loop header has been
+		// visited too often, widen its results to force convergence. Integer
+		// ranges would never converge otherwise, so they are widened even
+		// if widening is disabled.
+		bool widen = false;
+		bool widen_ranges = false;
+		if (loop_headers->has (target))
+		{
+			int visits = ++header_visits[target_cx];
+			if (widening_threshold > 0)
+				widen = visits > widening_threshold;
+			else
+				widen_ranges = visits > RANGE_WIDENING_THRESHOLD;
+		}
+
+		if (widen)
+			FWPA->save_for_widening (target_cx);
+		else if (widen_ranges)
+			vrp->save_for_widening (target_cx);
+
 		pull_results (target_cx, preds);
 
+		if (widen)
+		{
+			CTS ("loop_header_widenings");
+			FWPA->widen (target_cx);
+		}
+		else if (widen_ranges)
+			vrp->widen (target_cx);
+
+		CTS ("wpa_block_visits");
+
 		// Analyse the block, storing per-basic-block results.
 		// This does not update the block's structure.
 		bool changed = analyse_block (target_cx);
 
+		if (!over_budget)
+			over_budget = check_budget (info, start_time, start_heap);
+
 		// Add next	block(s) if the result has changed, or if this the first
 		// time the edge could be executed.
 		foreach (Edge* next, *get_successors (target_cx)) {
@@ -345,12 +439,81 @@ Whole_program::analyse_function (User_method_info* info, Context* caller_cx, MIR
 		}
 
 		skip_after_die = false;
+
+		// Only the block's IN and OUT are needed from here on.
+		FWPA->release_block (target_cx);
 	}
 
+	callee_time = saved_callee_time + (clock () - start_time);
+	callee_heap = saved_callee_heap + (get_allocated_bytes () - start_heap);
+
 	backward_bind (
 		info,
 		Context::contextual (caller_cx, cfg->get_exit_bb ()),
 		lhs);
+
+	// Collapsing changes the names of the method's contexts, so wait until
+	// this invocation's results are bound back.
+	if (over_budget)
+	{
+		DEBUG (*info->name << " is over budget, analysing it context-insensitively");
+		CTS ("functions_collapsed_over_budget");
+		Context::collapse (cfg->get_entry_bb ());
+	}
+}
+
+/*
+ * Collapse methods which would be too expensive to analyse in every context:
+ * those called from many places, and large methods.
+ */
+void
+Whole_program::apply_context_policy (User_method_info* info, Context* caller_cx)
+{
+	// __MAIN__ only has one context.
+	if (caller_cx->is_outer ())
+		return;
+
+	Basic_block* entry = info->get_cfg ()->get_entry_bb ();
+	if (Context::is_collapsed (entry))
+		return;
+
+	string method = Context::method_name (entry);
+	Basic_block* call_site = caller_cx->get_bb ();
+	call_sites[method].insert (call_site->get_prefix () + lexical_cast<string> (call_site->ID));
+
+	if ((int)(call_sites[method].size ()) > pm->args_info->context_call_sites_arg
+		|| (int)(info->get_cfg ()->get_all_bbs ()->size ()) > pm->args_info->context_blocks_arg)
+	{
+		DEBUG ("Analysing " << *info->name << " context-insensitively");
+		CTS ("functions_collapsed_by_policy");
+		Context::collapse (entry);
+	}
+}
+
+/*
+ * Once a method exceeds its budget, analyse its future invocations
+ * context-insensitively. We do not abandon the current invocation, as its
+ * results are needed, and a partial result would be unsound. Returns true if
+ * INFO is over budget.
+ */
+bool
+Whole_program::check_budget (User_method_info* info, clock_t start_time, long start_heap)
+{
+	int time_budget = pm->args_info->function_time_budget_arg;
+	int memory_budget = pm->args_info->function_memory_budget_arg;
+
+	if (time_budget == 0 && memory_budget == 0)
+		return false;
+
+	Basic_block* entry = info->get_cfg ()->get_entry_bb ();
+	if (Context::is_collapsed (entry) || *info->name == "__MAIN__")
+		return false;
+
+	long time = (clock () - start_time - callee_time) * 1000 / CLOCKS_PER_SEC;
+	long memory = (get_allocated_bytes () - start_heap - callee_heap) / (1024 * 1024);
+
+	return (time_budget && time > time_budget)
+		|| (memory_budget && memory > memory_budget);
 }
 
 Edge_list*
@@ -362,7 +525,7 @@ Whole_program::get_successors (Context* cx)
 
 	if (Branch_block* branch = dynamic_cast<Branch_block*> (bb))
 	{
-		const Abstract_value* absval = get_abstract_value (cx, R_WORKING, branch->branch->variable_name);
+		const Abstract_value* absval = get_abstract_value (cx, R_OUT, branch->branch->variable_name);
 
 		if (not absval->known_true ())
 			result->push_back (branch->get_false_successor_edge ());
@@ -659,6 +822,31 @@ Whole_program::analyse_method_info (Method_info* method_info,
 												MIR::Actual_parameter_list* actuals,
 												MIR::VARIABLE_NAME* lhs)
 {
+	// Functions outside the file being compiled may have a summary from a
+	// previous compilation. They are still called at run-time, so keep them.
+	if (summary_db && method_info->has_implementation ())
+	{
+		User_method_info* user_info = dyc<User_method_info> (method_info);
+
+		// Hash the function before we optimize it.
+		summary_db->get_hash (user_info);
+
+		if (*user_info->get_method ()->get_filename () != *main_filename)
+		{
+			List<const Types*>* arg_types = new List<const Types*>;
+			foreach (Actual_parameter* ap, *actuals)
+				arg_types->push_back (get_abstract_value (caller_cx, R_WORKING, ap->rvalue)->types);
+
+			Summarized_method_info* summarized = summary_db->get_summarized_method_info (user_info, arg_types);
+			if (summarized)
+			{
+				user_info->get_method ()->attrs->set_true ("phc.optimize.used");
+				analyse_summary (summarized, caller_cx, actuals, lhs);
+				return;
+			}
+		}
+	}
+
 	if (method_info->has_implementation ())
 	{
 		analyse_function (dyc<User_method_info> (method_info), caller_cx, actuals, lhs);
@@ -721,293 +909,6 @@ Whole_program::analyse_summary (Summary_method_info* info, Context* caller_cx, A
 	backward_bind (info, exit_cx, lhs);
 }
 
-void
-Whole_program::populate_modelled_functions()
-{
-/* Define a macro to model the types of return values, and the parameters which
- * may be coerced. */
-#define COERCE(...)															\
-	do																				\
-	{																				\
-		int __coerced_array[] = {-1, __VA_ARGS__};					\
-																					\
-		foreach (int __int, __coerced_array)							\
-			coercion_model[__name].push_back (__int);					\
-																					\
-		coercion_model[__name].pop_front (); /* get rid of -1	*/	\
-																					\
-	} while (0)
-
-// There's a nice trick that I want () to be the empty set, so that's why I
-// have COERCE as well.
-#define MODEL(NAME, COERCED, ...)	\
-	do																				\
-	{																				\
-		string __name = #NAME;												\
-		modelled_functions.insert (__name);								\
-																					\
-		COERCE COERCED; /* We want () to be the empty set. */		\
-																					\
-		Types* __types  = new Types (__VA_ARGS__);					\
-		if (__types->size ())												\
-			type_model[__name] = __types;									\
-	} while (0)
-
-
-	MODEL (abs, (0), "int", "real");
-	MODEL (addslashes, (0), "string");
-	MODEL (array_key_exists, (), "bool");
-	MODEL (assert, (), "bool");
-	MODEL (base64_decode, (0), "string", "bool");
-	MODEL (base64_encode, (0), "string");
-	MODEL (basename, (0, 1), "string");
-	MODEL (bcadd, (0, 1), "string");
-	MODEL (bccomp, (0, 1), "int");
-	MODEL (bcdiv, (0, 1), "string");
-	MODEL (bcmod, (0, 1), "string");
-	MODEL (bcmul, (0, 1), "string");
-	MODEL (bcscale, (), "int");
-	MODEL (bcsqrt, (0), "string", "unset");
-	MODEL (bcsub, (0, 1), "string");
-	MODEL (bin2hex, (0), "string");
-	MODEL (ceil, (), "real");
-	MODEL (chdir, (0), "bool");
-	MODEL (chmod, (0), "bool");
-	MODEL (chop, (0, 1), "string");
-	MODEL (chr, (), "string");
-	MODEL (chunk_split, (0, 2), "string");
-	MODEL (class_exists, (0), "bool"); // FIXME: We can do better.
-	MODEL (clearstatcache, (1));
-	MODEL (closedir, ());
-	MODEL (copy, (0, 1), "bool");
-	MODEL (cos, (), "real");
-	MODEL (count, (), "int");
-	MODEL (convert_uuencode, (0), "string");
-	MODEL (crc32, (0), "int");
-	MODEL (crypt, (0, 1), "string");
-	MODEL (ctype_alnum, (0), "bool");
-	MODEL (date, (0), "string", "bool");
-	MODEL (date_default_timezone_set, (0), "bool");
-	MODEL (debug_backtrace, ());
-	MODEL (debug_zval_dump, ());
-	MODEL (dechex, (), "string");
-	MODEL (dirname, (0), "string");
-	MODEL (doubleval, (0), "float");
-	MODEL (ereg_replace, (0, 1, 2), "string");	
-	MODEL (eregi_replace, (0, 1, 2), "string");
-	MODEL (error_reporting, ());
-	MODEL (error_reporting, (), "int");
-	MODEL (escapeshellcmd, (0), "string");
-	MODEL (extension_loaded, (0), "bool");
-	MODEL (fclose, (), "bool");
-	MODEL (feof, (), "bool");
-	MODEL (fflush, (), "bool");
-	MODEL (fgets, (), "bool", "string");
-	MODEL (fileatime, (0), "int", "bool");
-	MODEL (file_exists, (0), "bool");
-	MODEL (file_get_contents, (0), "string", "bool");
-	MODEL (filemtime, (0), "int", "bool");
-	MODEL (fileowner, (0), "int", "bool");
-	MODEL (fileperms, (0), "int");
-	MODEL (file_put_contents, (0), "int", "bool");
-	MODEL (filesize, (0), "int");
-	MODEL (floor, (), "real");
-	MODEL (flush, ());
-	MODEL (fmod, (), "real");
-	MODEL (fopen, (0, 1), "resource");
-	MODEL (fputs, (1), "int", "bool");
-	MODEL (fread, (), "string", "bool");
-	MODEL (fsockopen, (0, 3), "resource", "bool");
-	MODEL (function_exists, (0), "bool");
-	MODEL (fwrite, (1), "int", "bool");
-	MODEL (get_cfg_var, (0), "string");
-	MODEL (get_class, (), "string", "false");
-	MODEL (getcwd, (), "string");
-	MODEL (get_hostbyname, (0), "string");
-	MODEL (get_magic_quotes_gpc, (), "int");
-	MODEL (get_magic_quotes_runtime, (), "int");
-	MODEL (getmypid, (), "int", "bool");
-	MODEL (get_parent_class, (), "string" ,"bool");
-	MODEL (getenv, (0), "string", "bool");
-	MODEL (getrandmax, (), "int");
-	MODEL (gettype, (), "string");
-	MODEL (gmdate, (0), "string");
-	MODEL (header, (0));
-	MODEL (hexdec, (0), "int", "real");
-	MODEL (highlight_string, (0), "string", "bool");
-	MODEL (html_entity_decode, (0, 2), "string");
-	MODEL (htmlentities, (0, 2), "string");
-	MODEL (htmlspecialchars, (0, 2), "string");
-	MODEL (ignore_user_abort, (0), "int");
-	MODEL (imagecolorallocate, (), "resource", "bool");
-	MODEL (imagecopyresampled, (), "bool");
-	MODEL (imagecreatefromgif, (0), "resource");
-	MODEL (imagecreatefrompng, (0), "resource");
-	MODEL (imagecreatefromwbmp, (0), "resource");
-	MODEL (imagecreate, (), "resource");
-	MODEL (imagecreatetruecolor, (), "resource");
-	MODEL (imagedestroy, (), "bool");
-	MODEL (imagefill, (), "bool");
-	MODEL (imagefontcreate, (), "resource");
-	MODEL (imagefontheight, (), "int");
-	MODEL (imagefontwidth, (), "int");
-	MODEL (imagegif, (1), "bool");
-	MODEL (imageline, (), "bool");
-	MODEL (imagepng, (1), "bool");
-	MODEL (imagestring, (4), "bool");
-	MODEL (imagesx, (), "int");
-	MODEL (imagesy, (), "int");
-	MODEL (imagetypes, (), "int");
-	MODEL (imagewbmp, (1), "bool");
-	MODEL (implode, (0), "string"); // um, this takes parameters in either order
-	MODEL (in_array, (), "bool");
-	MODEL (ini_get, (), "string");
-	MODEL (ini_set, (0, 1), "string");
-	MODEL (intval, (), "int");
-	MODEL (ip2long, (0), "int", "bool");
-	MODEL (is_callable, (3), "bool"); // FIXME: Should be a special case.
-	MODEL (is_dir, (0), "bool");
-	MODEL (is_executable, (0), "bool");
-	MODEL (is_file, (0), "bool");
-	MODEL (is_infinite, (), "bool");
-	MODEL (is_readable, (0), "bool");
-	MODEL (is_writable, (0), "bool");
-	MODEL (is_writeable, (0), "bool");
-	MODEL (join, (0), "string"); // alias of implode
-	MODEL (key, (), "int", "string");
-	MODEL (log, (), "float");
-	MODEL (ltrim, (0, 1), "string");
-	MODEL (mail, (0, 1, 2, 3, 4), "bool");
-	MODEL (md5, (0), "string");
-	MODEL (method_exists, (1), "bool");
-	MODEL (microtime, (), "string", "real");
-	MODEL (mime_content_type, (0), "string");
-	MODEL (mkdir, (0), "bool");
-	MODEL (mktime, (), "int");
-	MODEL (move_uploaded_file, (0, 1), "bool");
-	MODEL (mt_rand, (), "int");
-	MODEL (mysql_affected_rows, (), "int");
-	MODEL (mysql_close, (), "bool");
-	MODEL (mysql_connect, (0, 1, 2), "resource", "bool");
-	MODEL (mysql_data_seek, (), "bool");
-	MODEL (mysql_errno, (), "int");
-	MODEL (mysql_error, (), "string");
-	MODEL (mysql_field_name, (), "string", "bool");
-	MODEL (mysql_field_type, (), "string");
-	MODEL (mysql_get_server_info, (), "string", "bool");
-	MODEL (mysql_insert_id, (), "int", "bool");
-	MODEL (mysql_num_fields, (), "int", "bool");
-	MODEL (mysql_num_rows, (), "int", "bool");
-	MODEL (mysql_pconnect, (0, 1, 2), "resource", "bool");
-	MODEL (mysql_query, (0), "resource", "bool");
-	MODEL (mysql_real_escape_string, (0), "string", "bool");
-	MODEL (mysql_result, (), "string", "bool");
-	MODEL (mysql_select_db, (0), "bool");
-	MODEL (nl2br, (0), "string");
-	MODEL (number_format, (2, 3), "string");
-	MODEL (ob_get_contents, (), "string", "bool");
-	MODEL (ob_get_level, (0), "int");
-	MODEL (ob_end_clean, (0), "bool");
-	MODEL (ob_end_flush, (), "bool");
-	MODEL (opendir, (0), "resource");
-	MODEL (ord, (0), "int");
-	MODEL (passthru, (0));
-	MODEL (phpinfo, (), "bool");
-	MODEL (php_uname, (0), "string");
-	MODEL (phpversion, (0), "string", "bool");
-	MODEL (posix_kill, (), "bool");
-	MODEL (pow, (), "int", "real", "bool");
-	MODEL (preg_quote, (0, 1), "string");
-	MODEL (printf, (0), "int");
-	MODEL (proc_close, (), "int");
-	MODEL (proc_open, (0, 3), "resource");
-	MODEL (proc_terminate, (), "bool");
-	MODEL (quotemeta, (0), "string");
-	MODEL (rand, (), "int");
-	MODEL (readdir, (), "string", "bool");
-	MODEL (readfile, (0), "int", "bool");
-	MODEL (rmdir, (0), "bool");
-	MODEL (round, (), "real");
-	MODEL (rtrim, (0, 1), "string");
-	MODEL (serialize, (), "string");
-	MODEL (session_destroy, (), "bool");
-	MODEL (session_id, (0), "string");
-	MODEL (session_is_registered, (0), "bool");
-	MODEL (session_name, (0), "string");
-	MODEL (session_regenerate_id, (), "bool");
-	MODEL (session_start, (), "bool");
-	MODEL (session_write_close, ());
-	MODEL (set_magic_quotes_runtime, (), "bool");
-	MODEL (set_time_limit, ());
-	MODEL (setcookie, (0, 1, 3, 4), "bool");
-	MODEL (shell_exec, (0), "string");
-	MODEL (shuffle, (), "bool");
-	MODEL (sin, (), "real");
-	MODEL (sizeof, (), "int");
-	MODEL (sleep, (), "int", "bool");
-	MODEL (sort, (), "bool");
-	MODEL (sprintf, (0), "string");
-	MODEL (sqlite_busy_timeout, ());
-	MODEL (sqlite_changes, (), "int");
-	MODEL (sqlite_error_string, (), "string");
-	MODEL (sqlite_escape_string, (0), "string");
-	MODEL (sqlite_last_error, (), "int");
-	MODEL (sqlite_last_insert_rowid, (), "int");
-	MODEL (sqlite_libencoding, (), "string");
-	MODEL (sqlite_libversion, (), "string");
-	MODEL (sqlite_num_rows, (), "int");
-	MODEL (sqlite_open, (0, 2), "resource", "bool");
-	MODEL (sqlite_popen, (0, 2), "resource", "bool");
-	MODEL (sqlite_query, (1, 3), "resource", "bool");
-	MODEL (sqlite_seek, (), "bool");
-	MODEL (sqlite_udf_decode_binary, (0), "string");
-	MODEL (sqlite_udf_encode_binary, (0), "string");
-	MODEL (sqlite_unbuffered_query, (1, 3), "resource", "bool");
-	MODEL (sqrt, (), "real");
-	MODEL (srand, ());
-	MODEL (strchr, (0), "string");
-	MODEL (strcmp, (0), "int");
-	MODEL (stream_get_contents, (), "string", "false");
-	MODEL (stream_set_blocking, (), "bool");
-	MODEL (strftime, (0), "string");
-	MODEL (stripslashes, (0), "string");
-	MODEL (strip_tags, (0, 1), "string");
-	MODEL (stristr, (0), "string");
-	MODEL (strlen, (0), "int");
-	MODEL (str_pad, (0, 2), "string");
-	MODEL (strpos, (0, 1), "int", "bool");
-	MODEL (str_repeat, (0), "string");
-	MODEL (strrchr, (0), "string", "bool");
-	MODEL (strrev, (0), "string");
-	MODEL (strstr, (0), "string");
-	MODEL (strtolower, (0), "string");
-	MODEL (strtotime, (0), "int", "bool");
-	MODEL (strtoupper, (0), "string");
-	MODEL (strtr, (0, 1, 2), "string");
-	MODEL (strval, (0), "string");
-	MODEL (substr, (0), "string", "bool");
-	MODEL (substr_count, (0, 1), "int");
-	MODEL (symlink, (0, 1), "bool");
-	MODEL (sys_get_temp_dir, (), "string");
-	MODEL (tempnam, (0, 1), "string");
-	MODEL (time, (), "int");
-	MODEL (trim, (0, 1), "string");
-	MODEL (ucfirst, (0), "string");
-	MODEL (uniqid, (0), "string");
-	MODEL (unlink, (0), "bool");
-	MODEL (urldecode, (0), "string");
-	MODEL (urlencode, (0), "string");
-	MODEL (usleep, ());
-	MODEL (var_dump, ());
-	MODEL (version_compare, (0, 1, 2), "bool", "int");
-	MODEL (wordwrap, (0, 2), "string");
-	MODEL (zend_version, (), "string");
-
-
-#undef MODEL
-#undef COERCE
-}
-
 // BB is the block representing the whole method
 void
 Whole_program::apply_modelled_function (Summary_method_info* info, Context* cx, Context* caller_cx)
@@ -1057,11 +958,18 @@ Whole_program::apply_modelled_function (Summary_method_info* info, Context* cx,
 
 	Path* ret_path = P (symtable, new VARIABLE_NAME (RETNAME));
 
+	// Summaries from the database only have a return value.
+	if (Summarized_method_info* summarized = dynamic_cast<Summarized_method_info*> (info))
+	{
+		CTS ("summarized_functions_analysed");
+		assign_path_typed (cx, ret_path, summarized->summary->return_types->clone ());
+		return;
+	}
 	
 	// Check if we can just invoke the function (we dont do this for objects to
 	// avoid the coercion problem. We probably could though, by just moving this
 	// to the end.
-	if (not info->get_side_effecting ())
+	if (Builtin_models::is_foldable (info->name))
 	{
 		// Check all parameters are literals
 		bool all_literals = true;
@@ -1096,16 +1004,25 @@ Whole_program::apply_modelled_function (Summary_method_info* info, Context* cx,
 	}
 
 	// Handle all the simple cases
-	if (modelled_functions.has (*info->name))
+	Function_model* model = Builtin_models::get_model (info->name);
+	if (model && !model->special)
 	{
-		foreach (int i, coercion_model [*info->name])
+		foreach (int i, model->coerced)
 		{
 			params[i] = coerce_to_string (cx, params[i]);
 		}
 
+		int i;
+		Value_model* out;
+		foreach (tie (i, out), model->out_params)
+		{
+			if (params[i])
+				assign_path_modelled (cx, paths[i], out);
+		}
+
 		// It may not have a return type
-		if (type_model.has (*info->name))
-			assign_path_typed (cx, ret_path, type_model[*info->name]->clone ());
+		if (model->returns)
+			assign_path_modelled (cx, ret_path, model->returns);
 	}
 
 	// Now all the hard cases
@@ -1265,64 +1182,6 @@ Whole_program::apply_modelled_function (Summary_method_info* info, Context* cx,
 		else
 			assign_path_typed (cx, ret_path, new Types ("bool"));
 	}
-	else if (*info->name == "ereg" || *info->name == "eregi")
-	{
-		params[0] = coerce_to_string (cx, params[0]);
-		params[1] = coerce_to_string (cx, params[1]);
-
-		if (params[2])
-		{
-			assign_path_typed_array (cx, paths[2], new Types ("string"), ANON);
-		}
-
-		assign_path_typed (cx, ret_path, new Types ("int", "bool"));
-	}
-	else if (*info->name == "exec")
-	{
-		params[0] = coerce_to_string (cx, params[0]);
-
-		// Output
-		if (params[1])
-			assign_path_typed_array (cx, paths[1], new Types ("string"), ANON);
-
-		// Return code
-		if (params[2])
-			assign_path_typed (cx, paths[2], new Types ("int"));
-
-		assign_path_typed (cx, ret_path, new Types ("string"));
-	}
-	else if (*info->name == "explode")
-	{
-		params[0] = coerce_to_string (cx, params[0]);
-		params[1] = coerce_to_string (cx, params[1]);
-
-		assign_path_typed_array (cx, ret_path, new Types ("string"), ANON);
-	}
-	else if (*info->name == "file")
-	{
-		params[0] = coerce_to_string (cx, params[0]);
-
-		assign_path_typed_array (cx, ret_path, new Types ("string"), ANON);
-	}
-	else if (*info->name == "get_declared_classes")
-	{
-		// Return an array of strings
-		assign_path_typed_array (cx, ret_path, new Types ("string"), ANON);
-	}
-	else if (*info->name == "getimagesize")
-	{
-		params[0] = coerce_to_string (cx, params[0]);
-
-		// Output
-		if (params[1])
-			assign_path_typed_array (cx, paths[1], new Types ("string"), ANON);
-
-		assign_path_typed_array (cx, ret_path, new Types ("string"), ANON);
-	}
-	else if (*info->name == "get_loaded_extensions")
-	{
-		assign_path_typed_array (cx, ret_path, new Types ("string"), ANON);
-	}
 	else if (*info->name == "gettimeofday")
 	{
 		// TODO handle better
@@ -1366,11 +1225,6 @@ Whole_program::apply_modelled_function (Summary_method_info* info, Context* cx,
 		}
 	}
 
-	else if (*info->name == "glob")
-	{
-		assign_path_typed_array (cx, ret_path, new Types ("string"), ANON);
-	}
-
 	else if (*info->name == "is_array"
 			|| *info->name == "is_int"
 			|| *info->name == "is_integer"
@@ -1611,34 +1465,11 @@ Whole_program::apply_modelled_function (Summary_method_info* info, Context* cx,
 			assign_path_typed (cx, P (name, "fragment"), new Types ("string"));
 		}
 	}
-	else if (*info->name == "posix_getgrgid"
-		|| *info->name == "posix_getpwuid")
-	{
-		assign_path_typed_array (cx, ret_path, new Types ("string"), ANON);
-	}
 	else if (*info->name == "print")
 	{
 		params[0] = coerce_to_string (cx, params[0]);
 		assign_path_scalar (cx, ret_path, new INT (1));
 	}
-	else if (*info->name == "preg_grep")
-	{
-		params[0] = coerce_to_string (cx, params[0]);
-
-		assign_path_typed_array (cx, ret_path, new Types ("string"), ANON);
-	}
-	else if (*info->name == "preg_match" || *info->name == "preg_match_all")
-	{
-		params[0] = coerce_to_string (cx, params[0]);
-		params[1] = coerce_to_string (cx, params[1]);
-
-		if (params[2])
-		{
-			assign_path_typed_array (cx, paths[2], new Types ("string"), ANON);
-		}
-
-		assign_path_typed (cx, ret_path, new Types ("int", "bool"));
-	}
 	else if (*info->name == "preg_replace"
 			|| *info->name == "str_replace")
 	{
@@ -1680,24 +1511,6 @@ Whole_program::apply_modelled_function (Summary_method_info* info, Context* cx,
 
 		assign_path_typed_array (cx, ret_path, merged, ANON);
 	}
-	else if (*info->name == "stat")
-	{
-		params[0] = coerce_to_string (cx, params[0]);
-
-		assign_path_typed_array (cx, ret_path, new Types ("string", "int"), ANON);
-	}
-	else if (*info->name == "split")
-	{
-		params[0] = coerce_to_string (cx, params[0]);
-		params[1] = coerce_to_string (cx, params[1]);
-		assign_path_typed_array (cx, ret_path, new Types ("string"), ANON);
-	}
-	else if (*info->name == "sqlite_current"
-		|| *info->name == "sqlite_fetch_array"
-		)
-	{
-		assign_path_typed_array (cx, ret_path, new Types ("string"), ANON);
-	}
 	else if (*info->name == "strval")
 	{
 		// TODO: It shouldn't be an object or array
@@ -1835,6 +1648,249 @@ Whole_program::strip (MIR::PHP_script* in)
 	in->transform_children (new Method_pruner ());
 }
 
+/*
+ * Function specialization. When a function is called with constant
+ * arguments, and its body makes enough use of the corresponding parameters,
+ * clone it with those parameters bound to the constants, and call the clone
+ * instead. The analyses can then fold the clone's body, which they can't
+ * do to the original once all its contexts are merged.
+ */
+
+// Specialize only if the constant parameters are used this often.
+#define SPECIALIZE_MIN_BENEFIT 2
+
+// Don't specialize functions with more blocks than this.
+#define SPECIALIZE_MAX_SIZE 100
+
+// Don't make more clones than this of any one function.
+#define SPECIALIZE_MAX_CLONES 4
+
+class Parameter_use_counter : public Visitor, virtual public GC_obj
+{
+public:
+	Set<string>* params;
+	int uses;
+	bool can_specialize;
+
+	Parameter_use_counter (Set<string>* params)
+	: params (params)
+	, uses (0)
+	, can_specialize (true)
+	{
+	}
+
+	void pre_variable_name (VARIABLE_NAME* in)
+	{
+		if (params->has (*in->value))
+			uses++;
+	}
+
+	// Each clone would get its own statics.
+	void pre_static_declaration (Static_declaration*) { can_specialize = false; }
+	void pre_variable_variable (Variable_variable*) { can_specialize = false; }
+
+	void pre_method_invocation (Method_invocation* in)
+	{
+		METHOD_NAME* name = dynamic_cast<METHOD_NAME*> (in->method_name);
+		if (name == NULL
+			or *name->value == "func_get_args"
+			or *name->value == "func_get_arg"
+			or *name->value == "func_num_args"
+			or *name->value == "get_defined_vars"
+			or *name->value == "compact"
+			or *name->value == "extract"
+			or *name->value == "debug_backtrace"
+			or *name->value == "debug_print_backtrace")
+		{
+			can_specialize = false;
+		}
+	}
+};
+
+// The function's entry checks type hints, which the clone would skip. An
+// array hint is a CLASS_NAME "array", so this excludes those too.
+static bool
+is_constant_argument (Formal_parameter* fp, Actual_parameter* ap)
+{
+	return isa<Literal> (ap->rvalue)
+		&& not ap->is_ref
+		&& not fp->is_ref
+		&& fp->type->class_name == NULL;
+}
+
+// Returns NULL if the call shouldn't be specialized.
+String*
+Whole_program::get_specialization (MIR::PHP_script* in, User_method_info* info, Actual_parameter_list* actuals)
+{
+	Method* method = info->get_method ();
+	Formal_parameter_list* formals = method->signature->formal_parameters;
+
+	// Extra arguments are only visible through func_get_args.
+	if (actuals->size () > formals->size ())
+		return NULL;
+
+	// Find the constant arguments
+	string key = *info->lc_name + "(";
+	Set<string> constant_params;
+	Map<string, Literal*> constants;
+
+	Actual_parameter_list::const_iterator ap = actuals->begin ();
+	foreach (Formal_parameter* fp, *formals)
+	{
+		if (ap == actuals->end ())
+			break;
+
+		if (is_constant_argument (fp, *ap))
+		{
+			Literal* lit = dyc<Literal> ((*ap)->rvalue);
+			string name = *fp->var->variable_name->value;
+			constant_params.insert (name);
+			constants[name] = lit;
+			key += lexical_cast<string> (lit->classid ()) + ":" + *lit->get_value_as_string ();
+		}
+
+		key += ",";
+		ap++;
+	}
+	key += ")";
+
+	if (constant_params.size () == 0)
+		return NULL;
+
+	if (specializations.has (key))
+		return specializations[key];
+
+	if (num_specializations[*info->lc_name] >= SPECIALIZE_MAX_CLONES)
+		return NULL;
+
+	// Benefit
+	CFG* cfg = info->get_cfg ();
+	if (cfg->get_all_bbs ()->size () > SPECIALIZE_MAX_SIZE)
+		return NULL;
+
+	Statement_list* statements = cfg->get_linear_statements ()->clone ();
+
+	Parameter_use_counter counter (&constant_params);
+	foreach (Statement* s, *statements)
+		s->visit (&counter);
+
+	if (not counter.can_specialize || counter.uses < SPECIALIZE_MIN_BENEFIT)
+		return NULL;
+
+
+	/*
+	 * Create the clone. The constant parameters become locals, initialized
+	 * to the constants. The clone is registered under its own name, but
+	 * phc.optimize.original_name tells the code generator to give its
+	 * zend_function the original name, for error messages and backtraces.
+	 */
+	int num = num_specializations[*info->lc_name];
+	String* name = s (*info->name + "__spec" + lexical_cast<string> (num));
+
+	// Oracle::add_method_info would replace a function of the same name.
+	if (Oracle::get_method_info (name))
+		return NULL;
+
+	num_specializations[*info->lc_name]++;
+
+	Signature* signature = method->signature->clone ();
+	signature->method_name->value = name;
+	signature->attrs->set ("phc.optimize.original_name", info->name);
+	signature->formal_parameters = new Formal_parameter_list;
+
+	Statement_list* inits = new Statement_list;
+	foreach (Formal_parameter* fp, *formals)
+	{
+		string param = *fp->var->variable_name->value;
+		if (constant_params.has (param))
+		{
+			inits->push_back (new Assign_var (
+				fp->var->variable_name->clone (),
+				false,
+				constants[param]->clone ()));
+		}
+		else
+			signature->formal_parameters->push_back (fp->clone ());
+	}
+	statements->push_front_all (inits);
+
+	Method* clone = new Method (signature, statements);
+	clone->attrs->set_true ("phc.optimize.specialized");
+
+	in->statements->push_back (clone);
+	Oracle::add_method_info (new User_method_info (clone));
+
+	DEBUG ("Specializing " << key << " as " << *name);
+
+	specializations[key] = name;
+	return name;
+}
+
+/*
+ * Redirect calls with constant arguments to specialized clones. Returns true
+ * if any calls were changed.
+ */
+bool
+Whole_program::specialize (MIR::PHP_script* in)
+{
+	bool changed = false;
+
+	foreach (Method_info* mi, *callgraph->bottom_up ())
+	{
+		User_method_info* caller = dynamic_cast<User_method_info*> (mi);
+		if (caller == NULL)
+			continue;
+
+		foreach (Basic_block* bb, *caller->get_cfg ()->get_all_bbs ())
+		{
+			Statement_block* sb = dynamic_cast<Statement_block*> (bb);
+			if (sb == NULL)
+				continue;
+
+			Method_invocation* call = NULL;
+			if (Eval_expr* eval = dynamic_cast<Eval_expr*> (sb->statement))
+				call = dynamic_cast<Method_invocation*> (eval->expr);
+			else if (Assign_var* assign = dynamic_cast<Assign_var*> (sb->statement))
+				call = dynamic_cast<Method_invocation*> (assign->rhs);
+
+			if (call == NULL
+				|| call->target
+				|| not isa<METHOD_NAME> (call->method_name))
+				continue;
+
+			User_method_info* callee = Oracle::get_user_method_info (
+				dyc<METHOD_NAME> (call->method_name)->value);
+
+			if (callee == NULL
+				|| not callee->has_implementation ()
+				|| callee->get_method ()->attrs->is_true ("phc.optimize.specialized"))
+				continue;
+
+			String* name = get_specialization (in, callee, call->actual_parameters);
+			if (name == NULL)
+				continue;
+
+			// Drop the constant arguments.
+			Formal_parameter_list::const_iterator fp =
+				callee->get_method ()->signature->formal_parameters->begin ();
+			Actual_parameter_list* remaining = new Actual_parameter_list;
+			foreach (Actual_parameter* ap, *call->actual_parameters)
+			{
+				if (not is_constant_argument (*fp, ap))
+					remaining->push_back (ap);
+
+				fp++;
+			}
+
+			call->method_name = new METHOD_NAME (name);
+			call->actual_parameters = remaining;
+			changed = true;
+		}
+	}
+
+	return changed;
+}
+
 void
 Whole_program::generate_summary (User_method_info* info)
 {
@@ -1843,6 +1899,39 @@ Whole_program::generate_summary (User_method_info* info)
 		info->set_side_effecting (true);
 }
 
+/*
+ * Save the summaries of the functions which only return a scalar, so that
+ * later compilations needn't analyse them.
+ */
+void
+Whole_program::save_summaries ()
+{
+	foreach (Method_info* mi, *callgraph->bottom_up ())
+	{
+		User_method_info* info = dynamic_cast<User_method_info*> (mi);
+
+		if (info == NULL || *info->name == "__MAIN__")
+			continue;
+
+		Context* cx = Context::non_contextual (info->get_cfg ()->get_exit_bb ());
+		if (!values->has_analysis_result (cx, R_OUT))
+			continue;
+
+		const Abstract_value* absval = get_abstract_value (cx, R_OUT, new VARIABLE_NAME (RETNAME));
+
+		// The types the function was analysed with, merged over all calls.
+		Context* entry_cx = Context::non_contextual (info->get_cfg ()->get_entry_bb ());
+		List<const Types*>* param_types = new List<const Types*>;
+		for (int i = 0; i < info->formal_param_count (); i++)
+			param_types->push_back (get_abstract_value (entry_cx, R_OUT, info->param_name (i))->types);
+
+		if (summary_db->add_summary (info, absval->types, param_types))
+			CTS ("num_summaries_saved");
+	}
+
+	summary_db->save (s(pm->args_info->summary_db_arg));
+}
+
 void
 Whole_program::merge_contexts ()
 {
@@ -2431,8 +2520,11 @@ Whole_program::refer_to_value (Context* cx, const Index_node* lhs, const Index_n
 	// Note that we aren't required to do unification, even though the
 	// edges are bidirectional. It may be that A may-ref B and A may-ref
 	// C, but B does not may-ref C. An example is after CFG merges.
-	foreach (const Reference* ref, *aliasing->get_references (cx, R_WORKING, rhs, PTG_ALL))
-		FWPA->create_reference (cx, lhs, ref->index, combine_certs (cert, ref->cert));
+	if (!unification->is_unaliased (cx, rhs))
+	{
+		foreach (const Reference* ref, *aliasing->get_references (cx, R_WORKING, rhs, PTG_ALL))
+			FWPA->create_reference (cx, lhs, ref->index, combine_certs (cert, ref->cert));
+	}
 
 
 	// Create the reference
@@ -2577,6 +2669,18 @@ Whole_program::assign_path_scalar (Context* cx, Path* plhs, const Literal* lit,
 	assign_path_scalar (cx, plhs, new Abstract_value (lit), allow_kill);
 }
 
+/*
+ * Assign a value described by a builtin's model.
+ */
+void
+Whole_program::assign_path_modelled (Context* cx, Path* plhs, const Value_model* model)
+{
+	if (model->is_array)
+		assign_path_typed_array (cx, plhs, model->types->clone (), ANON);
+	else
+		assign_path_typed (cx, plhs, model->types->clone ());
+}
+
 void
 Whole_program::assign_path_typed (Context* cx, Path* plhs, const Types* types, bool allow_kill)
 {
@@ -3256,7 +3360,13 @@ Whole_program::get_string_value (Context* cx, Result_state state, const Index_no
 const Abstract_value*
 Whole_program::get_abstract_value (Context* cx, Result_state state, const Alias_name* name)
 {
-	return values->get_value (cx, state, name)->value;
+	const Abstract_value* absval = values->get_value (cx, state, name)->value;
+
+	// Carry the range of ints along with the value.
+	if (absval->lit == NULL && absval->types && absval->types->has ("int"))
+		return new Abstract_value (absval->types, vrp->get_value (cx, state, name));
+
+	return absval;
 }
 
 /*
@@ -3530,7 +3640,16 @@ Whole_program::get_lhs_references (Context* cx, Path* path)
 	bool killable = is_killable (cx, lhss);
 	foreach (const Index_node* lhs, *lhss)
 	{
-		cReference_list* initial_refs = aliasing->get_references (cx, R_WORKING, lhs, PTG_ALL);
+		// Unaliased variables only refer to themselves.
+		cReference_list* initial_refs;
+		if (unification->is_unaliased (cx, lhs))
+		{
+			CTS ("reference_lookups_skipped");
+			initial_refs = new cReference_list;
+		}
+		else
+			initial_refs = aliasing->get_references (cx, R_WORKING, lhs, PTG_ALL);
+
 		initial_refs->push_back (new Reference (lhs, DEFINITE));
 
 		// references are immutable
@@ -3720,9 +3839,18 @@ Whole_program::visit_pre_op (Statement_block* bb, Pre_op* in)
 		return;
 	}
 
-	// Maybe we know the type?
+	// Maybe we know the type? ints may overflow into reals.
+	const Abstract_value* operand = get_abstract_value (block_cx (), R_WORKING, n);
 	const Types* types = values->get_types (block_cx (), R_WORKING, n);
-	assign_path_typed (block_cx (), path, types);
+	if (types->has ("int") && !VRP::cannot_overflow (operand, *in->op->value))
+	{
+		Types* overflowed = types->clone ();
+		overflowed->insert ("real");
+		types = overflowed;
+	}
+
+	assign_path_scalar (block_cx (), path,
+		new Abstract_value (types, VRP::get_pre_op_range (operand, *in->op->value)));
 }
 
 
@@ -3898,8 +4026,15 @@ Whole_program::visit_bin_op (Statement_block* bb, MIR::Bin_op* in)
 		record_use (block_cx (), VN (ns, dyc<VARIABLE_NAME> (in->right)));
 
 
-	Types* types = values->get_bin_op_types (block_cx (), left, right, *in->op->value);
-	assign_path_typed (block_cx (), saved_plhs (), types);
+	string op = *in->op->value;
+	Types* types = values->get_bin_op_types (block_cx (), left, right, op);
+
+	// Integer arithmetic which provably fits in a long stays an int.
+	if (VRP::cannot_overflow (left, right, op))
+		types = new Types ("int");
+
+	assign_path_scalar (block_cx (), saved_plhs (),
+		new Abstract_value (types, VRP::get_bin_op_range (left, right, op)));
 }
 
 void
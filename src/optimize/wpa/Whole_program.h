@@ -37,7 +37,10 @@
 #ifndef PHC_WHOLE_PROGRAM
 #define PHC_WHOLE_PROGRAM
 
+#include <ctime>
+
 #include "lib/Map.h"
+#include "lib/Set.h"
 #include "WPA.h"
 
 DECL(Method_info);
@@ -58,10 +61,13 @@ class VRP;
 class Optimization_transformer;
 class Optimization_annotator;
 class Stat_collector;
+class Summary_db;
+class Unification_analysis;
 class Pass_manager;
 class Path;
 class WPA;
 class Absval_cell;
+class Value_model;
 
 /*
  * Intended to be used as FWPA->whatever ();
@@ -87,6 +93,28 @@ public:
 	Optimization_annotator* annotator;
 	Stat_collector* stat_coll;
 
+	// Function summaries saved by previous compilations (NULL unless
+	// --summary-db is given).
+	Summary_db* summary_db;
+	String* main_filename;
+
+	/*
+	 * Adaptive context-sensitivity. Methods with too many call-sites, too
+	 * many blocks, or which exceed their analysis budget are collapsed (see
+	 * Context::collapse).
+	 */
+
+	// The call-sites of each method in this iteration.
+	Map<string, Set<string> > call_sites;
+
+	// Resources used by the callees of the function being analysed, so that
+	// each function is only charged for its own analysis.
+	clock_t callee_time;
+	long callee_heap;
+
+	// Visits to each loop header in this iteration, for widening.
+	CX_map<int> header_visits;
+
 	// Analyses should be able to reach in here to get other analyses'
 	// results.
 	Aliasing* aliasing;
@@ -94,6 +122,10 @@ public:
 	Constant_state* constants;
 	Def_use* def_use;
 	Value_analysis* values;
+	VRP* vrp;
+
+	// Pre-analysis, rerun each iteration.
+	Unification_analysis* unification;
 
 	// name of __MAIN__ scope
 	string main_scope;
@@ -191,6 +223,19 @@ public:
 	void collect_stats (User_method_info* info);
 	void collect_preliminary_stats (User_method_info* info);
 	void strip (MIR::PHP_script* in);
+	void save_summaries ();
+
+	/*
+	 * Function specialization. Each clone is keyed by the callee and the
+	 * constant arguments it was specialized for.
+	 */
+	Map<string, String*> specializations;
+	Map<string, int> num_specializations;
+
+	bool specialize (MIR::PHP_script* in);
+	String* get_specialization (MIR::PHP_script* in,
+										 User_method_info* info,
+										 MIR::Actual_parameter_list* actuals);
 
 
 	// Apply the interprocedural optimization results to this BB.
@@ -204,6 +249,9 @@ public:
 								  MIR::Actual_parameter_list*,
 								  MIR::VARIABLE_NAME* lhs);
 
+	void apply_context_policy (User_method_info* info, Context* caller_cx);
+	bool check_budget (User_method_info* info, clock_t start_time, long start_heap);
+
 	void analyse_summary (Summary_method_info* info,
 								 Context* caller_cx,
 							    MIR::Actual_parameter_list*,
@@ -241,6 +289,7 @@ public:
 	void assign_path_static_array (Context* cx, Path* plhs, MIR::Static_array* array, bool allow_kill = true);
 	void assign_path_unknown (Context* cx, Path* lhs, bool allow_kill = true);
 	void assign_path_typed (Context* cx, Path* lhs, const Types* types, bool allow_kill = true);
+	void assign_path_modelled (Context* cx, Path* lhs, const Value_model* model);
 	void assign_path_by_ref (Context* cx, Path* lhs, Path* rhs, bool allow_kill = true);
 	void assign_path_by_copy (Context* cx, Path* lhs, Path* rhs, bool allow_kill = true);
 	void assign_path_by_cast (Context* cx, Path* lhs, Path* rhs, string type, bool allow_kill = true);
@@ -350,19 +399,6 @@ public:
 
 private:
 	int iteration_num;
-
-private:
-	/*
-	 * Model straightforward functions
-	 */
-	Set<string> modelled_functions;
-	Map<string, List<int> > coercion_model;
-	Map<string, Types*> type_model;
-
-	/*
-	 * Initial population of modelled functions.
-	 */
-	void populate_modelled_functions();
 };
 
 
@@ -215,7 +215,8 @@ struct MICG_grammar : public grammar<MICG_grammar>
 			lookup = param_name >> NO(".") >> attr_name;
 			attr_name_list = *(NO("#") >> attr_name);
 			param = param_name >> attr_name_list;
-			expr = param | quoted_string | lookup | macro_call | callback ;
+			// Try lookup first, or param would match the parameter name alone.
+			expr = lookup | param | quoted_string | macro_call | callback ;
 			equals = expr >> WSC >> NO("==") >> WSC >> expr;
 			_rule = NO("where") >> WSC >> (equals | lookup) >> WSC;
 			_rule_list = *_rule;
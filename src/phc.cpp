@@ -39,6 +39,7 @@
 #include "optimize/Def_use_web.h"
 #include "optimize/If_simplification.h"
 #include "optimize/Inlining.h"
+#include "optimize/Liveness.h"
 #include "optimize/Mark_initialized.h"
 #include "optimize/Misc_annotations.h"
 #include "optimize/Prune_symbol_table.h"
@@ -159,7 +160,7 @@ int main(int argc, char** argv)
 	pm->add_ast_transform (new Desugar (), s("desug"), s("Canonicalize simple constructs"));
 	pm->add_ast_transform (new Split_multiple_arguments (), s("sma"), s("Split multiple arguments for globals, attributes and static declarations"));
 	pm->add_ast_transform (new Split_unset_isset (), s("sui"), s("Split unset() and isset() into multiple calls with one argument each"));
-	pm->add_ast_transform (new Echo_split (), s("ecs"), s("Split echo() into multiple calls with one argument each"));
+	pm->add_ast_transform (new Echo_split (), s("ecs"), s("Split echo() into multiple calls with one argument each, and merge literal prints"));
 
 	pm->add_ast_transform (new Early_lower_control_flow (), s("elcf"), s("Early Lower Control Flow - lower for, while, do and switch statements")); // AST
 	pm->add_ast_transform (new Lower_expr_flow (), s("lef"), s("Lower Expression Flow - Lower ||, && and ?: expressions"));
@@ -199,6 +200,7 @@ int main(int argc, char** argv)
 	pm->add_local_optimization (new Remove_loop_booleans (), s("rlb"), s("Remove loop-booleans"), false);
 
 	pm->add_ipa_optimization (new Inlining (), s("inlining"), s("Method inlining"), false);
+	pm->add_ipa_optimization (new Liveness (), s("liveness"), s("Mark last uses of locals"), false);
 
 	// TODO: we could consider this for resolving isset/empty/unset queries
 	// TODO: I think these should mostly move to WPA
@@ -121,6 +121,7 @@ $tests[] = new BasicIgnoreOutputTest ("FastOptimize", "$opt $fast $stats", "Basi
 
 $tests[] = new CompareWithPHP ("InterpretOptimized", "$opt --dump=codegen --convert-uppered", "BasicPreciseOptimizeTest");
 require_once ("compile_optimized.php");
+require_once ("compile_unboxed.php");
 
 
 require_once ("refcounts.php");
@@ -20,6 +20,7 @@
 			"CompiledVsInterpreted",
 			"CompileOptimized",
 			"RaisedCompileOptimized",
+			"CompileUnboxed",
 			"Refcounts",
 			"Demi_eval_false",
 			"Demi_eval_true",
@@ -0,0 +1,12 @@
+<?php
+	// Index an array with a resource, which is converted to a string key.
+	$n = getenv ("ALLOC_ITERATIONS");
+	$fp = fopen (__FILE__, "r");
+	$arr = array ();
+
+	for ($i = 0; $i < $n; $i++)
+	{
+		$arr[$fp] = $i;
+		$x = $arr[$fp];
+	}
+?>
@@ -0,0 +1,10 @@
+<?php
+	// Read single characters out of a string.
+	$n = getenv ("ALLOC_ITERATIONS");
+	$str = "abcdefghij";
+
+	for ($i = 0; $i < $n; $i++)
+	{
+		$c = $str[$i % 10];
+	}
+?>
@@ -0,0 +1,11 @@
+<?php
+	// Write numbers into a string, which converts them.
+	$n = getenv ("ALLOC_ITERATIONS");
+	$str = "abcdefghij";
+
+	for ($i = 0; $i < $n; $i++)
+	{
+		$str[3] = $i;
+		$str[4] = 1.5;
+	}
+?>
@@ -0,0 +1,11 @@
+<?php
+	// Variable-variables named by numbers.
+	$n = getenv ("ALLOC_ITERATIONS");
+	$name = 5;
+
+	for ($i = 0; $i < $n; $i++)
+	{
+		$$name = $i;
+		$x = $$name;
+	}
+?>
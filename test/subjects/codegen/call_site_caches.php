@@ -0,0 +1,52 @@
+<?php
+
+	// Dynamic call sites cache the functions and methods they find. Check
+	// that they notice when the function or the receiver's class changes.
+
+	function first ($x) { return "first $x"; }
+	function second ($x) { return "second $x"; }
+	function by_ref (&$x) { $x++; }
+
+	class A
+	{
+		function who () { return "A"; }
+	}
+
+	class B extends A
+	{
+		function who () { return "B"; }
+	}
+
+	class C
+	{
+		function who () { return "C"; }
+	}
+
+	// Variable functions, including names differing only in case
+	$names = array ("first", "first", "second", "FIRST", "strtoupper", "first");
+	foreach ($names as $name)
+		var_dump ($name ("call"));
+
+	// Parameters by reference through a variable function
+	$f = "by_ref";
+	$i = 5;
+	$f ($i);
+	$f ($i);
+	var_dump ($i);
+
+	// More classes at one site than fit in its cache
+	$objects = array (new A, new B, new C, new A, new B, new C);
+	foreach ($objects as $obj)
+		var_dump ($obj->who ());
+
+	// Recursion through a variable function
+	function countdown ($n)
+	{
+		$f = "countdown";
+		if ($n > 0)
+			return $n + $f ($n - 1);
+		return 0;
+	}
+	var_dump (countdown (5));
+
+?>
@@ -0,0 +1,42 @@
+<?php
+
+	// String literals used as array keys are hashed when the script is
+	// compiled. Check that keys which PHP treats as integers still are.
+
+	$arr = array ();
+	$arr["name"] = "phc";
+	$arr["12"] = "twelve";
+	$arr["-7"] = "minus seven";
+	$arr["007"] = "string";
+	$arr["-0"] = "string";
+	$arr[""] = "empty";
+	$arr["12345678901234567890"] = "too long";
+	$arr["1.5"] = "string";
+	var_dump ($arr);
+
+	var_dump ($arr["name"], $arr[12], $arr["12"], $arr[-7]);
+	var_dump ($arr["missing"], $arr["0"]);
+
+	$ref =& $arr["name"];
+	$ref = "compiler";
+	$arr2["new"] =& $ref;
+	var_dump ($arr, $arr2);
+
+	// Not arrays
+	$str = "string";
+	var_dump ($str["1"]);
+	$null = NULL;
+	$null["key"] = 5;
+	var_dump ($null);
+
+	function lookup ($table)
+	{
+		$total = 0;
+		for ($i = 0; $i < 10; $i++)
+			$total += $table["count"] + $table["5"];
+		return $total;
+	}
+
+	var_dump (lookup (array ("count" => 3, 5 => 2)));
+
+?>
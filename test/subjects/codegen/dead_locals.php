@@ -0,0 +1,77 @@
+<?php
+
+	// Locals which are not used again may be released before the function
+	// returns. Check that this is not visible.
+
+	class D
+	{
+		function __construct ($name) { $this->name = $name; }
+		function __destruct () { echo "destroying {$this->name}\n"; }
+	}
+
+	function arrays ($n)
+	{
+		$big = array ();
+		for ($i = 0; $i < $n; $i++)
+			$big[] = str_repeat ("x", $i);
+
+		$count = count ($big);
+		$str = str_repeat ("y", $n);
+		$len = strlen ($str);
+
+		return $count + $len;
+	}
+
+	function objects ()
+	{
+		// Destructors must run at the end of the function, as usual
+		$d = new D ("d");
+		$name = $d->name;
+		echo "end of objects ($name)\n";
+	}
+
+	function held_objects ()
+	{
+		// The array holds the last reference to the object
+		$list = array ();
+		$list[] = new D ("in array");
+		$n = count ($list);
+		echo "end of held_objects ($n)\n";
+	}
+
+	function references ()
+	{
+		$a = array (1, 2, 3);
+		$r =& $a;
+		$b = count ($a);
+
+		// $a is dead, but $r still sees it
+		$r[] = $b;
+		var_dump ($r);
+
+		$x = 5;
+		$y =& $x;
+		$x = 6;
+		var_dump ($y);
+	}
+
+	function loop ()
+	{
+		$total = 0;
+		for ($i = 0; $i < 5; $i++)
+		{
+			$s = "item $i";
+			$total += strlen ($s);
+		}
+		return $total;
+	}
+
+	var_dump (arrays (10));
+	objects ();
+	echo "after objects\n";
+	held_objects ();
+	echo "after held_objects\n";
+	references ();
+	var_dump (loop ());
+
+?>
@@ -0,0 +1,54 @@
+<?php
+
+	// Method calls on receivers of known classes cache the method they find
+	// for each class. Check that each class still gets its own method.
+
+	class Shape
+	{
+		function area () { return 0; }
+		function name () { return "shape"; }
+	}
+
+	class Square extends Shape
+	{
+		var $side;
+		function __construct ($side) { $this->side = $side; }
+		function area () { return $this->side * $this->side; }
+	}
+
+	class Circle extends Shape
+	{
+		var $r;
+		function __construct ($r) { $this->r = $r; }
+		function area () { return 3 * $this->r * $this->r; }
+		function name () { return "circle"; }
+	}
+
+	class Magic
+	{
+		function __call ($name, $args) { return "magic $name"; }
+	}
+
+	// A single class
+	$s = new Square (3);
+	for ($i = 0; $i < 3; $i++)
+		var_dump ($s->area ());
+
+	// Several classes at one call site
+	$shapes = array (new Square (2), new Circle (1), new Shape, new Circle (2));
+	foreach ($shapes as $shape)
+	{
+		if ($shape instanceof Circle)
+			$x = new Circle ($shape->r);
+		else
+			$x = new Square (1);
+
+		var_dump ($x->name (), $x->area ());
+	}
+
+	// Methods found through __call are not cached
+	$m = new Magic;
+	for ($i = 0; $i < 2; $i++)
+		var_dump ($m->foo ());
+
+?>
@@ -0,0 +1,107 @@
+<?php
+
+	// Compiled functions call each other directly. Check that parameters,
+	// defaults, references and scope behave as they would through the
+	// engine.
+
+	var_dump (fib (15));
+
+	function fib ($n)
+	{
+		if ($n < 2)
+			return $n;
+
+		return fib ($n - 1) + FIB ($n - 2);
+	}
+
+	function defaults ($a, $b = 10, $c = "c")
+	{
+		var_dump ($a, $b, $c);
+	}
+
+	defaults (1);
+	defaults (1, 2);
+	defaults (1, 2, 3);
+	defaults (1, 2, 3, 4);
+
+	function increment (&$x)
+	{
+		$x++;
+	}
+
+	$i = 0;
+	increment ($i);
+	increment ($i);
+	$j = $i;
+	increment ($i);
+	var_dump ($i, $j);
+
+	$arr = array (5);
+	increment ($arr[0]);
+	var_dump ($arr);
+
+	// Uses the call frame, so is not called directly
+	function count_args ()
+	{
+		return func_num_args ();
+	}
+	var_dump (count_args (1, 2, 3));
+
+	// Functions don't run in the scope of the method calling them.
+	class Secret
+	{
+		private $value = "hidden";
+
+		function peek ()
+		{
+			return peek_at ($this);
+		}
+	}
+
+	function peek_at ($obj)
+	{
+		return isset ($obj->value);
+	}
+
+	$secret = new Secret;
+	var_dump ($secret->peek ());
+
+	// Direct calls still appear in backtraces and in the traces of exceptions.
+	function trace ()
+	{
+		$names = array ();
+		foreach (debug_backtrace () as $frame)
+			$names[] = $frame["function"];
+		return $names;
+	}
+
+	function traced ($x)
+	{
+		return trace ();
+	}
+	var_dump (traced (1));
+
+	function thrower ()
+	{
+		throw new Exception ("thrown");
+	}
+
+	function rethrower ()
+	{
+		thrower ();
+	}
+
+	try
+	{
+		rethrower ();
+	}
+	catch (Exception $e)
+	{
+		foreach ($e->getTrace () as $frame)
+			var_dump ($frame["function"]);
+	}
+
+	// Called through the engine
+	var_dump (array_map ("fib", array (1, 2, 3, 4, 5)));
+
+?>
@@ -0,0 +1,32 @@
+<?php
+
+	// Warnings raised by functions report the line of the call which raised
+	// them, with or without a user error handler.
+
+	function warn ($i)
+	{
+		return str_repeat ("x", $i);
+	}
+
+	for ($i = 1; $i > -3; $i--)
+		var_dump (warn ($i));
+
+	$arr = array (1, 2);
+	var_dump (array_combine ($arr, array (1)));
+
+	function handler ($errno, $errstr, $errfile, $errline)
+	{
+		echo "handled: $errstr on line $errline\n";
+		return true;
+	}
+
+	set_error_handler ("handler");
+
+	var_dump (warn (-1));
+	var_dump (array_combine ($arr, array (1)));
+
+	restore_error_handler ();
+
+	var_dump (warn (-2));
+
+?>
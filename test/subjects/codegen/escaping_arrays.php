@@ -0,0 +1,71 @@
+<?php
+
+	// Arrays which don't escape their function are allocated at their final
+	// size. Check arrays which do and don't escape, by return value, by
+	// reference, through globals and through other arrays and objects.
+
+	class Box
+	{
+		var $contents;
+	}
+
+	function local_only ()
+	{
+		$a = array ();
+		for ($i = 0; $i < 20; $i++)
+			$a[] = $i * $i;
+
+		$b = array ();
+		$b["x"] = 1; $b["y"] = 2; $b["z"] = 3; $b["w"] = 4; $b["v"] = 5;
+		$b["u"] = 6; $b["t"] = 7; $b["s"] = 8; $b["r"] = 9; $b["q"] = 10;
+		return count ($a) + array_sum ($b);
+	}
+
+	function returned ()
+	{
+		$a = array ();
+		$a[] = 5;
+		return $a;
+	}
+
+	function through_global ()
+	{
+		global $g;
+		$a = array ();
+		$a[] = 6;
+		$g = $a;
+	}
+
+	function by_reference (&$out)
+	{
+		$a = array ();
+		$a[] = 7;
+		$out = &$a;
+	}
+
+	function through_object ($box)
+	{
+		$a = array ();
+		$a[] = 8;
+		$box->contents = $a;
+	}
+
+	function local_object ()
+	{
+		$box = new Box ();
+		$box->contents = 9;
+		return $box->contents;
+	}
+
+	var_dump (local_only ());
+	var_dump (returned ());
+	through_global ();
+	var_dump ($g);
+	by_reference ($r);
+	var_dump ($r);
+	$box = new Box ();
+	through_object ($box);
+	var_dump ($box);
+	var_dump (local_object ());
+
+?>
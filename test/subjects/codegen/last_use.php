@@ -0,0 +1,69 @@
+<?php
+
+	// Locals which are not used again may have their values moved rather
+	// than shared. Check that the values stay correct.
+
+	function build ($n)
+	{
+		$a = array ();
+		for ($i = 0; $i < $n; $i++)
+			$a[] = $i;
+
+		// $a is not used after this
+		$b = $a;
+		$b[] = "last";
+		return $b;
+	}
+
+	function shared ()
+	{
+		$a = array (1, 2, 3);
+		$c = $a;
+
+		// $a still shares its value with $c
+		$b = $a;
+		$b[] = 4;
+		var_dump ($a, $b, $c);
+	}
+
+	function refs ()
+	{
+		$a = "string";
+		$r =& $a;
+
+		// $a is a reference, so it can't be moved
+		$b = $a;
+		$r = "changed";
+		var_dump ($a, $b, $r);
+	}
+
+	function loop ()
+	{
+		$x = "";
+		for ($i = 0; $i < 3; $i++)
+		{
+			$y = $x;
+			$y .= $i;
+
+			// $x is used again in the next iteration
+			$x = $y;
+		}
+		return $x;
+	}
+
+	function objects ()
+	{
+		$o = new stdClass ();
+		$o->field = 5;
+		$p = $o;
+		$p->field = 6;
+		return $p;
+	}
+
+	var_dump (build (5));
+	shared ();
+	refs ();
+	var_dump (loop ());
+	var_dump (objects ());
+
+?>
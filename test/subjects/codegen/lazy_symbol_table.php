@@ -0,0 +1,73 @@
+<?php
+
+	// Functions which use their symbol table in only a few statements build
+	// it when those statements run. Check that the locals are seen, and
+	// updated, by those statements.
+
+	function with_compact ($a, $b)
+	{
+		$sum = $a + $b;
+		if ($sum > 100)
+			return compact ("a", "b", "sum");
+
+		$sum = $sum * 2;
+		return $sum;
+	}
+
+	var_dump (with_compact (1, 2));
+	var_dump (with_compact (100, 2));
+
+	function with_extract ($arr)
+	{
+		$x = "old x";
+		$y = "old y";
+		extract ($arr);
+		var_dump ($x, $y);
+
+		$x = "new x";
+		var_dump (compact ("x", "y", "z"));
+	}
+
+	with_extract (array ("x" => 1, "z" => 3));
+
+	function with_var_vars ($name)
+	{
+		$first = 1;
+		$second = 2;
+		$$name = 10;
+		var_dump ($first, $second);
+
+		$ref = &$$name;
+		$ref++;
+		var_dump ($first, $second);
+
+		unset ($$name);
+		var_dump (isset ($first), isset ($second));
+	}
+
+	with_var_vars ("first");
+	with_var_vars ("second");
+
+	function defined_vars ()
+	{
+		$p = 1;
+		$q = array (2);
+		$unset = 3;
+		unset ($unset);
+		return get_defined_vars ();
+	}
+
+	var_dump (defined_vars ());
+
+	// Recursion creates a separate symbol table each time
+	function recurse ($n)
+	{
+		$name = "n";
+		if ($n > 0)
+			recurse ($n - 1);
+		echo $$name, "\n";
+	}
+
+	recurse (3);
+
+?>
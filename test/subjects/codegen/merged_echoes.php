@@ -0,0 +1,44 @@
+<p>Inline text is merged with the echoes around it.</p>
+<?php
+
+	// Adjacent prints of literals are merged, and output is buffered. Check
+	// that the output still comes out in order.
+
+	echo "a", "b", 5, "c";
+	echo "";
+	print "d";
+	echo -1, "\n";
+
+	function f ($x)
+	{
+		echo "f", "(";
+		echo $x;
+		echo ")", "\n";
+		return $x;
+	}
+
+	echo "<", f (7), ">\n";
+
+	for ($i = 0; $i < 3; $i++)
+	{
+		echo "i = ";
+		echo $i;
+		echo "\n";
+	}
+
+	// Bigger than half the buffer, so it is written directly
+	echo "short\n";
+	echo str_repeat ("long", 10000), "\n";
+	echo "after long\n";
+
+	echo "before flush\n";
+	flush ();
+	echo "after flush\n";
+
+	printf ("%s %d\n", "printf", 1);
+	echo "then echo\n";
+	var_dump (array (1, "x"));
+	echo "done\n";
+
+?>
+<p>Trailing text</p>
@@ -0,0 +1,100 @@
+<?php
+
+	// Local lists may be kept in vectors. Check that they behave as arrays,
+	// including when they stop being lists.
+
+	function squares ($n)
+	{
+		$a = array ();
+		for ($i = 0; $i < $n; $i++)
+			$a[] = $i * $i;
+
+		$sum = 0;
+		for ($i = 0; $i < count ($a); $i++)
+			$sum = $sum + $a[$i];
+
+		// Past the end
+		var_dump (@$a[$n]);
+		return $sum;
+	}
+
+	function overwrite ()
+	{
+		$a = array ();
+		$a[] = "x";
+		$a[] = "y";
+		$a[1] = "z";
+		$a[2] = "w";
+
+		// Copies are separated when written
+		$b = $a;
+		$b[0] = "v";
+		$b[] = "u";
+		var_dump ($a, $b);
+	}
+
+	function iterate ()
+	{
+		$a = array ();
+		for ($i = 0; $i < 5; $i++)
+			$a[] = $i + 0.5;
+
+		foreach ($a as $k => $v)
+		{
+			// Changes the array, but not the copy we iterate over
+			$a[] = $v;
+			echo "$k: $v\n";
+		}
+
+		foreach ($a as $v)
+		{
+			// Converts the array, but not the copy
+			$a["last"] = $v;
+			echo "$v\n";
+		}
+
+		// Converted as the loop starts
+		foreach ($a as &$v)
+			$v = $v * 2;
+
+		var_dump ($a);
+	}
+
+	function not_a_list ()
+	{
+		$a = array ();
+		$a[] = 1;
+		$a[5] = 2;
+		$a[] = 3;
+		$a["key"] = 4;
+		$a[-1] = 5;
+		var_dump ($a, is_array ($a), count ($a));
+
+		$b = array ();
+		$b[] = 1;
+		unset ($b);
+		$b[] = 2;
+		var_dump ($b);
+	}
+
+	function nested ()
+	{
+		$rows = array ();
+		for ($i = 0; $i < 3; $i++)
+		{
+			$row = array ();
+			for ($j = 0; $j < 3; $j++)
+				$row[] = $i * 3 + $j;
+			$rows[] = $row;
+		}
+
+		return $rows;
+	}
+
+	var_dump (squares (10));
+	overwrite ();
+	iterate ();
+	not_a_list ();
+	var_dump (nested ());
+
+?>
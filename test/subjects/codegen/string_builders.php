@@ -0,0 +1,80 @@
+<?php
+
+	// Locals which are appended to may be built in a string builder. Check
+	// that they behave as strings whenever they are used.
+
+	class S
+	{
+		function __toString () { return "object"; }
+	}
+
+	function csv ($rows)
+	{
+		$out = "";
+		foreach ($rows as $row)
+		{
+			$out .= implode (",", $row);
+			$out .= "\n";
+		}
+		return $out;
+	}
+
+	function interleaved ()
+	{
+		$s = "start";
+		for ($i = 0; $i < 5; $i++)
+		{
+			$s .= $i;
+			$s .= 0.5;
+			$s .= true;
+			$s .= null;
+			$s .= new S ();
+
+			// Uses the string between appends
+			echo strlen ($s), ": ", $s, "\n";
+		}
+
+		// A copy doesnt see later appends
+		$t = $s;
+		$s .= "more";
+		var_dump ($s, $t);
+	}
+
+	function not_a_string ()
+	{
+		$a = 5;
+		$a .= 6;
+		var_dump ($a);
+
+		$b = array ();
+		$b .= "x";
+		var_dump ($b);
+
+		$c .= "undefined";
+		var_dump ($c);
+	}
+
+	function references ()
+	{
+		$s = "a";
+		$r =& $s;
+		for ($i = 0; $i < 3; $i++)
+			$s .= "b";
+		var_dump ($r);
+	}
+
+	function self_append ()
+	{
+		$s = "ab";
+		for ($i = 0; $i < 3; $i++)
+			$s .= $s;
+		var_dump ($s);
+	}
+
+	echo csv (array (array (1, 2, 3), array ("a", "b", "c")));
+	interleaved ();
+	not_a_string ();
+	references ();
+	self_append ();
+
+?>
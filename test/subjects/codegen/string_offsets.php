@@ -0,0 +1,49 @@
+<?php
+
+	// String offsets are read into shared one-character strings, and
+	// written by converting the RHS without allocating.
+
+	$str = "abcdef";
+	$c = $str[2];
+	$d = $str[2];
+	$c .= "x";
+	var_dump ($c, $d, $str[10], $str[-1], $str);
+
+	class Obj
+	{
+		function __toString ()
+		{
+			return "object";
+		}
+	}
+
+	$values = array (5, -5, 0, 1.5, -0.25, 1e30, true, false, NULL, "zz", "", new Obj);
+	foreach ($values as $value)
+	{
+		$str = "abcdef";
+		$str[1] = $value;
+		var_dump ($str);
+	}
+
+	// Written past the end
+	$str = "ab";
+	$str[5] = 9;
+	var_dump ($str);
+
+	// Non-scalar indices are converted to strings
+	$fp = fopen (__FILE__, "r");
+	$arr = array ();
+	$arr[$fp] = "resource";
+	var_dump ($arr[$fp], isset ($arr[$fp]));
+	unset ($arr[$fp]);
+	var_dump ($arr);
+
+	// Variable-variables named by numbers
+	$name = 5;
+	$$name = "five";
+	var_dump ($$name);
+	$name = 2.5;
+	$$name = "two and a half";
+	var_dump (${"2.5"});
+
+?>
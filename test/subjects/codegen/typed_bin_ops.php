@@ -0,0 +1,51 @@
+<?php
+
+	// Bin-ops on operands of known types use specialized code. Check that
+	// they give the same results as the generic operators.
+
+	function ints ()
+	{
+		$a = 7;
+		$b = -3;
+		var_dump ($a + $b, $a - $b, $a * $b);
+		var_dump ($a < $b, $a <= $b, $a == $b, $a != $b);
+		var_dump ($a === $b, $a !== $b);
+		var_dump ($a / $b, $a % $b);
+
+		// Overflows into a double
+		$max = PHP_INT_MAX;
+		$min = -PHP_INT_MAX - 1;
+		var_dump ($max + 1, $min - 1, $max * 2, $min * -1);
+	}
+
+	function reals ()
+	{
+		$x = 2.5;
+		$y = 4;
+		var_dump ($x + $y, $x - $y, $x * $y, $y - $x);
+		var_dump ($x < $y, $y <= $x, $x == 2.5, $x != $y);
+		var_dump ($x === 2.5, $x !== 2.5);
+
+		$nan = acos (8);
+		var_dump ($nan == 1.0, $nan < 1.0);
+	}
+
+	function strings ()
+	{
+		$s = "foo";
+		$t = "bar";
+		$u = $s . $t;
+		$u = $u . $u;
+		var_dump ($u, $s . "", "" . $t);
+
+		// Numeric strings still compare numerically
+		$n = "10";
+		$m = "1e1";
+		var_dump ($n == $m, $n === $m);
+	}
+
+	ints ();
+	reals ();
+	strings ();
+
+?>
@@ -0,0 +1,70 @@
+<?php
+
+	// Locals whose types are known are kept in C variables. Check that they
+	// are boxed whenever their zvals are needed.
+
+	function count_to ($n)
+	{
+		$sum = 0;
+		for ($i = 0; $i < 1000; $i++)
+		{
+			$sum = $sum + $i;
+			if ($i == $n)
+				break;
+		}
+
+		// Passed to a builtin and to a user function
+		var_dump ($i);
+		echo $sum, "\n";
+		return $sum;
+	}
+
+	function halves ()
+	{
+		$x = 1.0;
+		$steps = 0;
+		while ($x > 0.001)
+		{
+			$x = $x * 0.5;
+			++$steps;
+		}
+
+		$result = array ($x, $steps);
+		return $result;
+	}
+
+	function flags ()
+	{
+		$a = 7;
+		$b = 9;
+		$less = $a < $b;
+		$same = $a === $b;
+		$not = !$less;
+		if ($not)
+			echo "wrong\n";
+
+		var_dump ($less, $same, $not);
+
+		// Stored in an array, then changed
+		$arr = array ();
+		$arr[] = $a;
+		$a = $a & 3;
+		var_dump ($arr, $a);
+	}
+
+	function overflow ()
+	{
+		$big = PHP_INT_MAX - 2;
+		for ($j = 0; $j < 5; $j++)
+			$big = $big + 1;
+
+		return $big;
+	}
+
+	var_dump (count_to (10));
+	var_dump (count_to (5000));
+	var_dump (halves ());
+	flags ();
+	var_dump (overflow ());
+
+?>
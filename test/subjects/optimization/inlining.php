@@ -0,0 +1,53 @@
+<?php
+
+	// Small functions are inlined. Check parameter binding, references,
+	// defaults, and that the inlined locals start fresh each time.
+
+	function add ($a, $b)
+	{
+		$c = $a + $b;
+		return $c;
+	}
+
+	function inc (&$x, $by = 1)
+	{
+		$x = $x + $by;
+	}
+
+	function collect ($v)
+	{
+		$list[] = $v;
+		return $list;
+	}
+
+	function nothing ()
+	{
+	}
+
+	function loop ()
+	{
+		$sum = 0;
+		for ($i = 0; $i < 10; $i++)
+		{
+			$sum = add ($sum, $i);
+			inc ($sum);
+			inc ($sum, 2);
+			$l = collect ($i);
+		}
+		var_dump ($sum, $l);
+
+		$n = nothing ();
+		var_dump ($n);
+
+		// Recursion is not inlined.
+		var_dump (fact (5));
+	}
+
+	function fact ($n)
+	{
+		return $n <= 1 ? 1 : $n * fact ($n - 1);
+	}
+
+	loop ();
+
+?>
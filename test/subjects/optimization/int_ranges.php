@@ -0,0 +1,54 @@
+<?php
+
+	// Integer arithmetic is only kept as an int when its range is known to
+	// fit. Check that results near the limits still overflow into floats.
+
+	function add ($a, $b)
+	{
+		return $a + $b;
+	}
+
+	// Loop counters are bounded by the loop condition.
+	$sum = 0;
+	for ($i = 0; $i < 100; $i++)
+		$sum = $sum + $i * 2;
+	var_dump ($i, $sum);
+
+	for ($j = 10; $j > 0; $j--)
+		;
+	var_dump ($j);
+
+	// Unbounded loops must not be assumed to stay ints.
+	$x = 1;
+	while ($x > 0 && $x < PHP_INT_MAX / 2)
+		$x = $x * 3;
+	var_dump ($x);
+
+	$big = PHP_INT_MAX - 1;
+	$big++;
+	var_dump ($big);
+	$big++;
+	var_dump ($big);
+
+	$small = -PHP_INT_MAX;
+	$small--;
+	var_dump ($small);
+	$small--;
+	var_dump ($small);
+
+	// Ranges are bound to parameters.
+	var_dump (add (1, 2));
+	var_dump (add (PHP_INT_MAX, 1));
+	var_dump (add (-PHP_INT_MAX - 1, -1));
+
+	var_dump (17 % 5, -17 % 5, 6 & 3);
+	var_dump (PHP_INT_MAX * 2);
+
+	// Equality narrows both sides.
+	$k = 5;
+	if ($k == 5)
+		var_dump ($k + 1);
+	else
+		var_dump ($k - 1);
+
+?>
@@ -0,0 +1,66 @@
+<?php
+
+	// Functions called with constant arguments are specialized. Check that
+	// the clones and the original behave the same.
+
+	function format ($value, $mode, $width = 8)
+	{
+		if ($mode == "hex")
+			$result = dechex ($value);
+		else if ($mode == "oct")
+			$result = decoct ($value);
+		else
+			$result = (string) $value;
+
+		if ($mode == "hex" || $width > 10)
+			$result = str_pad ($result, $width, "0", STR_PAD_LEFT);
+
+		return $result;
+	}
+
+	function counter ($step)
+	{
+		static $count = 0;
+		$count += $step;
+		return $count;
+	}
+
+	var_dump (format (255, "hex"));
+	var_dump (format (255, "oct"));
+	var_dump (format (255, "hex", 4));
+	var_dump (format (255, "dec", 12));
+
+	$mode = "hex";
+	if (count ($argv) > 5)
+		$mode = "oct";
+	var_dump (format (100, $mode));
+
+	// Statics are shared between calls, so these can't be cloned.
+	var_dump (counter (1), counter (2), counter (1));
+
+	// Clones show the original name in backtraces, and don't replace
+	// functions which already have their name.
+	function caller_name ()
+	{
+		$trace = debug_backtrace ();
+		return $trace[1]["function"];
+	}
+
+	function named ($mode)
+	{
+		if ($mode == "upper")
+			return strtoupper (caller_name ());
+
+		return caller_name () . $mode;
+	}
+
+	function named__spec0 ()
+	{
+		return "not a clone";
+	}
+
+	var_dump (named ("upper"));
+	var_dump (named ("_suffix"));
+	var_dump (named__spec0 ());
+
+?>
@@ -0,0 +1,85 @@
+<?php
+
+	// Variables which are never references are not looked up in the
+	// points-to graph. Check that each way of making a reference is noticed.
+
+	function inc (&$p)
+	{
+		$p++;
+	}
+
+	class Holder
+	{
+		function __construct (&$p)
+		{
+			$this->p =& $p;
+		}
+
+		function inc ()
+		{
+			$this->p++;
+		}
+	}
+
+	class Old_holder
+	{
+		function Old_holder (&$p)
+		{
+			$p = "old";
+		}
+	}
+
+	function f ($a)
+	{
+		$plain = $a;
+		$plain = $plain + 1;
+
+		// By-ref parameter
+		$by_ref = 1;
+		inc ($by_ref);
+
+		// By-ref constructor parameter
+		$ctor = 1;
+		$holder = new Holder ($ctor);
+		$holder->inc ();
+		$old = 1;
+		new Old_holder ($old);
+
+		// Reference assignment
+		$r1 = 2;
+		$r2 =& $r1;
+		$r2 = 3;
+
+		// Reference into an array
+		$elem = 4;
+		$arr = array ();
+		$arr[] =& $elem;
+		$arr[0] = 5;
+
+		// Foreach by reference
+		$list = array (1, 2, 3);
+		foreach ($list as &$item)
+			$item *= 2;
+
+		// Global
+		global $g;
+		$g = 6;
+
+		// Static
+		static $count = 0;
+		$count++;
+
+		var_dump ($plain, $by_ref, $ctor, $old, $r1, $r2, $elem, $arr, $list, $count);
+	}
+
+	$g = 0;
+	$m1 = 7;
+	$m2 =& $m1;
+	$m2 = 8;
+
+	f (10);
+	f (20);
+
+	var_dump ($g, $m1, $m2);
+
+?>